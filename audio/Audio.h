@@ -21,48 +21,82 @@
 #ifndef SDL_AUDIO_AUDIO_H
 #define SDL_AUDIO_AUDIO_H
 
+#include <algorithm>
 #include <string>
 #include <stdexcept>
 
+#include <boost/shared_ptr.hpp>
+
 #include <SDL.h>
 
 #include "sdlpp/subsystem/Subsystem.h"
 #include "sdlpp/audio/Wav.h"
+#include "sdlpp/audio/Sample.h"
+#include "sdlpp/audio/Mixer.h"
+#include "sdlpp/audio/SampleCache.h"
+#include "sdlpp/audio/WavStream.h"
+#include "sdlpp/audio/CallbackStats.h"
+#include "sdlpp/audio/Latency.h"
 
 namespace sdl {
 namespace audio {
     /*
      * @class Audio
      * @brief Represents the audio system.
+     *
+     * Opens the device for signed 16 bit output and fills it from a Mixer on the audio thread.
+     * SDL converts to whatever the hardware wants, so the Mixer always sees the requested format.
+     * Every callback is timed against its buffer's deadline, see stats. Opened for a Latency,
+     * the buffer is negotiated with the driver and, once per frame through adapt, resized to
+     * the smallest size that plays without underruns.
      */
     class Audio {
         public:
             /**
-             * Opens the audio system.
+             * Opens the audio system and starts playback.
              *
-             * @param freq The audio frequenct in samples per second.
-             * @param format The audio data format.
-             * @param channels The number of audio channels.
-             * @param silence The audio buffer silence value.
-             * @param samples The audio buffer size in samples.
-             * @param size The audio buffer size in bytes.
+             * @param freq The audio frequency in samples per second.
+             * @param channels The number of audio channels, 1 or 2.
+             * @param samples The audio buffer size in samples, a power of two.
+             * @param voices The largest number of voices playing at once.
+             * @param cacheBytes The maximum number of bytes of converted Wavs to hold.
+             * @param buses The number of Mixer buses, each with its own EffectChain.
              *
              * @throw runtime_error Throws a runtime_error if the audio could not be opened.
              */
-            Audio (int freq, unsigned short format, unsigned char channels, unsigned char silence, unsigned short samples, unsigned int size)
-              : obtained_ () {
-                SDL_AudioSpec desired;
-                desired.freq = freq;
-                desired.format = format;
-                desired.channels = channels;
-                //desired.silence = silence;
-                desired.samples = samples;
-                //desired.size = size;
-                //desired.callback = mix;
-                desired.userdata = 0;
-
-                if (SDL_OpenAudio (&desired, &obtained_) == -1)
-                    throw runtime_error ("Failed to open audio.");
+            Audio (int freq, unsigned char channels, unsigned short samples, unsigned int voices = 32, size_t cacheBytes = 16 << 20, unsigned int buses = 1)
+              : mixer_ (freq, channels, voices, 256, buses), cache_ (freq, channels, cacheBytes), obtained_ (), stats_ (freq, samples),
+                minSamples_ (samples), maxSamples_ (samples), unstable_ (0), reopens_ (0) {
+                if (!open (freq, channels, samples))
+                    throw runtime_error (SDL_GetError ());
+                SDL_PauseAudio (0);
+             };
+
+            /**
+             * Opens the audio system for a target latency and starts playback. The target buffer
+             * size is tried first, then each next power of two up to the largest allowed.
+             *
+             * @param freq The audio frequency in samples per second.
+             * @param channels The number of audio channels, 1 or 2.
+             * @param latency The target latency.
+             * @param voices The largest number of voices playing at once.
+             * @param cacheBytes The maximum number of bytes of converted Wavs to hold.
+             * @param buses The number of Mixer buses, each with its own EffectChain.
+             *
+             * @throw runtime_error Throws a runtime_error if the audio could not be opened at any allowed size.
+             */
+            Audio (int freq, unsigned char channels, const Latency& latency, unsigned int voices = 32, size_t cacheBytes = 16 << 20, unsigned int buses = 1)
+              : mixer_ (freq, channels, voices, 256, buses), cache_ (freq, channels, cacheBytes), obtained_ (), stats_ (freq, latency.samples (freq)),
+                minSamples_ (0), maxSamples_ (latency.maxSamples_), unstable_ (0), reopens_ (0) {
+                unsigned int samples = latency.samples (freq);
+                while (!open (freq, channels, samples)) {
+                    samples *= 2;
+                    if (samples > maxSamples_)
+                        throw runtime_error (SDL_GetError ());
+                }
+                minSamples_ = obtained_.samples;
+                if (!latency.adaptive_)
+                    maxSamples_ = minSamples_;
                 SDL_PauseAudio (0);
              };
 
@@ -98,31 +132,206 @@ namespace audio {
              * @return True if successful, false otherwise.
              */
             bool play () {
+                stats_.rearm ();
                 SDL_PauseAudio (0);
                 return isPlaying ();
             };
 
             /**
-             * Plays a Wav.
+             * Plays a Wav, converting it to the output format on first play only.
+             *
+             * @param wav The Wav to play.
+             * @param gain The gain, 1 for unchanged.
+             * @param pan The pan, from -1 for left to 1 for right.
+             * @param loop Whether or not to loop the Wav until stopped.
+             *
+             * @return The voice, 0 if the Mixer's command queue is full.
+             *
+             * @throw runtime_error Throws a runtime_error if the Wav cannot be converted.
+             */
+            Mixer::VoiceId play (const Wav& wav, float gain = 1.0f, float pan = 0.0f, bool loop = false) {
+                return mixer_.play (cache_.get (wav), gain, pan, loop);
+            };
+
+            /**
+             * Plays a Sample.
+             *
+             * @param sample The Sample, at the output frequency.
+             * @param gain The gain, 1 for unchanged.
+             * @param pan The pan, from -1 for left to 1 for right.
+             * @param loop Whether or not to loop the Sample until stopped.
+             *
+             * @return The voice, 0 if the Mixer's command queue is full.
+             */
+            Mixer::VoiceId play (const Sample& sample, float gain = 1.0f, float pan = 0.0f, bool loop = false) {
+                return mixer_.play (sample, gain, pan, loop);
+            };
+
+            /**
+             * Plays a Wav at a position, converting it to the output format on first play only.
              *
              * @param wav The Wav to play.
+             * @param x The x coordinate of the position.
+             * @param y The y coordinate of the position.
+             * @param z The z coordinate of the position.
+             * @param gain The gain at or within the Listener's near distance, 1 for unchanged.
+             * @param loop Whether or not to loop the Wav until stopped.
+             *
+             * @return The voice, 0 if the Mixer's command queue is full.
+             *
+             * @throw runtime_error Throws a runtime_error if the Wav cannot be converted.
+             */
+            Mixer::VoiceId playAt (const Wav& wav, float x, float y, float z, float gain = 1.0f, bool loop = false) {
+                return mixer_.playAt (cache_.get (wav), x, y, z, gain, loop);
+            };
+
+            /**
+             * Plays a Sample at a position.
+             *
+             * @param sample The Sample, at the output frequency.
+             * @param x The x coordinate of the position.
+             * @param y The y coordinate of the position.
+             * @param z The z coordinate of the position.
+             * @param gain The gain at or within the Listener's near distance, 1 for unchanged.
+             * @param loop Whether or not to loop the Sample until stopped.
+             *
+             * @return The voice, 0 if the Mixer's command queue is full.
+             */
+            Mixer::VoiceId playAt (const Sample& sample, float x, float y, float z, float gain = 1.0f, bool loop = false) {
+                return mixer_.playAt (sample, x, y, z, gain, loop);
+            };
+
+            /**
+             * Plays a WavStream from its current position.
+             *
+             * @param stream The WavStream, at the output frequency.
+             * @param gain The gain, 1 for unchanged.
+             * @param pan The pan, from -1 for left to 1 for right.
+             * @param loop Whether or not to loop the WavStream until stopped.
+             *
+             * @return The voice, 0 if the Mixer's command queue is full.
+             *
+             * @throw runtime_error Throws a runtime_error if the WavStream is not at the output frequency.
+             */
+            Mixer::VoiceId play (const boost::shared_ptr<WavStream>& stream, float gain = 1.0f, float pan = 0.0f, bool loop = false) {
+                return mixer_.play (stream, gain, pan, loop);
+            };
+
+            /**
+             * Opens a wav file for streaming in the output format.
+             *
+             * @param fileName The name of the wav file.
+             * @param seconds The amount of audio to read ahead.
+             *
+             * @return The WavStream.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to open the file or it is not a supported wav file.
+             */
+            boost::shared_ptr<WavStream> stream (const string& fileName, double seconds = 1.0) {
+                return boost::shared_ptr<WavStream> (new WavStream (fileName, obtained_.freq, obtained_.channels, seconds));
+            };
+
+            /**
+             * Returns the Mixer, to control voices and release finished ones once per frame.
+             *
+             * @return The Mixer.
+             */
+            Mixer& mixer () { return mixer_; };
+
+            /**
+             * Returns the cache of converted Wavs, to convert them at load time.
+             *
+             * @return The SampleCache.
+             */
+            SampleCache& cache () { return cache_; };
+
+            /**
+             * Returns the output format, with the buffer size chosen.
+             *
+             * @return The SDL_AudioSpec structure.
+             */
+            const SDL_AudioSpec& spec () const { return obtained_; };
+
+            /**
+             * Closes and reopens the audio system with another buffer size, keeping the Mixer and
+             * its voices, and resumes playback if it was playing. The size is tried first, then
+             * each next power of two up to the largest allowed. Playback skips while the device
+             * is reopened.
+             *
+             * @param samples The audio buffer size in samples, a power of two.
              *
              * @return A reference to this Audio.
+             *
+             * @throw runtime_error Throws a runtime_error if the audio could not be reopened at any allowed size.
+             */
+            Audio& reopen (unsigned short samples) {
+                bool playing = isPlaying ();
+                SDL_CloseAudio ();
+                unsigned int size = samples;
+                while (!open (obtained_.freq, obtained_.channels, size)) {
+                    size *= 2;
+                    if (size > max (static_cast<unsigned int> (samples), maxSamples_))
+                        throw runtime_error (SDL_GetError ());
+                }
+                ++reopens_;
+                if (playing)
+                    SDL_PauseAudio (0);
+                return *this;
+            };
+
+            /**
+             * Resizes the buffer to the callback's needs, once per frame. Any underrun doubles the
+             * buffer and marks the old size unstable. After settling for a while without underruns,
+             * with every callback within a comfortable share of its deadline, the buffer is halved,
+             * though never below the target size nor down to a size found unstable. Does nothing
+             * unless opened for an adaptive Latency.
+             *
+             * @param settle The time to play at a size before halving it, in seconds.
+             * @param comfortable The largest share of its deadline a callback may use for the buffer to be halved.
+             *
+             * @return True if the buffer was resized, false otherwise.
+             *
+             * @throw runtime_error Throws a runtime_error if the audio could not be reopened at any allowed size.
+             */
+            bool adapt (double settle = 5.0, double comfortable = 0.25) {
+                unsigned int samples = obtained_.samples;
+                if (minSamples_ == maxSamples_)
+                    return false;
+                if (stats_.underruns () != 0) {
+                    unstable_ = max (unstable_, samples);
+                    if (samples * 2 > maxSamples_)
+                        return false;
+                    reopen (static_cast<unsigned short> (samples * 2));
+                    return true;
+                }
+                if (samples / 2 < minSamples_ || samples / 2 <= unstable_ || stats_.callbacks () * stats_.deadline () < settle
+                    || stats_.peakLoad () > comfortable)
+                    return false;
+                reopen (static_cast<unsigned short> (samples / 2));
+                return true;
+            };
+
+            /**
+             * Returns the number of times the audio system was reopened.
+             *
+             * @return The number of reopens.
              */
-            Audio& play (Wav& wav) {
-                /*SDL_LoadWAV (wav.name_.c_str (), obtained_, &wav.audioBuf_, &wav.audioLen_);
-                SDL_AudioCVT cvt;
-                SDL_BuildAudioCVT (&cvt, obtained_->format, obtained_->channels, obtained_->freq, AUDIO_S8, 1, 11000);
-                cvt.buf = (Uint8*)malloc (wav.audioLen_ * cvt.len_mult);
-                memcpy (cvt.buf, wav.audioBuf_, wav.audioLen_);
-                cvt.len = wav.audioLen_;
-                SDL_ConvertAudio (&cvt);
-                SDL_FreeWAV (wav.audioBuf_);
+            unsigned int reopens () const { return reopens_; };
 
-                wav.audioBuf_ = cvt.buf;
-                wav.audioLen_ = cvt.len_cvt;
+            /**
+             * Returns the timings of the audio callback, readable from any thread without locking.
+             *
+             * @return The CallbackStats.
+             */
+            const CallbackStats& stats () const { return stats_; };
 
-                SDL_PauseAudio (0);*/
+            /**
+             * Clears the timings of the audio callback.
+             *
+             * @return A reference to this Audio.
+             */
+            Audio& resetStats () {
+                stats_.reset ();
                 return *this;
             };
 
@@ -173,11 +382,85 @@ namespace audio {
              */
             Audio& operator= (const Audio& rhs);
 
+            /**
+             * Opens the audio device paused, filled from the Mixer.
+             *
+             * @param freq The audio frequency in samples per second.
+             * @param channels The number of audio channels.
+             * @param samples The audio buffer size in samples.
+             *
+             * @return True if successful, false otherwise.
+             */
+            bool open (int freq, unsigned char channels, unsigned int samples) {
+                SDL_AudioSpec desired;
+                desired.freq = freq;
+                desired.format = AUDIO_S16SYS;
+                desired.channels = channels;
+                desired.samples = static_cast<Uint16> (samples);
+                desired.callback = &Audio::callback;
+                desired.userdata = this;
+
+                if (SDL_OpenAudio (&desired, NULL) == -1)
+                    return false;
+                obtained_ = desired;
+                stats_.configure (obtained_.freq, obtained_.samples);
+                return true;
+            };
+
+            /**
+             * Fills an SDL audio buffer from the Mixer, timing the fill.
+             *
+             * @param userdata The Audio.
+             * @param stream The buffer.
+             * @param len The size of the buffer in bytes.
+             */
+            static void callback (void* userdata, Uint8* stream, int len) {
+                Audio* audio = static_cast<Audio*> (userdata);
+                double start = audio->stats_.begin ();
+                Mixer::callback (&audio->mixer_, stream, len);
+                audio->stats_.end (start);
+            };
+
         private:
+            /**
+             * The Mixer filling the output.
+             */
+            Mixer mixer_;
+
+            /**
+             * The converted Wavs.
+             */
+            SampleCache cache_;
+
             /*
              * The SDL_AudioSpec structure.
              */
             SDL_AudioSpec obtained_;
+
+            /**
+             * The timings of the audio callback.
+             */
+            CallbackStats stats_;
+
+            /**
+             * The smallest buffer size adapt may choose.
+             */
+            unsigned int minSamples_;
+
+            /**
+             * The largest buffer size adapt may choose.
+             */
+            unsigned int maxSamples_;
+
+            /**
+             * The largest buffer size found to underrun.
+             */
+            unsigned int unstable_;
+
+            /**
+             * The number of times the audio system was reopened.
+             */
+            unsigned int reopens_;
     }; //Audio
 }; //audio
 }; //sdl
@@ -0,0 +1,307 @@
+/**
+ * @file Biquad.h
+ * Contains the Biquad class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_BIQUAD_H
+#define SDL_AUDIO_BIQUAD_H
+
+#include <algorithm>
+#include <cmath>
+
+#include <SDL.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "sdlpp/audio/Effect.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @class Biquad
+     * @brief A second order filter: low or high pass, band pass, peaking or shelving EQ.
+     *
+     * The coefficients follow the well known cookbook formulas and are recomputed once per block
+     * while the frequency, Q or gain glide to new values, so sweeps do not click. The filter runs
+     * in transposed direct form II with both channels in one SSE2 register; without SSE2 each
+     * channel runs the same operations in turn, giving identical output.
+     */
+    class Biquad : public Effect {
+        public:
+            /**
+             * @enum Type
+             * @brief The response of the filter.
+             */
+            enum Type {
+                LOW_PASS,
+                HIGH_PASS,
+                BAND_PASS,
+                PEAK,
+                LOW_SHELF,
+                HIGH_SHELF
+            };
+
+            /**
+             * Constructs a Biquad.
+             *
+             * @param type The response.
+             * @param frequency The cutoff or centre frequency in Hz.
+             * @param q The Q, 0.7071 for a maximally flat pass or shelf.
+             * @param gain The boost or cut of a peak or shelf in dB.
+             */
+            Biquad (Type type, float frequency, float q = 0.7071f, float gain = 0.0f)
+              : type_ (type), frequency_ (frequency), q_ (q), gain_ (gain), rate_ (44100), channels_ (2), glide_ (1.0f),
+                b0_ (1.0f), b1_ (0.0f), b2_ (0.0f), a1_ (0.0f), a2_ (0.0f) {
+                reset ();
+            };
+
+            /**
+             * Returns the cutoff or centre frequency, in Hz.
+             *
+             * @return The Parameter.
+             */
+            Parameter& frequency () { return frequency_; };
+
+            /**
+             * Returns the Q.
+             *
+             * @return The Parameter.
+             */
+            Parameter& q () { return q_; };
+
+            /**
+             * Returns the boost or cut of a peak or shelf, in dB.
+             *
+             * @return The Parameter.
+             */
+            Parameter& gain () { return gain_; };
+
+            /**
+             * Returns the response of the filter.
+             *
+             * @return The Type.
+             */
+            Type type () const { return type_; };
+
+            /**
+             * Readies the Biquad for a format.
+             *
+             * @param rate The rate in frames per second.
+             * @param channels The number of interleaved channels, 1 or 2.
+             * @param block The largest number of frames passed to process.
+             */
+            virtual void prepare (int rate, int channels, unsigned int block) {
+                rate_ = rate;
+                channels_ = channels;
+                glide_ = glide (rate, block, 0.01);
+                reset ();
+            };
+
+            /**
+             * Filters a block in place.
+             *
+             * @param samples The interleaved samples.
+             * @param frames The number of frames.
+             */
+            virtual void process (float* samples, unsigned int frames) {
+                bool changed = frequency_.smooth (glide_);
+                changed = q_.smooth (glide_) || changed;
+                changed = gain_.smooth (glide_) || changed;
+                if (changed)
+                    design ();
+#ifdef __SSE2__
+                const __m128 b0 = _mm_set1_ps (b0_), b1 = _mm_set1_ps (b1_), b2 = _mm_set1_ps (b2_), a1 = _mm_set1_ps (a1_), a2 = _mm_set1_ps (a2_);
+                __m128 z1 = _mm_setr_ps (z1_[0], z1_[1], 0.0f, 0.0f), z2 = _mm_setr_ps (z2_[0], z2_[1], 0.0f, 0.0f);
+                if (channels_ == 2) {
+                    for (unsigned int i = 0; i < frames; ++i) {
+                        __m64* s = reinterpret_cast<__m64*> (samples + 2 * i);
+                        __m128 x = _mm_loadl_pi (_mm_setzero_ps (), s);
+                        __m128 y = _mm_add_ps (_mm_mul_ps (b0, x), z1);
+                        z1 = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (b1, x), _mm_mul_ps (a1, y)), z2);
+                        z2 = _mm_sub_ps (_mm_mul_ps (b2, x), _mm_mul_ps (a2, y));
+                        _mm_storel_pi (s, y);
+                    }
+                } else {
+                    for (unsigned int i = 0; i < frames; ++i) {
+                        __m128 x = _mm_load_ss (samples + i);
+                        __m128 y = _mm_add_ss (_mm_mul_ss (b0, x), z1);
+                        z1 = _mm_add_ss (_mm_sub_ss (_mm_mul_ss (b1, x), _mm_mul_ss (a1, y)), z2);
+                        z2 = _mm_sub_ss (_mm_mul_ss (b2, x), _mm_mul_ss (a2, y));
+                        _mm_store_ss (samples + i, y);
+                    }
+                }
+                float state[4];
+                _mm_storeu_ps (state, z1);
+                z1_[0] = state[0];
+                z1_[1] = state[1];
+                _mm_storeu_ps (state, z2);
+                z2_[0] = state[0];
+                z2_[1] = state[1];
+#else
+                for (int c = 0; c < channels_; ++c) {
+                    float z1 = z1_[c], z2 = z2_[c];
+                    for (unsigned int i = 0; i < frames; ++i) {
+                        float x = samples[i * channels_ + c];
+                        float y = b0_ * x + z1;
+                        z1 = (b1_ * x - a1_ * y) + z2;
+                        z2 = b2_ * x - a2_ * y;
+                        samples[i * channels_ + c] = y;
+                    }
+                    z1_[c] = z1;
+                    z2_[c] = z2;
+                }
+#endif
+                for (int c = 0; c < 2; ++c) {
+                    if (fabs (z1_[c]) < 1e-20f)
+                        z1_[c] = 0.0f;
+                    if (fabs (z2_[c]) < 1e-20f)
+                        z2_[c] = 0.0f;
+                }
+            };
+
+            /**
+             * Clears the filter memory and snaps the parameters.
+             */
+            virtual void reset () {
+                z1_[0] = z1_[1] = z2_[0] = z2_[1] = 0.0f;
+                frequency_.snap ();
+                q_.snap ();
+                gain_.snap ();
+                design ();
+            };
+
+        private:
+            /**
+             * Computes the coefficients from the current parameters.
+             */
+            void design () {
+                double f = min (max (static_cast<double> (frequency_.value ()), 10.0), rate_ * 0.49);
+                double w = 2.0 * M_PI * f / rate_;
+                double cosw = cos (w);
+                double alpha = sin (w) / (2.0 * max (static_cast<double> (q_.value ()), 0.01));
+                double A = pow (10.0, gain_.value () / 40.0);
+                double root = 2.0 * sqrt (A) * alpha;
+                double b0, b1, b2, a0, a1, a2;
+                switch (type_) {
+                    case LOW_PASS:
+                        b0 = b2 = (1.0 - cosw) / 2.0;
+                        b1 = 1.0 - cosw;
+                        a0 = 1.0 + alpha;
+                        a1 = -2.0 * cosw;
+                        a2 = 1.0 - alpha;
+                        break;
+                    case HIGH_PASS:
+                        b0 = b2 = (1.0 + cosw) / 2.0;
+                        b1 = -(1.0 + cosw);
+                        a0 = 1.0 + alpha;
+                        a1 = -2.0 * cosw;
+                        a2 = 1.0 - alpha;
+                        break;
+                    case BAND_PASS:
+                        b0 = alpha;
+                        b1 = 0.0;
+                        b2 = -alpha;
+                        a0 = 1.0 + alpha;
+                        a1 = -2.0 * cosw;
+                        a2 = 1.0 - alpha;
+                        break;
+                    case PEAK:
+                        b0 = 1.0 + alpha * A;
+                        b1 = -2.0 * cosw;
+                        b2 = 1.0 - alpha * A;
+                        a0 = 1.0 + alpha / A;
+                        a1 = -2.0 * cosw;
+                        a2 = 1.0 - alpha / A;
+                        break;
+                    case LOW_SHELF:
+                        b0 = A * ((A + 1.0) - (A - 1.0) * cosw + root);
+                        b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosw);
+                        b2 = A * ((A + 1.0) - (A - 1.0) * cosw - root);
+                        a0 = (A + 1.0) + (A - 1.0) * cosw + root;
+                        a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosw);
+                        a2 = (A + 1.0) + (A - 1.0) * cosw - root;
+                        break;
+                    default:
+                        b0 = A * ((A + 1.0) + (A - 1.0) * cosw + root);
+                        b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw);
+                        b2 = A * ((A + 1.0) + (A - 1.0) * cosw - root);
+                        a0 = (A + 1.0) - (A - 1.0) * cosw + root;
+                        a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosw);
+                        a2 = (A + 1.0) - (A - 1.0) * cosw - root;
+                        break;
+                }
+                b0_ = static_cast<float> (b0 / a0);
+                b1_ = static_cast<float> (b1 / a0);
+                b2_ = static_cast<float> (b2 / a0);
+                a1_ = static_cast<float> (a1 / a0);
+                a2_ = static_cast<float> (a2 / a0);
+            };
+
+            /**
+             * The response.
+             */
+            Type type_;
+
+            /**
+             * The cutoff or centre frequency in Hz.
+             */
+            Parameter frequency_;
+
+            /**
+             * The Q.
+             */
+            Parameter q_;
+
+            /**
+             * The boost or cut of a peak or shelf in dB.
+             */
+            Parameter gain_;
+
+            /**
+             * The rate.
+             */
+            int rate_;
+
+            /**
+             * The number of channels.
+             */
+            int channels_;
+
+            /**
+             * The per block share by which the parameters glide.
+             */
+            float glide_;
+
+            /**
+             * The coefficients, normalized so a0 is 1.
+             */
+            float b0_, b1_, b2_, a1_, a2_;
+
+            /**
+             * The filter memory of each channel.
+             */
+            float z1_[2], z2_[2];
+    }; //Biquad
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_BIQUAD_H
@@ -0,0 +1,332 @@
+/**
+ * @file CallbackStats.h
+ * Contains the CallbackStats class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_CALLBACKSTATS_H
+#define SDL_AUDIO_CALLBACKSTATS_H
+
+#include <algorithm>
+#include <atomic>
+
+#include <SDL.h>
+
+#include "sdlpp/misc/Clock.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+    using namespace misc;
+
+    /**
+     * @class CallbackStats
+     * @brief Measures the audio callback against the time it has to fill its buffer.
+     *
+     * The audio thread brackets each callback with begin and end. Each buffer of samples / freq
+     * seconds is the deadline for computing the next; a callback taking longer is an overrun.
+     * Playback is modelled as a queue holding the latency worth of audio, full when playback
+     * starts, drained in real time and refilled by each callback, and an underrun is counted
+     * whenever the queue would have run dry since the previous callback, whether the callback
+     * itself was slow or the thread was scheduled late, after which the device is taken to
+     * restart full, as drivers do on recovering. The latency is estimated from the
+     * obtained spec as SDL's mix buffer plus one device buffer of the same size. Every figure is
+     * an atomic written only by the audio thread, so any thread can read them without locking
+     * the audio; figures read one after the other may straddle a callback.
+     */
+    class CallbackStats {
+        public:
+            /**
+             * Constructs a CallbackStats.
+             *
+             * @param freq The audio frequency in samples per second.
+             * @param samples The audio buffer size in samples.
+             */
+            CallbackStats (int freq, unsigned int samples)
+              : deadline_ (0.0), latency_ (0.0), callbacks_ (0), overruns_ (0), underruns_ (0), starved_ (0.0),
+                last_ (0.0), total_ (0.0), max_ (0.0), rearm_ (true), reset_ (false), previous_ (0.0), queued_ (0.0) {
+                configure (freq, samples);
+            };
+
+            /**
+             * Sets the buffer the callback fills, from the obtained spec, and clears the figures.
+             * Called only while the callback is not running, as when the device is closed.
+             *
+             * @param freq The audio frequency in samples per second.
+             * @param samples The audio buffer size in samples.
+             *
+             * @return A reference to this CallbackStats.
+             */
+            CallbackStats& configure (int freq, unsigned int samples) {
+                double deadline = freq > 0 ? static_cast<double> (samples) / freq : 0.0;
+                deadline_.store (deadline);
+                latency_.store (2.0 * deadline);
+                clear ();
+                reset_.store (false);
+                rearm_.store (true);
+                return *this;
+            };
+
+            /**
+             * Marks the start of a callback. Called from the audio thread.
+             *
+             * @return The start time, to pass to end.
+             */
+            double begin () {
+                if (reset_.exchange (false))
+                    clear ();
+                return Clock::now ();
+            };
+
+            /**
+             * Marks the end of a callback. Called from the audio thread.
+             *
+             * @param start The start time returned by begin.
+             */
+            void end (double start) {
+                double now = Clock::now ();
+                double took = now - start;
+                double deadline = deadline_.load (memory_order_relaxed);
+                double latency = latency_.load (memory_order_relaxed);
+                if (rearm_.exchange (false)) {
+                    queued_ = latency;
+                } else {
+                    queued_ -= now - previous_;
+                    if (queued_ < 0.0) {
+                        underruns_.fetch_add (1, memory_order_relaxed);
+                        starved_.store (starved_.load (memory_order_relaxed) - queued_, memory_order_relaxed);
+                        queued_ = latency;
+                    }
+                }
+                queued_ = min (queued_ + deadline, latency);
+                previous_ = now;
+
+                if (took > deadline)
+                    overruns_.fetch_add (1, memory_order_relaxed);
+                last_.store (took, memory_order_relaxed);
+                total_.store (total_.load (memory_order_relaxed) + took, memory_order_relaxed);
+                if (took > max_.load (memory_order_relaxed))
+                    max_.store (took, memory_order_relaxed);
+                callbacks_.fetch_add (1, memory_order_release);
+            };
+
+            /**
+             * Forgets the time of the previous callback, so a pause or a reopen is not counted as
+             * an underrun. Called from any thread.
+             *
+             * @return A reference to this CallbackStats.
+             */
+            CallbackStats& rearm () {
+                rearm_.store (true);
+                return *this;
+            };
+
+            /**
+             * Clears the figures at the start of the next callback. Called from any thread.
+             *
+             * @return A reference to this CallbackStats.
+             */
+            CallbackStats& reset () {
+                reset_.store (true);
+                return rearm ();
+            };
+
+            /**
+             * Returns the number of callbacks measured.
+             *
+             * @return The number of callbacks.
+             */
+            Uint64 callbacks () const { return callbacks_.load (memory_order_acquire); };
+
+            /**
+             * Returns the number of callbacks that took longer than their deadline.
+             *
+             * @return The number of overruns.
+             */
+            Uint64 overruns () const { return overruns_.load (); };
+
+            /**
+             * Returns the number of times the output is estimated to have run dry.
+             *
+             * @return The number of underruns.
+             */
+            Uint64 underruns () const { return underruns_.load (); };
+
+            /**
+             * Returns the total time the output is estimated to have played silence from underruns.
+             *
+             * @return The time in seconds.
+             */
+            double starved () const { return starved_.load (); };
+
+            /**
+             * Returns the time each callback has to fill its buffer.
+             *
+             * @return The deadline in seconds.
+             */
+            double deadline () const { return deadline_.load (); };
+
+            /**
+             * Returns the estimated time from a callback filling its buffer to the buffer being heard.
+             *
+             * @return The latency in seconds.
+             */
+            double latency () const { return latency_.load (); };
+
+            /**
+             * Returns the duration of the last callback.
+             *
+             * @return The duration in seconds.
+             */
+            double last () const { return last_.load (); };
+
+            /**
+             * Returns the mean duration of a callback.
+             *
+             * @return The duration in seconds, 0 before the first callback.
+             */
+            double mean () const {
+                Uint64 count = callbacks ();
+                return count == 0 ? 0.0 : total_.load () / count;
+            };
+
+            /**
+             * Returns the longest duration of a callback.
+             *
+             * @return The duration in seconds.
+             */
+            double max () const { return max_.load (); };
+
+            /**
+             * Returns the mean share of the deadline the callback uses.
+             *
+             * @return The load, 1 for a callback that takes all of its deadline.
+             */
+            double load () const {
+                double deadline = deadline_.load ();
+                return deadline == 0.0 ? 0.0 : mean () / deadline;
+            };
+
+            /**
+             * Returns the largest share of the deadline a callback has used.
+             *
+             * @return The load, above 1 once a callback has overrun.
+             */
+            double peakLoad () const {
+                double deadline = deadline_.load ();
+                return deadline == 0.0 ? 0.0 : max_.load () / deadline;
+            };
+
+        private:
+            /**
+             * Copy constructs a CallbackStats.
+             *
+             * @param rhs The CallbackStats to copy.
+             */
+            CallbackStats (const CallbackStats& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The CallbackStats from which to assign.
+             *
+             * @return A reference to this CallbackStats.
+             */
+            CallbackStats& operator= (const CallbackStats& rhs);
+
+            /**
+             * Zeroes the figures.
+             */
+            void clear () {
+                callbacks_.store (0);
+                overruns_.store (0);
+                underruns_.store (0);
+                starved_.store (0.0);
+                last_.store (0.0);
+                total_.store (0.0);
+                max_.store (0.0);
+            };
+
+            /**
+             * The time each callback has to fill its buffer.
+             */
+            atomic<double> deadline_;
+
+            /**
+             * The estimated output latency.
+             */
+            atomic<double> latency_;
+
+            /**
+             * The number of callbacks measured.
+             */
+            atomic<Uint64> callbacks_;
+
+            /**
+             * The number of callbacks that took longer than their deadline.
+             */
+            atomic<Uint64> overruns_;
+
+            /**
+             * The number of times the output is estimated to have run dry.
+             */
+            atomic<Uint64> underruns_;
+
+            /**
+             * The total time the output is estimated to have run dry.
+             */
+            atomic<double> starved_;
+
+            /**
+             * The duration of the last callback.
+             */
+            atomic<double> last_;
+
+            /**
+             * The total duration of the callbacks measured.
+             */
+            atomic<double> total_;
+
+            /**
+             * The longest duration of a callback.
+             */
+            atomic<double> max_;
+
+            /**
+             * Whether or not the next callback starts a new run of the playback model.
+             */
+            atomic<bool> rearm_;
+
+            /**
+             * Whether or not the next callback clears the figures.
+             */
+            atomic<bool> reset_;
+
+            /**
+             * The end time of the previous callback, used by the audio thread only.
+             */
+            double previous_;
+
+            /**
+             * The audio estimated to be queued for playback, used by the audio thread only.
+             */
+            double queued_;
+    }; //CallbackStats
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_CALLBACKSTATS_H
@@ -0,0 +1,264 @@
+/**
+ * @file Compressor.h
+ * Contains the Compressor class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_COMPRESSOR_H
+#define SDL_AUDIO_COMPRESSOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <SDL.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "sdlpp/audio/Effect.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @class Compressor
+     * @brief Reduces the level of audio above a threshold, or limits it with a high ratio.
+     *
+     * The detector follows the peak of each block across all channels, rising at the attack
+     * rate and falling at the release rate, and the gain reduction it calls for is reached by a
+     * linear ramp across the block. The peak search and the gain ramp run four samples at a time
+     * with SSE2, giving the same output as without. A ratio of 100 or more makes a limiter.
+     */
+    class Compressor : public Effect {
+        public:
+            /**
+             * Constructs a Compressor.
+             *
+             * @param threshold The level above which to compress, in dB below full scale.
+             * @param ratio The input level change in dB per dB of output above the threshold.
+             * @param attack The time to react to a rise in level, in seconds.
+             * @param release The time to recover from a fall in level, in seconds.
+             * @param makeup The gain applied after compression, in dB.
+             */
+            Compressor (float threshold = -12.0f, float ratio = 4.0f, float attack = 0.005f, float release = 0.1f, float makeup = 0.0f)
+              : threshold_ (threshold), ratio_ (ratio), attack_ (attack), release_ (release), makeup_ (makeup), reduction_ (0.0f),
+                rate_ (44100), channels_ (2), glide_ (1.0f), envelope_ (0.0f), gain_ (1.0f) {
+                reset ();
+            };
+
+            /**
+             * Returns the threshold, in dB below full scale.
+             *
+             * @return The Parameter.
+             */
+            Parameter& threshold () { return threshold_; };
+
+            /**
+             * Returns the ratio.
+             *
+             * @return The Parameter.
+             */
+            Parameter& ratio () { return ratio_; };
+
+            /**
+             * Returns the attack time, in seconds.
+             *
+             * @return The Parameter.
+             */
+            Parameter& attack () { return attack_; };
+
+            /**
+             * Returns the release time, in seconds.
+             *
+             * @return The Parameter.
+             */
+            Parameter& release () { return release_; };
+
+            /**
+             * Returns the makeup gain, in dB.
+             *
+             * @return The Parameter.
+             */
+            Parameter& makeup () { return makeup_; };
+
+            /**
+             * Returns the gain reduction of the last block, for metering from any thread.
+             *
+             * @return The reduction in dB, 0 or more.
+             */
+            float reduction () const { return reduction_.load (memory_order_relaxed); };
+
+            /**
+             * Readies the Compressor for a format.
+             *
+             * @param rate The rate in frames per second.
+             * @param channels The number of interleaved channels, 1 or 2.
+             * @param block The largest number of frames passed to process.
+             */
+            virtual void prepare (int rate, int channels, unsigned int block) {
+                rate_ = rate;
+                channels_ = channels;
+                glide_ = glide (rate, block, 0.01);
+                reset ();
+            };
+
+            /**
+             * Compresses a block in place.
+             *
+             * @param samples The interleaved samples.
+             * @param frames The number of frames.
+             */
+            virtual void process (float* samples, unsigned int frames) {
+                threshold_.smooth (glide_);
+                ratio_.smooth (glide_);
+                attack_.smooth (glide_);
+                release_.smooth (glide_);
+                makeup_.smooth (glide_);
+                unsigned int count = frames * channels_;
+
+                float level = peak (samples, count);
+                float time = max (level > envelope_ ? attack_.value () : release_.value (), 1e-4f);
+                envelope_ += (level - envelope_) * static_cast<float> (1.0 - exp (-static_cast<double> (frames) / (rate_ * time)));
+                float over = 20.0f * log10 (max (envelope_, 1e-9f)) - threshold_.value ();
+                float reduction = over > 0.0f ? over * (1.0f - 1.0f / max (ratio_.value (), 1.0f)) : 0.0f;
+                float target = pow (10.0f, (makeup_.value () - reduction) / 20.0f);
+                reduction_.store (reduction, memory_order_relaxed);
+
+                float step = (target - gain_) / frames;
+                unsigned int i = 0;
+#ifdef __SSE2__
+                const __m128 g0 = _mm_set1_ps (gain_), s = _mm_set1_ps (step);
+                if (channels_ == 2) {
+                    for (; i + 4 <= count; i += 4) {
+                        float frame = static_cast<float> (i / 2);
+                        __m128 index = _mm_setr_ps (frame, frame, frame + 1.0f, frame + 1.0f);
+                        _mm_storeu_ps (samples + i, _mm_mul_ps (_mm_loadu_ps (samples + i), _mm_add_ps (g0, _mm_mul_ps (s, index))));
+                    }
+                } else {
+                    for (; i + 4 <= count; i += 4) {
+                        float frame = static_cast<float> (i);
+                        __m128 index = _mm_setr_ps (frame, frame + 1.0f, frame + 2.0f, frame + 3.0f);
+                        _mm_storeu_ps (samples + i, _mm_mul_ps (_mm_loadu_ps (samples + i), _mm_add_ps (g0, _mm_mul_ps (s, index))));
+                    }
+                }
+#endif
+                for (; i < count; ++i)
+                    samples[i] *= gain_ + step * static_cast<float> (i / channels_);
+                gain_ = target;
+            };
+
+            /**
+             * Clears the detector and snaps the parameters.
+             */
+            virtual void reset () {
+                threshold_.snap ();
+                ratio_.snap ();
+                attack_.snap ();
+                release_.snap ();
+                gain_ = pow (10.0f, makeup_.snap () / 20.0f);
+                envelope_ = 0.0f;
+                reduction_.store (0.0f);
+            };
+
+        private:
+            /**
+             * Finds the largest magnitude among samples.
+             *
+             * @param samples The samples.
+             * @param count The number of samples.
+             *
+             * @return The largest magnitude.
+             */
+            static float peak (const float* samples, unsigned int count) {
+                float level = 0.0f;
+                unsigned int i = 0;
+#ifdef __SSE2__
+                const __m128 magnitude = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+                __m128 most = _mm_setzero_ps ();
+                for (; i + 4 <= count; i += 4)
+                    most = _mm_max_ps (most, _mm_and_ps (_mm_loadu_ps (samples + i), magnitude));
+                most = _mm_max_ps (most, _mm_movehl_ps (most, most));
+                most = _mm_max_ss (most, _mm_shuffle_ps (most, most, 1));
+                level = _mm_cvtss_f32 (most);
+#endif
+                for (; i < count; ++i)
+                    level = max (level, fabs (samples[i]));
+                return level;
+            };
+
+            /**
+             * The threshold in dB.
+             */
+            Parameter threshold_;
+
+            /**
+             * The ratio.
+             */
+            Parameter ratio_;
+
+            /**
+             * The attack time in seconds.
+             */
+            Parameter attack_;
+
+            /**
+             * The release time in seconds.
+             */
+            Parameter release_;
+
+            /**
+             * The makeup gain in dB.
+             */
+            Parameter makeup_;
+
+            /**
+             * The gain reduction of the last block in dB.
+             */
+            atomic<float> reduction_;
+
+            /**
+             * The rate.
+             */
+            int rate_;
+
+            /**
+             * The number of channels.
+             */
+            int channels_;
+
+            /**
+             * The per block share by which the parameters glide.
+             */
+            float glide_;
+
+            /**
+             * The detected level.
+             */
+            float envelope_;
+
+            /**
+             * The gain reached at the end of the last block.
+             */
+            float gain_;
+    }; //Compressor
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_COMPRESSOR_H
@@ -0,0 +1,202 @@
+/**
+ * @file Effect.h
+ * Contains the Effect class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_EFFECT_H
+#define SDL_AUDIO_EFFECT_H
+
+#include <atomic>
+#include <cmath>
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @class Effect
+     * @brief Processes interleaved float audio in place on the audio thread.
+     *
+     * An EffectChain prepares each Effect for its rate and channels on the game thread, where
+     * it may allocate, then calls process on the audio thread a block of at most
+     * EffectChain::BLOCK frames at a time. Parameters are set from the game thread without
+     * locking and glide to their new values over a few milliseconds.
+     */
+    class Effect {
+        public:
+            /**
+             * @class Parameter
+             * @brief A value set by the game thread and followed smoothly by the audio thread.
+             */
+            class Parameter {
+                public:
+                    /**
+                     * Constructs a Parameter.
+                     *
+                     * @param value The initial value.
+                     */
+                    explicit Parameter (float value) : target_ (value), value_ (value) {};
+
+                    /**
+                     * Sets the value to glide to. Called from the game thread.
+                     *
+                     * @param value The value.
+                     *
+                     * @return A reference to this Parameter.
+                     */
+                    Parameter& set (float value) {
+                        target_.store (value, memory_order_relaxed);
+                        return *this;
+                    };
+
+                    /**
+                     * Returns the value being glided to.
+                     *
+                     * @return The value.
+                     */
+                    float get () const { return target_.load (memory_order_relaxed); };
+
+                    /**
+                     * Returns the current value. Called from the audio thread.
+                     *
+                     * @return The value.
+                     */
+                    float value () const { return value_; };
+
+                    /**
+                     * Moves the current value a share of the way to the value set, landing on it once
+                     * close. Called from the audio thread, once per block.
+                     *
+                     * @param amount The share of the remaining distance to move, from 0 to 1.
+                     *
+                     * @return True if the current value changed, false otherwise.
+                     */
+                    bool smooth (float amount) {
+                        float target = target_.load (memory_order_relaxed);
+                        if (value_ == target)
+                            return false;
+                        value_ += (target - value_) * amount;
+                        if (fabs (target - value_) <= 1e-5f * (fabs (target) + 1e-3f))
+                            value_ = target;
+                        return true;
+                    };
+
+                    /**
+                     * Jumps the current value to the value set. Called from the audio thread.
+                     *
+                     * @return The value.
+                     */
+                    float snap () { return value_ = target_.load (memory_order_relaxed); };
+
+                private:
+                    /**
+                     * Copy constructs a Parameter.
+                     *
+                     * @param rhs The Parameter to copy.
+                     */
+                    Parameter (const Parameter& rhs);
+
+                    /**
+                     * The assignment operator.
+                     *
+                     * @param rhs The Parameter from which to assign.
+                     *
+                     * @return A reference to this Parameter.
+                     */
+                    Parameter& operator= (const Parameter& rhs);
+
+                    /**
+                     * The value set by the game thread.
+                     */
+                    atomic<float> target_;
+
+                    /**
+                     * The current value, touched only by the audio thread.
+                     */
+                    float value_;
+            }; //Parameter
+
+            /**
+             * Destroys the Effect.
+             */
+            virtual ~Effect () {};
+
+            /**
+             * Readies the Effect for a format, allocating its state and clearing it. Called from
+             * the game thread before the Effect processes audio.
+             *
+             * @param rate The rate in frames per second.
+             * @param channels The number of interleaved channels, 1 or 2.
+             * @param block The largest number of frames passed to process.
+             */
+            virtual void prepare (int rate, int channels, unsigned int block) = 0;
+
+            /**
+             * Processes a block in place. Called from the audio thread; must neither lock nor allocate.
+             *
+             * @param samples The interleaved samples, nominally from -1 to 1.
+             * @param frames The number of frames, at most the block passed to prepare.
+             */
+            virtual void process (float* samples, unsigned int frames) = 0;
+
+            /**
+             * Clears the state, such as filter memory or reverb tails, and snaps the parameters.
+             * Called when the audio thread is not processing.
+             */
+            virtual void reset () = 0;
+
+        protected:
+            /**
+             * Constructs an Effect.
+             */
+            Effect () {};
+
+            /**
+             * Returns the per block share by which a Parameter glides with a time constant.
+             *
+             * @param rate The rate in frames per second.
+             * @param block The number of frames in a block.
+             * @param seconds The time constant in seconds.
+             *
+             * @return The share, from 0 to 1.
+             */
+            static float glide (int rate, unsigned int block, double seconds) {
+                return static_cast<float> (1.0 - exp (-static_cast<double> (block) / (rate * seconds)));
+            };
+
+        private:
+            /**
+             * Copy constructs an Effect.
+             *
+             * @param rhs The Effect to copy.
+             */
+            Effect (const Effect& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The Effect from which to assign.
+             *
+             * @return A reference to this Effect.
+             */
+            Effect& operator= (const Effect& rhs);
+    }; //Effect
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_EFFECT_H
@@ -0,0 +1,234 @@
+/**
+ * @file EffectChain.h
+ * Contains the EffectChain class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_EFFECTCHAIN_H
+#define SDL_AUDIO_EFFECTCHAIN_H
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/audio/Effect.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @class EffectChain
+     * @brief Runs interleaved float audio through a series of Effects, a fixed size block at a time.
+     *
+     * Each Effect sees blocks of BLOCK frames, so parameters glide and gains are computed at the
+     * same granularity whatever the size of the audio buffer. Effects are added or removed on the
+     * game thread before playback, or with the audio locked; their parameters can be changed at
+     * any time. The chain can be bypassed without locking. render runs the chain over a buffer
+     * offline, to measure it or to check its output.
+     */
+    class EffectChain {
+        public:
+            /**
+             * The number of frames processed per block.
+             */
+            static const unsigned int BLOCK = 64;
+
+            /**
+             * Constructs an empty EffectChain.
+             *
+             * @param rate The rate in frames per second.
+             * @param channels The number of interleaved channels, 1 or 2.
+             */
+            EffectChain (int rate, int channels) : effects_ (), rate_ (rate), channels_ (channels), bypassed_ (false) {};
+
+            /**
+             * Destroys the EffectChain.
+             */
+            ~EffectChain () {};
+
+            /**
+             * Appends an Effect, preparing it for the chain's format.
+             *
+             * @param effect The Effect.
+             *
+             * @return A reference to this EffectChain.
+             */
+            EffectChain& add (const boost::shared_ptr<Effect>& effect) {
+                effect->prepare (rate_, channels_, BLOCK);
+                effects_.push_back (effect);
+                return *this;
+            };
+
+            /**
+             * Removes an Effect.
+             *
+             * @param effect The Effect.
+             *
+             * @return A reference to this EffectChain.
+             */
+            EffectChain& remove (const boost::shared_ptr<Effect>& effect) {
+                effects_.erase (std::remove (effects_.begin (), effects_.end (), effect), effects_.end ());
+                return *this;
+            };
+
+            /**
+             * Removes every Effect.
+             *
+             * @return A reference to this EffectChain.
+             */
+            EffectChain& clear () {
+                effects_.clear ();
+                return *this;
+            };
+
+            /**
+             * Clears the state of every Effect.
+             *
+             * @return A reference to this EffectChain.
+             */
+            EffectChain& reset () {
+                for (vector<boost::shared_ptr<Effect> >::iterator e = effects_.begin (); e != effects_.end (); ++e)
+                    (*e)->reset ();
+                return *this;
+            };
+
+            /**
+             * Bypasses the chain or puts it back in. Called from any thread.
+             *
+             * @param bypassed Whether or not to pass audio through untouched.
+             *
+             * @return A reference to this EffectChain.
+             */
+            EffectChain& bypass (bool bypassed) {
+                bypassed_.store (bypassed);
+                return *this;
+            };
+
+            /**
+             * Determines if the chain is bypassed.
+             *
+             * @return True if bypassed, false otherwise.
+             */
+            bool bypassed () const { return bypassed_.load (); };
+
+            /**
+             * Determines if the chain would change the audio.
+             *
+             * @return True if it holds Effects and is not bypassed, false otherwise.
+             */
+            bool active () const { return !effects_.empty () && !bypassed_.load (memory_order_relaxed); };
+
+            /**
+             * Returns the number of Effects.
+             *
+             * @return The number of Effects.
+             */
+            size_t size () const { return effects_.size (); };
+
+            /**
+             * Processes audio in place. Called from the audio thread.
+             *
+             * @param samples The interleaved samples.
+             * @param frames The number of frames.
+             */
+            void process (float* samples, unsigned int frames) {
+                if (!active ())
+                    return;
+                for (unsigned int done = 0; done < frames; done += BLOCK) {
+                    unsigned int n = min (frames - done, BLOCK);
+                    for (vector<boost::shared_ptr<Effect> >::iterator e = effects_.begin (); e != effects_.end (); ++e)
+                        (*e)->process (samples + done * channels_, n);
+                }
+            };
+
+            /**
+             * Runs a buffer through the chain from a cleared state, as fast as it will go.
+             *
+             * @param in The interleaved input samples.
+             * @param frames The number of frames.
+             * @param out Receives the interleaved output samples.
+             *
+             * @return A reference to this EffectChain.
+             */
+            EffectChain& render (const float* in, size_t frames, vector<float>& out) {
+                reset ();
+                out.assign (in, in + frames * channels_);
+                for (size_t done = 0; done < frames; done += BLOCK)
+                    process (&out[done * channels_], static_cast<unsigned int> (min (frames - done, static_cast<size_t> (BLOCK))));
+                return *this;
+            };
+
+            /**
+             * Returns the rate.
+             *
+             * @return The rate in frames per second.
+             */
+            int rate () const { return rate_; };
+
+            /**
+             * Returns the number of channels.
+             *
+             * @return 1 or 2.
+             */
+            int channels () const { return channels_; };
+
+        private:
+            /**
+             * Copy constructs an EffectChain.
+             *
+             * @param rhs The EffectChain to copy.
+             */
+            EffectChain (const EffectChain& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The EffectChain from which to assign.
+             *
+             * @return A reference to this EffectChain.
+             */
+            EffectChain& operator= (const EffectChain& rhs);
+
+            /**
+             * The Effects in processing order.
+             */
+            vector<boost::shared_ptr<Effect> > effects_;
+
+            /**
+             * The rate.
+             */
+            int rate_;
+
+            /**
+             * The number of channels.
+             */
+            int channels_;
+
+            /**
+             * Whether or not the chain is bypassed.
+             */
+            atomic<bool> bypassed_;
+    }; //EffectChain
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_EFFECTCHAIN_H
@@ -0,0 +1,86 @@
+/**
+ * @file Latency.h
+ * Contains the Latency struct.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_LATENCY_H
+#define SDL_AUDIO_LATENCY_H
+
+#include <SDL.h>
+
+namespace sdl {
+namespace audio {
+
+    /**
+     * @struct Latency
+     * @brief Asks for an output latency rather than a buffer size.
+     *
+     * The output latency is estimated as two buffers, SDL's and the device's, so the target
+     * buffer is the largest power of two whose two buffers fit in the target latency. Audio opens
+     * the target buffer, or the next size up the driver accepts, and when adaptive grows it on
+     * underruns and shrinks it back toward the target while the callback is comfortably fast.
+     */
+    struct Latency {
+        /**
+         * The smallest buffer size tried, in samples.
+         */
+        static const unsigned short MIN_SAMPLES = 64;
+
+        /**
+         * Constructs a Latency.
+         *
+         * @param milliseconds The target latency in milliseconds.
+         * @param maxSamples The largest buffer size allowed, in samples.
+         * @param adaptive Whether or not to resize the buffer as the callback keeps up or falls behind.
+         */
+        explicit Latency (double milliseconds, unsigned short maxSamples = 8192, bool adaptive = true)
+          : milliseconds_ (milliseconds), maxSamples_ (maxSamples < MIN_SAMPLES ? MIN_SAMPLES : maxSamples), adaptive_ (adaptive) {};
+
+        /**
+         * Returns the target buffer size at a frequency.
+         *
+         * @param freq The audio frequency in samples per second.
+         *
+         * @return The largest power of two from MIN_SAMPLES to maxSamples_ whose latency fits the target, or MIN_SAMPLES if none does.
+         */
+        unsigned short samples (int freq) const {
+            unsigned int samples = MIN_SAMPLES;
+            while (samples * 2 <= maxSamples_ && 2.0 * (samples * 2) / freq * 1000.0 <= milliseconds_)
+                samples *= 2;
+            return static_cast<unsigned short> (samples);
+        };
+
+        /**
+         * The target latency in milliseconds.
+         */
+        double milliseconds_;
+
+        /**
+         * The largest buffer size allowed, in samples.
+         */
+        unsigned short maxSamples_;
+
+        /**
+         * Whether or not to resize the buffer as the callback keeps up or falls behind.
+         */
+        bool adaptive_;
+    }; //Latency
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_LATENCY_H
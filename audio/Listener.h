@@ -0,0 +1,94 @@
+/**
+ * @file Listener.h
+ * Contains the Listener struct.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_LISTENER_H
+#define SDL_AUDIO_LISTENER_H
+
+#include <cmath>
+
+namespace sdl {
+namespace audio {
+
+    /**
+     * @struct Listener
+     * @brief Where positional voices are heard from.
+     *
+     * A positional voice is panned by the side of the Listener it is on and attenuated by its
+     * distance: at full gain up to near_, falling off inversely with distance beyond it and
+     * reaching silence at far_, past which the voice is not mixed at all.
+     */
+    struct Listener {
+        /**
+         * Constructs a Listener at the origin facing down the negative z axis.
+         *
+         * @param nearDistance The distance up to which voices play at full gain.
+         * @param farDistance The distance from which voices are silent.
+         */
+        explicit Listener (float nearDistance = 1.0f, float farDistance = 100.0f) : near_ (nearDistance), far_ (farDistance) {
+            position_[0] = position_[1] = position_[2] = 0.0f;
+            right_[0] = 1.0f;
+            right_[1] = right_[2] = 0.0f;
+        };
+
+        /**
+         * Constructs a Listener from a camera that turns by yaw degrees around the y axis, as
+         * glRotatef (yaw, 0, 1, 0) does. Pitching such a camera does not move its right hand side.
+         *
+         * @param x The x coordinate of the position.
+         * @param y The y coordinate of the position.
+         * @param z The z coordinate of the position.
+         * @param yaw The rotation around the y axis in degrees.
+         * @param nearDistance The distance up to which voices play at full gain.
+         * @param farDistance The distance from which voices are silent.
+         */
+        Listener (float x, float y, float z, float yaw, float nearDistance = 1.0f, float farDistance = 100.0f) : near_ (nearDistance), far_ (farDistance) {
+            position_[0] = x;
+            position_[1] = y;
+            position_[2] = z;
+            float radians = yaw * 0.0174532925f;
+            right_[0] = cos (radians);
+            right_[1] = 0.0f;
+            right_[2] = sin (radians);
+        };
+
+        /**
+         * The position.
+         */
+        float position_[3];
+
+        /**
+         * The unit vector to the right hand side.
+         */
+        float right_[3];
+
+        /**
+         * The distance up to which voices play at full gain.
+         */
+        float near_;
+
+        /**
+         * The distance from which voices are silent.
+         */
+        float far_;
+    }; //Listener
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_LISTENER_H
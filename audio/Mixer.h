@@ -0,0 +1,1102 @@
+/**
+ * @file Mixer.h
+ * Contains the Mixer class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_MIXER_H
+#define SDL_AUDIO_MIXER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <SDL.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "sdlpp/audio/Sample.h"
+#include "sdlpp/audio/WavStream.h"
+#include "sdlpp/audio/Listener.h"
+#include "sdlpp/audio/EffectChain.h"
+#include "sdlpp/thread/SpscQueue.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+    using namespace thread;
+
+    /**
+     * @class Mixer
+     * @brief Mixes playing Samples into the audio output with per-voice gain, pan and looping.
+     *
+     * The game thread starts and controls voices through a lock-free command queue, and the
+     * audio thread applies the commands at the start of each mix, so neither ever waits on
+     * the other and the callback never takes a lock or allocates. The game thread keeps each
+     * playing Sample alive until the audio thread reports its voice finished, so memory is
+     * never freed on the audio thread. Each command lets go of the Samples of finished voices,
+     * as does update, which a game sending no commands should call once per frame.
+     * Voices are mixed in float, eight samples at a time with SSE2, and gain and pan changes
+     * are ramped over one block to avoid clicks. WavStreams play the same way, read a block at a
+     * time from their read-ahead buffers. Positional voices take their gain and pan from where
+     * they are relative to the Listener, computed for every voice at once, four at a time with
+     * SSE2, at the start of each block; voices too far away to hear are not mixed, only kept in
+     * time. Each voice plays on a bus, whose EffectChain processes what its voices mix before
+     * the buses are summed and run through the master EffectChain. Commands must come from one
+     * thread.
+     */
+    class Mixer {
+        public:
+            /**
+             * @typedef Uint32 VoiceId
+             * @brief Identifies a voice, 0 for none.
+             */
+            typedef Uint32 VoiceId;
+
+            /**
+             * The largest number of frames mixed in one pass.
+             */
+            static const unsigned int BLOCK = 1024;
+
+            /**
+             * Constructs a Mixer.
+             *
+             * @param rate The output rate in frames per second.
+             * @param channels The number of output channels, 1 or 2.
+             * @param voices The largest number of voices playing at once.
+             * @param commands The number of commands that can wait for the audio thread.
+             * @param buses The number of buses, each with its own EffectChain.
+             *
+             * @throw runtime_error Throws a runtime_error if the number of channels is not 1 or 2 or there are no buses.
+             */
+            Mixer (int rate, int channels, unsigned int voices = 32, unsigned int commands = 256, unsigned int buses = 1)
+              : rate_ (rate), channels_ (channels), voices_ (voices), commands_ (commands), finished_ (commands + voices),
+                scratch_ (BLOCK * channels), streamed_ (BLOCK * 2), listeners_ (4), listener_ (), emitterX_ ((voices + 3) & ~3u), emitterY_ ((voices + 3) & ~3u),
+                emitterZ_ ((voices + 3) & ~3u), attenuation_ ((voices + 3) & ~3u), side_ ((voices + 3) & ~3u), spatial_ (0), buses_ (),
+                busMix_ (buses > 1 ? (buses - 1) * BLOCK * channels : 0), master_ (rate, channels), playing_ (), nextId_ (0), active_ (0), rejected_ (0), culled_ (0) {
+                if (channels != 1 && channels != 2)
+                    throw runtime_error ("The Mixer outputs 1 or 2 channels.");
+                if (buses == 0)
+                    throw runtime_error ("The Mixer needs a bus.");
+                for (unsigned int b = 0; b < buses; ++b)
+                    buses_.push_back (boost::shared_ptr<EffectChain> (new EffectChain (rate, channels)));
+            };
+
+            /**
+             * Starts playing a Sample. Called from the game thread.
+             *
+             * @param sample The Sample, at the Mixer's rate.
+             * @param gain The gain, 1 for unchanged.
+             * @param pan The pan, from -1 for left to 1 for right.
+             * @param loop Whether or not to loop the Sample until stopped.
+             *
+             * @return The voice, 0 if the command queue is full.
+             */
+            VoiceId play (const Sample& sample, float gain = 1.0f, float pan = 0.0f, bool loop = false) {
+                Command command = { Command::PLAY, next (), sample.data (), sample.frames (), sample.channels (), NULL, loop, gain, pan, false, 0.0f, 0.0f, 0.0f };
+                playing_[command.id_].sample_ = sample;
+                return submit (command);
+            };
+
+            /**
+             * Starts playing a Sample at a position, panned and attenuated relative to the Listener.
+             * Called from the game thread.
+             *
+             * @param sample The Sample, at the Mixer's rate.
+             * @param x The x coordinate of the position.
+             * @param y The y coordinate of the position.
+             * @param z The z coordinate of the position.
+             * @param gain The gain at or within the Listener's near distance, 1 for unchanged.
+             * @param loop Whether or not to loop the Sample until stopped.
+             *
+             * @return The voice, 0 if the command queue is full.
+             */
+            VoiceId playAt (const Sample& sample, float x, float y, float z, float gain = 1.0f, bool loop = false) {
+                Command command = { Command::PLAY, next (), sample.data (), sample.frames (), sample.channels (), NULL, loop, gain, 0.0f, true, x, y, z };
+                playing_[command.id_].sample_ = sample;
+                return submit (command);
+            };
+
+            /**
+             * Starts playing a WavStream from its current position. Called from the game thread.
+             *
+             * @param stream The WavStream, at the Mixer's rate and not playing on another voice.
+             * @param gain The gain, 1 for unchanged.
+             * @param pan The pan, from -1 for left to 1 for right.
+             * @param loop Whether or not to loop the WavStream until stopped.
+             *
+             * @return The voice, 0 if the command queue is full.
+             *
+             * @throw runtime_error Throws a runtime_error if the WavStream is not at the Mixer's rate.
+             */
+            VoiceId play (const boost::shared_ptr<WavStream>& stream, float gain = 1.0f, float pan = 0.0f, bool loop = false) {
+                if (stream->rate () != rate_)
+                    throw runtime_error ("The WavStream is not at the Mixer's rate.");
+                stream->loop (loop);
+                Command command = { Command::PLAY, next (), NULL, 0, stream->channels (), stream.get (), false, gain, pan, false, 0.0f, 0.0f, 0.0f };
+                playing_[command.id_].stream_ = stream;
+                return submit (command);
+            };
+
+            /**
+             * Starts playing a WavStream from its current position at a position, panned and
+             * attenuated relative to the Listener. Called from the game thread.
+             *
+             * @param stream The WavStream, at the Mixer's rate and not playing on another voice.
+             * @param x The x coordinate of the position.
+             * @param y The y coordinate of the position.
+             * @param z The z coordinate of the position.
+             * @param gain The gain at or within the Listener's near distance, 1 for unchanged.
+             * @param loop Whether or not to loop the WavStream until stopped.
+             *
+             * @return The voice, 0 if the command queue is full.
+             *
+             * @throw runtime_error Throws a runtime_error if the WavStream is not at the Mixer's rate.
+             */
+            VoiceId playAt (const boost::shared_ptr<WavStream>& stream, float x, float y, float z, float gain = 1.0f, bool loop = false) {
+                if (stream->rate () != rate_)
+                    throw runtime_error ("The WavStream is not at the Mixer's rate.");
+                stream->loop (loop);
+                Command command = { Command::PLAY, next (), NULL, 0, stream->channels (), stream.get (), false, gain, 0.0f, true, x, y, z };
+                playing_[command.id_].stream_ = stream;
+                return submit (command);
+            };
+
+            /**
+             * Stops a voice, fading it out over one block. Called from the game thread.
+             *
+             * @param id The voice.
+             *
+             * @return True if the command was queued, false if the command queue is full.
+             */
+            bool stop (VoiceId id) { return send (Command::STOP, id, 0.0f); };
+
+            /**
+             * Stops every voice. Called from the game thread.
+             *
+             * @return True if the command was queued, false if the command queue is full.
+             */
+            bool stopAll () { return send (Command::STOP_ALL, 0, 0.0f); };
+
+            /**
+             * Sets the gain of a voice. Called from the game thread.
+             *
+             * @param id The voice.
+             * @param gain The gain, 1 for unchanged.
+             *
+             * @return True if the command was queued, false if the command queue is full.
+             */
+            bool gain (VoiceId id, float gain) { return send (Command::GAIN, id, gain); };
+
+            /**
+             * Sets the pan of a voice. Called from the game thread.
+             *
+             * @param id The voice.
+             * @param pan The pan, from -1 for left to 1 for right.
+             *
+             * @return True if the command was queued, false if the command queue is full.
+             */
+            bool pan (VoiceId id, float pan) { return send (Command::PAN, id, pan); };
+
+            /**
+             * Moves a positional voice. Called from the game thread; moving many voices every
+             * frame needs a command queue to match.
+             *
+             * @param id The voice.
+             * @param x The x coordinate of the position.
+             * @param y The y coordinate of the position.
+             * @param z The z coordinate of the position.
+             *
+             * @return True if the command was queued, false if the command queue is full.
+             */
+            bool move (VoiceId id, float x, float y, float z) {
+                Command command = { Command::MOVE, id, NULL, 0, 1, NULL, false, 0.0f, 0.0f, true, x, y, z };
+                return commands_.push (command);
+            };
+
+            /**
+             * Moves a voice to a bus. Called from the game thread.
+             *
+             * @param id The voice.
+             * @param bus The bus.
+             *
+             * @return True if the command was queued, false if the bus does not exist or the command queue is full.
+             */
+            bool route (VoiceId id, unsigned int bus) {
+                Command command = { Command::ROUTE, id, NULL, bus, 1, NULL, false, 0.0f, 0.0f, false, 0.0f, 0.0f, 0.0f };
+                return bus < buses_.size () && commands_.push (command);
+            };
+
+            /**
+             * Returns the EffectChain of a bus, to add Effects before playback or with the audio
+             * locked, and to set their parameters at any time.
+             *
+             * @param bus The bus.
+             *
+             * @return The EffectChain.
+             *
+             * @throw runtime_error Throws a runtime_error if the bus does not exist.
+             */
+            EffectChain& effects (unsigned int bus = 0) {
+                if (bus >= buses_.size ())
+                    throw runtime_error ("The Mixer has no such bus.");
+                return *buses_[bus];
+            };
+
+            /**
+             * Returns the EffectChain the sum of the buses runs through.
+             *
+             * @return The EffectChain.
+             */
+            EffectChain& master () { return master_; };
+
+            /**
+             * Returns the number of buses.
+             *
+             * @return The number of buses.
+             */
+            unsigned int buses () const { return static_cast<unsigned int> (buses_.size ()); };
+
+            /**
+             * Places the Listener of positional voices. Called from the game thread, once per frame.
+             *
+             * @param listener The Listener.
+             *
+             * @return True if queued, false if the audio thread has yet to take the last few.
+             */
+            bool listener (const Listener& listener) { return listeners_.push (listener); };
+
+            /**
+             * Releases the Samples and WavStreams of finished voices. Called from the game thread, once per frame.
+             *
+             * @return A reference to this Mixer.
+             */
+            Mixer& update () {
+                VoiceId id;
+                while (finished_.pop (id))
+                    playing_.erase (id);
+                return *this;
+            };
+
+            /**
+             * Determines if a voice is playing, as of the last update. Called from the game thread.
+             *
+             * @param id The voice.
+             *
+             * @return True if playing, false otherwise.
+             */
+            bool playing (VoiceId id) const { return playing_.find (id) != playing_.end (); };
+
+            /**
+             * Returns the number of voices playing on the audio thread.
+             *
+             * @return The number of voices.
+             */
+            unsigned int active () const { return active_.load (); };
+
+            /**
+             * Returns the number of voices not started because every voice was playing.
+             *
+             * @return The number of voices.
+             */
+            unsigned int rejected () const { return rejected_.load (); };
+
+            /**
+             * Returns the number of voices skipped as inaudible in the last block.
+             *
+             * @return The number of voices.
+             */
+            unsigned int culled () const { return culled_.load (); };
+
+            /**
+             * Returns the output rate.
+             *
+             * @return The rate in frames per second.
+             */
+            int rate () const { return rate_; };
+
+            /**
+             * Returns the number of output channels.
+             *
+             * @return 1 or 2.
+             */
+            int channels () const { return channels_; };
+
+            /**
+             * Mixes the playing voices, BLOCK frames at a time. Called from the audio thread.
+             *
+             * @param out Receives the interleaved samples, nominally from -1 to 1.
+             * @param frames The number of frames.
+             */
+            void mix (float* out, unsigned int frames) {
+                while (listeners_.pop (listener_))
+                    ;
+                execute ();
+                if (spatial_ != 0)
+                    spatialize (0, emitterX_.size ());
+                unsigned int culled = 0;
+                for (unsigned int done = 0; done < frames; done += BLOCK) {
+                    unsigned int n = min (frames - done, BLOCK);
+                    float* block = out + done * channels_;
+                    fill (block, block + n * channels_, 0.0f);
+                    fill (busMix_.begin (), busMix_.end (), 0.0f);
+                    culled = 0;
+                    for (vector<Voice>::iterator v = voices_.begin (); v != voices_.end (); ++v) {
+                        if (v->id_ == 0 || v->done_)
+                            continue;
+                        if (v->left_ == 0.0f && v->right_ == 0.0f && v->targetLeft_ == 0.0f && v->targetRight_ == 0.0f) {
+                            skip (*v, n);
+                            ++culled;
+                        } else {
+                            mixVoice (*v, v->bus_ == 0 ? block : &busMix_[(v->bus_ - 1) * BLOCK * channels_], n);
+                        }
+                    }
+                    buses_[0]->process (block, n);
+                    for (size_t b = 1; b < buses_.size (); ++b) {
+                        float* bus = &busMix_[(b - 1) * BLOCK * channels_];
+                        buses_[b]->process (bus, n);
+                        for (unsigned int i = 0; i < n * channels_; ++i)
+                            block[i] += bus[i];
+                    }
+                    master_.process (block, n);
+                }
+                culled_.store (culled);
+                retire ();
+            };
+
+            /**
+             * Mixes the playing voices to 16 bit samples, clipping. Called from the audio thread.
+             *
+             * @param out Receives the interleaved samples.
+             * @param frames The number of frames.
+             */
+            void mix (Sint16* out, unsigned int frames) {
+                while (frames > 0) {
+                    unsigned int n = min (frames, BLOCK);
+                    mix (&scratch_[0], n);
+                    toS16 (&scratch_[0], out, n * channels_);
+                    out += n * channels_;
+                    frames -= n;
+                }
+            };
+
+            /**
+             * Fills an SDL audio buffer, for use as the callback of a 16 bit device opened at the
+             * Mixer's rate and channels with the Mixer as the userdata.
+             *
+             * @param userdata The Mixer.
+             * @param stream The buffer.
+             * @param len The size of the buffer in bytes.
+             */
+            static void callback (void* userdata, Uint8* stream, int len) {
+                Mixer* mixer = static_cast<Mixer*> (userdata);
+                mixer->mix (reinterpret_cast<Sint16*> (stream), len / (sizeof (Sint16) * mixer->channels_));
+            };
+
+        private:
+            /**
+             * @struct Command
+             * @brief A request from the game thread.
+             */
+            struct Command {
+                /**
+                 * @enum Type
+                 * @brief The kind of request.
+                 */
+                enum Type { PLAY, STOP, STOP_ALL, GAIN, PAN, MOVE, ROUTE };
+
+                /**
+                 * The kind of request.
+                 */
+                Type type_;
+
+                /**
+                 * The voice.
+                 */
+                VoiceId id_;
+
+                /**
+                 * The samples to play.
+                 */
+                const Sint16* data_;
+
+                /**
+                 * The number of frames to play, or the bus of a ROUTE request.
+                 */
+                size_t frames_;
+
+                /**
+                 * The number of channels of the samples.
+                 */
+                int channels_;
+
+                /**
+                 * The stream to play, NULL to play the samples.
+                 */
+                WavStream* stream_;
+
+                /**
+                 * Whether or not to loop.
+                 */
+                bool loop_;
+
+                /**
+                 * The gain, or the value of a GAIN or PAN request.
+                 */
+                float gain_;
+
+                /**
+                 * The pan.
+                 */
+                float pan_;
+
+                /**
+                 * Whether or not the voice is positional.
+                 */
+                bool positional_;
+
+                /**
+                 * The position of a positional voice.
+                 */
+                float x_, y_, z_;
+            }; //Command
+
+            /**
+             * @struct Voice
+             * @brief A Sample playing on the audio thread.
+             */
+            struct Voice {
+                /**
+                 * Constructs a free Voice.
+                 */
+                Voice () : id_ (0), data_ (NULL), frames_ (0), channels_ (1), stream_ (NULL), position_ (0), loop_ (false), stopping_ (false), done_ (false),
+                           positional_ (false), bus_ (0), gain_ (0.0f), pan_ (0.0f), left_ (0.0f), right_ (0.0f), targetLeft_ (0.0f), targetRight_ (0.0f) {};
+
+                /**
+                 * The voice, 0 if free.
+                 */
+                VoiceId id_;
+
+                /**
+                 * The samples.
+                 */
+                const Sint16* data_;
+
+                /**
+                 * The number of frames.
+                 */
+                size_t frames_;
+
+                /**
+                 * The number of channels of the samples.
+                 */
+                int channels_;
+
+                /**
+                 * The stream, NULL for a Sample.
+                 */
+                WavStream* stream_;
+
+                /**
+                 * The next frame to play.
+                 */
+                size_t position_;
+
+                /**
+                 * Whether or not to loop.
+                 */
+                bool loop_;
+
+                /**
+                 * Whether or not the Voice is fading out to stop.
+                 */
+                bool stopping_;
+
+                /**
+                 * Whether or not the Voice has finished and awaits being reported.
+                 */
+                bool done_;
+
+                /**
+                 * Whether or not the Voice takes its gain and pan from its position.
+                 */
+                bool positional_;
+
+                /**
+                 * The bus.
+                 */
+                unsigned int bus_;
+
+                /**
+                 * The gain.
+                 */
+                float gain_;
+
+                /**
+                 * The pan.
+                 */
+                float pan_;
+
+                /**
+                 * The gains applied at the start of the next block, scaled to the sample range.
+                 */
+                float left_, right_;
+
+                /**
+                 * The gains to reach by the end of the next block.
+                 */
+                float targetLeft_, targetRight_;
+            }; //Voice
+
+            /**
+             * Copy constructs a Mixer.
+             *
+             * @param rhs The Mixer to copy.
+             */
+            Mixer (const Mixer& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The Mixer from which to assign.
+             *
+             * @return A reference to this Mixer.
+             */
+            Mixer& operator= (const Mixer& rhs);
+
+            /**
+             * @struct Held
+             * @brief What a voice plays, kept alive by the game thread until the voice finishes.
+             */
+            struct Held {
+                /**
+                 * The Sample.
+                 */
+                Sample sample_;
+
+                /**
+                 * The WavStream, NULL for a Sample.
+                 */
+                boost::shared_ptr<WavStream> stream_;
+            }; //Held
+
+            /**
+             * Queues a PLAY command, forgetting what it plays if the command queue is full. Drains
+             * the finished reports first, since the audio thread stops taking commands while it
+             * has no room to report.
+             *
+             * @param command The command.
+             *
+             * @return The voice, 0 if the command queue is full.
+             */
+            VoiceId submit (const Command& command) {
+                update ();
+                if (!commands_.push (command)) {
+                    playing_.erase (command.id_);
+                    return 0;
+                }
+                return command.id_;
+            };
+
+            /**
+             * Queues a command without samples, draining the finished reports first.
+             *
+             * @param type The kind of request.
+             * @param id The voice.
+             * @param value The value of a GAIN or PAN request.
+             *
+             * @return True if queued, false if the command queue is full.
+             */
+            bool send (Command::Type type, VoiceId id, float value) {
+                update ();
+                Command command = { type, id, NULL, 0, 1, NULL, false, value, 0.0f, false, 0.0f, 0.0f, 0.0f };
+                return commands_.push (command);
+            };
+
+            /**
+             * Returns the next voice.
+             *
+             * @return The voice, never 0.
+             */
+            VoiceId next () {
+                if (++nextId_ == 0)
+                    ++nextId_;
+                return nextId_;
+            };
+
+            /**
+             * Applies the queued commands, leaving them queued while a finished report could not be sent.
+             */
+            void execute () {
+                Command c;
+                while (finished_.size () < finished_.capacity () && commands_.pop (c)) {
+                    if (c.type_ == Command::PLAY) {
+                        start (c);
+                        continue;
+                    }
+                    for (vector<Voice>::iterator v = voices_.begin (); v != voices_.end (); ++v) {
+                        if (v->id_ == 0 || v->done_ || (c.type_ != Command::STOP_ALL && v->id_ != c.id_))
+                            continue;
+                        if (c.type_ == Command::MOVE) {
+                            place (v - voices_.begin (), c);
+                            continue;
+                        }
+                        if (c.type_ == Command::ROUTE) {
+                            v->bus_ = static_cast<unsigned int> (c.frames_);
+                            continue;
+                        }
+                        if (c.type_ == Command::GAIN)
+                            v->gain_ = c.gain_;
+                        else if (c.type_ == Command::PAN)
+                            v->pan_ = c.gain_;
+                        else
+                            v->stopping_ = true;
+                        target (*v);
+                    }
+                }
+            };
+
+            /**
+             * Starts a voice in a free Voice, or reports it finished if none is free.
+             *
+             * @param c The PLAY command.
+             */
+            void start (const Command& c) {
+                for (vector<Voice>::iterator v = voices_.begin (); v != voices_.end (); ++v) {
+                    if (v->id_ != 0)
+                        continue;
+                    *v = Voice ();
+                    v->id_ = c.id_;
+                    v->data_ = c.data_;
+                    v->frames_ = c.frames_;
+                    v->channels_ = c.channels_;
+                    v->stream_ = c.stream_;
+                    v->loop_ = c.loop_;
+                    v->gain_ = c.gain_;
+                    v->pan_ = c.pan_;
+                    v->done_ = c.stream_ == NULL && c.frames_ == 0;
+                    v->positional_ = c.positional_;
+                    if (v->positional_) {
+                        size_t slot = v - voices_.begin ();
+                        place (slot, c);
+                        spatialize (slot & ~3u, (slot & ~3u) + 4);
+                        ++spatial_;
+                    }
+                    target (*v);
+                    v->left_ = v->targetLeft_;
+                    v->right_ = v->targetRight_;
+                    ++active_;
+                    return;
+                }
+                ++rejected_;
+                finished_.push (c.id_);
+            };
+
+            /**
+             * Records the position of a positional voice.
+             *
+             * @param slot The index of its Voice.
+             * @param c The PLAY or MOVE command.
+             */
+            void place (size_t slot, const Command& c) {
+                emitterX_[slot] = c.x_;
+                emitterY_[slot] = c.y_;
+                emitterZ_[slot] = c.z_;
+            };
+
+            /**
+             * Computes the attenuation and side of a run of slots relative to the Listener, four
+             * at a time with the same operations with and without SSE2, then retargets the
+             * positional Voices among them.
+             *
+             * @param first The first slot, a multiple of 4.
+             * @param last One past the last slot, a multiple of 4.
+             */
+            void spatialize (size_t first, size_t last) {
+                last = min (last, emitterX_.size ());
+                float nearDistance = max (listener_.near_, 1e-6f);
+                float cutoff = nearDistance / max (listener_.far_, nearDistance * 1.001f);
+                float scale = 1.0f / (1.0f - cutoff);
+                size_t i = first;
+#ifdef __SSE2__
+                const __m128 lx = _mm_set1_ps (listener_.position_[0]), ly = _mm_set1_ps (listener_.position_[1]), lz = _mm_set1_ps (listener_.position_[2]);
+                const __m128 rx = _mm_set1_ps (listener_.right_[0]), ry = _mm_set1_ps (listener_.right_[1]), rz = _mm_set1_ps (listener_.right_[2]);
+                const __m128 n = _mm_set1_ps (nearDistance), c = _mm_set1_ps (cutoff), k = _mm_set1_ps (scale);
+                const __m128 tiny = _mm_set1_ps (1e-6f), zero = _mm_setzero_ps ();
+                for (; i < last; i += 4) {
+                    __m128 dx = _mm_sub_ps (_mm_loadu_ps (&emitterX_[i]), lx);
+                    __m128 dy = _mm_sub_ps (_mm_loadu_ps (&emitterY_[i]), ly);
+                    __m128 dz = _mm_sub_ps (_mm_loadu_ps (&emitterZ_[i]), lz);
+                    __m128 d = _mm_sqrt_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (dx, dx), _mm_mul_ps (dy, dy)), _mm_mul_ps (dz, dz)));
+                    __m128 across = _mm_add_ps (_mm_add_ps (_mm_mul_ps (dx, rx), _mm_mul_ps (dy, ry)), _mm_mul_ps (dz, rz));
+                    _mm_storeu_ps (&side_[i], _mm_div_ps (across, _mm_max_ps (d, tiny)));
+                    __m128 inverse = _mm_div_ps (n, _mm_max_ps (d, n));
+                    _mm_storeu_ps (&attenuation_[i], _mm_max_ps (_mm_mul_ps (_mm_sub_ps (inverse, c), k), zero));
+                }
+#endif
+                for (; i < last; ++i) {
+                    float dx = emitterX_[i] - listener_.position_[0];
+                    float dy = emitterY_[i] - listener_.position_[1];
+                    float dz = emitterZ_[i] - listener_.position_[2];
+                    float d = sqrt ((dx * dx + dy * dy) + dz * dz);
+                    float across = (dx * listener_.right_[0] + dy * listener_.right_[1]) + dz * listener_.right_[2];
+                    side_[i] = across / max (d, 1e-6f);
+                    float inverse = nearDistance / max (d, nearDistance);
+                    attenuation_[i] = max ((inverse - cutoff) * scale, 0.0f);
+                }
+                for (i = first; i < min (last, voices_.size ()); ++i)
+                    if (voices_[i].id_ != 0 && voices_[i].positional_ && !voices_[i].done_)
+                        target (voices_[i]);
+            };
+
+            /**
+             * Computes the gains of a Voice from its gain and pan, or its position, with the
+             * 1 / 32768 scale of 16 bit samples folded in. Mono Samples pan at constant power,
+             * stereo ones balance.
+             *
+             * @param v The Voice.
+             */
+            void target (Voice& v) const {
+                size_t slot = &v - &voices_[0];
+                float gain = v.stopping_ ? 0.0f : v.gain_ / 32768.0f;
+                if (v.positional_)
+                    gain *= attenuation_[slot];
+                float pan = max (-1.0f, min (1.0f, v.positional_ ? side_[slot] : v.pan_));
+                if (channels_ == 1) {
+                    v.targetLeft_ = v.targetRight_ = v.channels_ == 1 ? gain : gain * 0.5f;
+                } else if (v.channels_ == 1) {
+                    float angle = (pan + 1.0f) * 0.785398163f;
+                    v.targetLeft_ = gain * cos (angle);
+                    v.targetRight_ = gain * sin (angle);
+                } else {
+                    v.targetLeft_ = gain * min (1.0f, 1.0f - pan);
+                    v.targetRight_ = gain * min (1.0f, 1.0f + pan);
+                }
+            };
+
+            /**
+             * Mixes a Voice into a block, looping or finishing it at the end of its Sample.
+             *
+             * @param v The Voice.
+             * @param out The block.
+             * @param frames The number of frames in the block.
+             */
+            void mixVoice (Voice& v, float* out, unsigned int frames) {
+                float stepLeft = (v.targetLeft_ - v.left_) / frames;
+                float stepRight = (v.targetRight_ - v.right_) / frames;
+                bool ramp = v.targetLeft_ != v.left_ || v.targetRight_ != v.right_;
+                unsigned int done = 0;
+                while (done < frames && !v.done_) {
+                    unsigned int n;
+                    const Sint16* src;
+                    if (v.stream_ != NULL) {
+                        n = static_cast<unsigned int> (v.stream_->read (&streamed_[0], min (frames - done, BLOCK)));
+                        src = &streamed_[0];
+                        if (n == 0) {
+                            v.done_ = v.stream_->ended ();
+                            break;
+                        }
+                    } else {
+                        n = static_cast<unsigned int> (min (static_cast<size_t> (frames - done), v.frames_ - v.position_));
+                        src = v.data_ + v.position_ * v.channels_;
+                    }
+                    float* dst = out + done * channels_;
+                    if (ramp)
+                        accumulateRamp (src, v.channels_, dst, n, v.left_, v.right_, stepLeft, stepRight);
+                    else
+                        accumulate (src, v.channels_, dst, n, v.left_, v.right_);
+                    done += n;
+                    if (v.stream_ != NULL)
+                        continue;
+                    v.position_ += n;
+                    if (v.position_ == v.frames_) {
+                        if (v.loop_)
+                            v.position_ = 0;
+                        else
+                            v.done_ = true;
+                    }
+                }
+                v.left_ = v.targetLeft_;
+                v.right_ = v.targetRight_;
+                if (v.stopping_)
+                    v.done_ = true;
+            };
+
+            /**
+             * Advances an inaudible Voice through a block without mixing it, finishing it if
+             * stopping or at the end of its Sample.
+             *
+             * @param v The Voice.
+             * @param frames The number of frames in the block.
+             */
+            void skip (Voice& v, unsigned int frames) {
+                if (v.stopping_) {
+                    v.done_ = true;
+                } else if (v.stream_ != NULL) {
+                    for (unsigned int done = 0; done < frames; ) {
+                        unsigned int n = static_cast<unsigned int> (v.stream_->read (&streamed_[0], min (frames - done, BLOCK)));
+                        if (n == 0) {
+                            v.done_ = v.stream_->ended ();
+                            break;
+                        }
+                        done += n;
+                    }
+                } else {
+                    v.position_ += frames;
+                    if (v.position_ >= v.frames_) {
+                        if (v.loop_)
+                            v.position_ %= v.frames_;
+                        else
+                            v.done_ = true;
+                    }
+                }
+            };
+
+            /**
+             * Adds samples at constant gains.
+             *
+             * @param src The samples.
+             * @param channels The number of channels of the samples.
+             * @param out The output.
+             * @param n The number of frames.
+             * @param left The gain of the left or only output channel.
+             * @param right The gain of the right output channel.
+             */
+            void accumulate (const Sint16* src, int channels, float* out, unsigned int n, float left, float right) const {
+                unsigned int i = 0;
+                if (channels_ == 2 && channels == 2) {
+#ifdef __SSE2__
+                    __m128 gains = _mm_setr_ps (left, right, left, right);
+                    for (; i + 4 <= n; i += 4) {
+                        __m128i s = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 2 * i));
+                        __m128 lo = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (s, s), 16));
+                        __m128 hi = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (s, s), 16));
+                        _mm_storeu_ps (out + 2 * i, _mm_add_ps (_mm_loadu_ps (out + 2 * i), _mm_mul_ps (lo, gains)));
+                        _mm_storeu_ps (out + 2 * i + 4, _mm_add_ps (_mm_loadu_ps (out + 2 * i + 4), _mm_mul_ps (hi, gains)));
+                    }
+#endif
+                    for (; i < n; ++i) {
+                        out[2 * i] += static_cast<float> (src[2 * i]) * left;
+                        out[2 * i + 1] += static_cast<float> (src[2 * i + 1]) * right;
+                    }
+                } else if (channels_ == 2) {
+#ifdef __SSE2__
+                    __m128 gains = _mm_setr_ps (left, right, left, right);
+                    for (; i + 4 <= n; i += 4) {
+                        __m128i s = _mm_loadl_epi64 (reinterpret_cast<const __m128i*> (src + i));
+                        __m128 m = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (s, s), 16));
+                        _mm_storeu_ps (out + 2 * i, _mm_add_ps (_mm_loadu_ps (out + 2 * i), _mm_mul_ps (_mm_unpacklo_ps (m, m), gains)));
+                        _mm_storeu_ps (out + 2 * i + 4, _mm_add_ps (_mm_loadu_ps (out + 2 * i + 4), _mm_mul_ps (_mm_unpackhi_ps (m, m), gains)));
+                    }
+#endif
+                    for (; i < n; ++i) {
+                        out[2 * i] += static_cast<float> (src[i]) * left;
+                        out[2 * i + 1] += static_cast<float> (src[i]) * right;
+                    }
+                } else if (channels == 1) {
+#ifdef __SSE2__
+                    __m128 gains = _mm_set1_ps (left);
+                    for (; i + 4 <= n; i += 4) {
+                        __m128i s = _mm_loadl_epi64 (reinterpret_cast<const __m128i*> (src + i));
+                        __m128 m = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (s, s), 16));
+                        _mm_storeu_ps (out + i, _mm_add_ps (_mm_loadu_ps (out + i), _mm_mul_ps (m, gains)));
+                    }
+#endif
+                    for (; i < n; ++i)
+                        out[i] += static_cast<float> (src[i]) * left;
+                } else {
+                    for (; i < n; ++i)
+                        out[i] += static_cast<float> (src[2 * i]) * left + static_cast<float> (src[2 * i + 1]) * right;
+                }
+            };
+
+            /**
+             * Adds samples while moving the gains towards their targets.
+             *
+             * @param src The samples.
+             * @param channels The number of channels of the samples.
+             * @param out The output.
+             * @param n The number of frames.
+             * @param left The gain of the left or only output channel, advanced by n steps.
+             * @param right The gain of the right output channel, advanced by n steps.
+             * @param stepLeft The change of the left gain per frame.
+             * @param stepRight The change of the right gain per frame.
+             */
+            void accumulateRamp (const Sint16* src, int channels, float* out, unsigned int n, float& left, float& right, float stepLeft, float stepRight) const {
+                for (unsigned int i = 0; i < n; ++i, left += stepLeft, right += stepRight) {
+                    float l = channels == 2 ? src[2 * i] : src[i];
+                    float r = channels == 2 ? src[2 * i + 1] : src[i];
+                    if (channels_ == 2) {
+                        out[2 * i] += l * left;
+                        out[2 * i + 1] += r * right;
+                    } else {
+                        out[i] += channels == 2 ? l * left + r * right : l * left;
+                    }
+                }
+            };
+
+            /**
+             * Reports finished Voices to the game thread and frees them.
+             */
+            void retire () {
+                for (vector<Voice>::iterator v = voices_.begin (); v != voices_.end (); ++v) {
+                    if (v->id_ != 0 && v->done_ && finished_.push (v->id_)) {
+                        v->id_ = 0;
+                        --active_;
+                        if (v->positional_)
+                            --spatial_;
+                    }
+                }
+            };
+
+            /**
+             * Converts float samples to 16 bit, clipping.
+             *
+             * @param in The float samples.
+             * @param out Receives the 16 bit samples.
+             * @param count The number of samples.
+             */
+            static void toS16 (const float* in, Sint16* out, unsigned int count) {
+                unsigned int i = 0;
+#ifdef __SSE2__
+                const __m128 scale = _mm_set1_ps (32768.0f);
+                const __m128 low = _mm_set1_ps (-32768.0f);
+                const __m128 high = _mm_set1_ps (32767.0f);
+                for (; i + 8 <= count; i += 8) {
+                    __m128 a = _mm_min_ps (_mm_max_ps (_mm_mul_ps (_mm_loadu_ps (in + i), scale), low), high);
+                    __m128 b = _mm_min_ps (_mm_max_ps (_mm_mul_ps (_mm_loadu_ps (in + i + 4), scale), low), high);
+                    _mm_storeu_si128 (reinterpret_cast<__m128i*> (out + i), _mm_packs_epi32 (_mm_cvtps_epi32 (a), _mm_cvtps_epi32 (b)));
+                }
+#endif
+                for (; i < count; ++i)
+                    out[i] = static_cast<Sint16> (lrintf (min (max (in[i] * 32768.0f, -32768.0f), 32767.0f)));
+            };
+
+            /**
+             * The output rate.
+             */
+            int rate_;
+
+            /**
+             * The number of output channels.
+             */
+            int channels_;
+
+            /**
+             * The Voices, touched only by the audio thread.
+             */
+            vector<Voice> voices_;
+
+            /**
+             * The commands from the game thread.
+             */
+            SpscQueue<Command> commands_;
+
+            /**
+             * The finished voices, reported to the game thread.
+             */
+            SpscQueue<VoiceId> finished_;
+
+            /**
+             * The float block converted to 16 bit samples.
+             */
+            vector<float> scratch_;
+
+            /**
+             * The frames read from a WavStream.
+             */
+            vector<Sint16> streamed_;
+
+            /**
+             * The Listeners placed by the game thread.
+             */
+            SpscQueue<Listener> listeners_;
+
+            /**
+             * The Listener, touched only by the audio thread.
+             */
+            Listener listener_;
+
+            /**
+             * The positions of the positional voices by slot, padded to a multiple of 4.
+             */
+            vector<float> emitterX_, emitterY_, emitterZ_;
+
+            /**
+             * The distance attenuation of each slot, from 0 to 1.
+             */
+            vector<float> attenuation_;
+
+            /**
+             * The side of the Listener of each slot, from -1 for left to 1 for right.
+             */
+            vector<float> side_;
+
+            /**
+             * The number of positional voices playing, touched only by the audio thread.
+             */
+            unsigned int spatial_;
+
+            /**
+             * The EffectChain of each bus.
+             */
+            vector<boost::shared_ptr<EffectChain> > buses_;
+
+            /**
+             * The block mixed on each bus but the first, which mixes straight into the output.
+             */
+            vector<float> busMix_;
+
+            /**
+             * The EffectChain of the sum of the buses.
+             */
+            EffectChain master_;
+
+            /**
+             * What the voices not yet reported finished play, touched only by the game thread.
+             */
+            map<VoiceId, Held> playing_;
+
+            /**
+             * The last voice started.
+             */
+            VoiceId nextId_;
+
+            /**
+             * The number of voices playing.
+             */
+            atomic<unsigned int> active_;
+
+            /**
+             * The number of voices not started because every voice was playing.
+             */
+            atomic<unsigned int> rejected_;
+
+            /**
+             * The number of voices skipped as inaudible in the last block.
+             */
+            atomic<unsigned int> culled_;
+    }; //Mixer
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_MIXER_H
@@ -0,0 +1,321 @@
+/**
+ * @file OfflineRenderer.h
+ * Contains the OfflineRenderer class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_OFFLINERENDERER_H
+#define SDL_AUDIO_OFFLINERENDERER_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <SDL.h>
+
+#include "sdlpp/audio/Mixer.h"
+#include "sdlpp/misc/Clock.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @class OfflineRenderer
+     * @brief Renders a Mixer to memory or a wav file as fast as it will go, without an audio device.
+     *
+     * The Mixer is driven through Mixer::callback a buffer of the given size at a time, just as
+     * SDL would drive it, so voices, buses and effects run exactly as they do on a device. Commands
+     * sent to the Mixer between renders are taken at the start of the next buffer. The output is
+     * the same from run to run and from build to build, with or without SSE2, so hash can be
+     * checked against a known value; speed and throughput measure how much faster than real time
+     * the Mixer runs.
+     */
+    class OfflineRenderer {
+        public:
+            /**
+             * Constructs an OfflineRenderer.
+             *
+             * @param mixer The Mixer to render. It must not also be driven by an audio device.
+             * @param samples The buffer size in frames, as a device would be opened with.
+             *
+             * @throw runtime_error Throws a runtime_error if samples is 0.
+             */
+            OfflineRenderer (Mixer& mixer, unsigned int samples = 1024)
+              : mixer_ (mixer), buffer_ (samples * mixer.channels ()), frames_ (0), wall_ (0.0), voiceSeconds_ (0.0), hash_ (OFFSET) {
+                if (samples == 0)
+                    throw runtime_error ("The buffer size of an OfflineRenderer must not be 0.");
+            };
+
+            /**
+             * Renders frames, appending them to a buffer.
+             *
+             * @param frames The number of frames.
+             * @param out Receives the interleaved samples, after any already held.
+             *
+             * @return A reference to this OfflineRenderer.
+             */
+            OfflineRenderer& render (size_t frames, vector<Sint16>& out) {
+                size_t first = out.size ();
+                out.resize (first + frames * mixer_.channels ());
+                for (size_t done = 0; done < frames; ) {
+                    unsigned int n = next (frames - done);
+                    copy (buffer_.begin (), buffer_.begin () + n * mixer_.channels (), out.begin () + first + done * mixer_.channels ());
+                    done += n;
+                }
+                return *this;
+            };
+
+            /**
+             * Renders frames to a 16 bit PCM wav file, a buffer at a time.
+             *
+             * @param fileName The name of the file.
+             * @param frames The number of frames.
+             *
+             * @return A reference to this OfflineRenderer.
+             *
+             * @throw runtime_error Throws a runtime_error if the file could not be written.
+             */
+            OfflineRenderer& bounce (const string& fileName, size_t frames) {
+                FILE* file = fopen (fileName.c_str (), "wb");
+                if (file == NULL)
+                    throw runtime_error ("Unable to open " + fileName + " for writing.");
+                size_t bytes = frames * mixer_.channels () * sizeof (Sint16);
+                Uint8 header[HEADER_BYTES];
+                wavHeader (header, mixer_.rate (), mixer_.channels (), bytes);
+                bool ok = fwrite (header, sizeof (header), 1, file) == 1;
+
+                vector<Uint8> data (buffer_.size () * sizeof (Sint16));
+                for (size_t done = 0; ok && done < frames; ) {
+                    unsigned int n = next (frames - done);
+                    unsigned int count = n * mixer_.channels ();
+                    for (unsigned int i = 0; i < count; ++i) {
+                        Uint16 s = static_cast<Uint16> (buffer_[i]);
+                        data[2 * i] = static_cast<Uint8> (s);
+                        data[2 * i + 1] = static_cast<Uint8> (s >> 8);
+                    }
+                    ok = fwrite (&data[0], count * sizeof (Sint16), 1, file) == 1;
+                    done += n;
+                }
+                ok = fclose (file) == 0 && ok;
+                if (!ok)
+                    throw runtime_error ("Unable to write " + fileName + ".");
+                return *this;
+            };
+
+            /**
+             * Returns a hash of every sample rendered so far, to check the output against a known value.
+             *
+             * @return The 64 bit FNV-1a hash of the samples as little endian bytes.
+             */
+            Uint64 hash () const { return hash_; };
+
+            /**
+             * Returns the number of frames rendered.
+             *
+             * @return The number of frames.
+             */
+            size_t frames () const { return frames_; };
+
+            /**
+             * Returns the duration of the audio rendered.
+             *
+             * @return The duration in seconds.
+             */
+            double seconds () const { return static_cast<double> (frames_) / mixer_.rate (); };
+
+            /**
+             * Returns the time spent rendering.
+             *
+             * @return The wall clock time in seconds.
+             */
+            double wall () const { return wall_; };
+
+            /**
+             * Returns how much faster than real time the Mixer rendered.
+             *
+             * @return The seconds of audio rendered per second of wall clock time, 0 if nothing was rendered.
+             */
+            double speed () const { return wall_ > 0.0 ? seconds () / wall_ : 0.0; };
+
+            /**
+             * Returns the sum over each buffer of the voices playing after it times its duration.
+             *
+             * @return The voice seconds rendered.
+             */
+            double voiceSeconds () const { return voiceSeconds_; };
+
+            /**
+             * Returns the mixing throughput.
+             *
+             * @return The voice seconds rendered per second of wall clock time, 0 if nothing was rendered.
+             */
+            double throughput () const { return wall_ > 0.0 ? voiceSeconds_ / wall_ : 0.0; };
+
+            /**
+             * Clears the hash and the counts, leaving the Mixer as it is.
+             *
+             * @return A reference to this OfflineRenderer.
+             */
+            OfflineRenderer& reset () {
+                frames_ = 0;
+                wall_ = 0.0;
+                voiceSeconds_ = 0.0;
+                hash_ = OFFSET;
+                return *this;
+            };
+
+            /**
+             * Fills a canonical 16 bit PCM wav header.
+             *
+             * @param header Receives the HEADER_BYTES bytes of the header.
+             * @param rate The rate in frames per second.
+             * @param channels The number of interleaved channels.
+             * @param dataBytes The size of the data that follows in bytes.
+             */
+            static void wavHeader (Uint8* header, int rate, int channels, size_t dataBytes) {
+                Uint32 data = static_cast<Uint32> (min (dataBytes, static_cast<size_t> (0xffffffffu - (HEADER_BYTES - 8))));
+                memcpy (header, "RIFF", 4);
+                put32 (header + 4, data + HEADER_BYTES - 8);
+                memcpy (header + 8, "WAVEfmt ", 8);
+                put32 (header + 16, 16);
+                put16 (header + 20, 1);
+                put16 (header + 22, channels);
+                put32 (header + 24, rate);
+                put32 (header + 28, rate * channels * sizeof (Sint16));
+                put16 (header + 32, channels * sizeof (Sint16));
+                put16 (header + 34, 16);
+                memcpy (header + 36, "data", 4);
+                put32 (header + 40, data);
+            };
+
+            /**
+             * The size of the header written by wavHeader in bytes.
+             */
+            static const unsigned int HEADER_BYTES = 44;
+
+        private:
+            /**
+             * Copy constructs an OfflineRenderer.
+             *
+             * @param rhs The OfflineRenderer to copy.
+             */
+            OfflineRenderer (const OfflineRenderer& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The OfflineRenderer from which to assign.
+             *
+             * @return A reference to this OfflineRenderer.
+             */
+            OfflineRenderer& operator= (const OfflineRenderer& rhs);
+
+            /**
+             * The offset basis of the FNV-1a hash.
+             */
+            static const Uint64 OFFSET = 14695981039346656037ULL;
+
+            /**
+             * The prime of the FNV-1a hash.
+             */
+            static const Uint64 PRIME = 1099511628211ULL;
+
+            /**
+             * Renders the next buffer through the callback, hashing and counting it.
+             *
+             * @param remaining The number of frames still wanted.
+             *
+             * @return The number of frames rendered to buffer_, at most a buffer's worth.
+             */
+            unsigned int next (size_t remaining) {
+                unsigned int n = static_cast<unsigned int> (min (remaining, buffer_.size () / mixer_.channels ()));
+                unsigned int count = n * mixer_.channels ();
+                double start = misc::Clock::now ();
+                Mixer::callback (&mixer_, reinterpret_cast<Uint8*> (&buffer_[0]), static_cast<int> (count * sizeof (Sint16)));
+                wall_ += misc::Clock::now () - start;
+                mixer_.update ();
+
+                for (unsigned int i = 0; i < count; ++i) {
+                    Uint16 s = static_cast<Uint16> (buffer_[i]);
+                    hash_ = (hash_ ^ (s & 0xff)) * PRIME;
+                    hash_ = (hash_ ^ (s >> 8)) * PRIME;
+                }
+                frames_ += n;
+                voiceSeconds_ += static_cast<double> (mixer_.active ()) * n / mixer_.rate ();
+                return n;
+            };
+
+            /**
+             * Stores a 16 bit value little endian.
+             *
+             * @param out Receives the two bytes.
+             * @param value The value.
+             */
+            static void put16 (Uint8* out, unsigned int value) {
+                out[0] = static_cast<Uint8> (value);
+                out[1] = static_cast<Uint8> (value >> 8);
+            };
+
+            /**
+             * Stores a 32 bit value little endian.
+             *
+             * @param out Receives the four bytes.
+             * @param value The value.
+             */
+            static void put32 (Uint8* out, Uint32 value) {
+                put16 (out, value & 0xffff);
+                put16 (out + 2, value >> 16);
+            };
+
+            /**
+             * The Mixer rendered.
+             */
+            Mixer& mixer_;
+
+            /**
+             * One buffer of interleaved samples.
+             */
+            vector<Sint16> buffer_;
+
+            /**
+             * The number of frames rendered.
+             */
+            size_t frames_;
+
+            /**
+             * The time spent in the callback, in seconds.
+             */
+            double wall_;
+
+            /**
+             * The voice seconds rendered.
+             */
+            double voiceSeconds_;
+
+            /**
+             * The hash of the samples rendered.
+             */
+            Uint64 hash_;
+    }; //OfflineRenderer
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_OFFLINERENDERER_H
@@ -0,0 +1,372 @@
+/**
+ * @file Resampler.h
+ * Contains the Resampler class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_RESAMPLER_H
+#define SDL_AUDIO_RESAMPLER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <SDL.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @class Resampler
+     * @brief Converts 16 bit audio between any two rates with a polyphase windowed-sinc filter.
+     *
+     * The rate ratio is reduced to L / M and each output frame is the dot product of a run of
+     * input frames with one of up to MAX_PHASES Kaiser-windowed sinc filters, so timing is exact
+     * for any pair of rates and the filters are exact whenever L fits in the table, as it does for
+     * all the usual rates. The cutoff follows the lower of the two rates, so downsampling does not
+     * alias. Input may arrive in pieces of any size, and process neither allocates nor locks,
+     * so a Resampler can run inside the audio callback.
+     */
+    class Resampler {
+        public:
+            /**
+             * @enum Quality
+             * @brief The filter length and stopband rejection.
+             */
+            enum Quality {
+                FAST,   //8 taps, about 50 dB
+                MEDIUM, //16 taps, about 70 dB
+                BEST    //32 taps, about 90 dB
+            };
+
+            /**
+             * The largest number of filter phases tabulated.
+             */
+            static const unsigned int MAX_PHASES = 1024;
+
+            /**
+             * The number of input frames buffered per pass.
+             */
+            static const unsigned int CHUNK = 1024;
+
+            /**
+             * Constructs a Resampler.
+             *
+             * @param inRate The input rate in frames per second.
+             * @param outRate The output rate in frames per second.
+             * @param channels The number of interleaved channels.
+             * @param quality The filter quality.
+             *
+             * @throw runtime_error Throws a runtime_error if a rate or the number of channels is not positive.
+             */
+            Resampler (int inRate, int outRate, int channels, Quality quality = MEDIUM)
+              : up_ (0), down_ (0), channels_ (channels), taps_ (0), phases_ (0), coefficients_ (), buffer_ (), stride_ (0), filled_ (0), position_ (0), phase_ (0) {
+                if (inRate <= 0 || outRate <= 0 || channels <= 0)
+                    throw runtime_error ("Resampler rates and channels must be positive.");
+                unsigned int divisor = gcd (inRate, outRate);
+                up_ = outRate / divisor;
+                down_ = inRate / divisor;
+                design (quality);
+                stride_ = taps_ + CHUNK;
+                buffer_.resize (stride_ * channels_);
+                reset ();
+            };
+
+            /**
+             * Forgets the buffered input, to start a new stream.
+             *
+             * @return A reference to this Resampler.
+             */
+            Resampler& reset () {
+                fill (buffer_.begin (), buffer_.end (), 0.0f);
+                filled_ = taps_ / 2 - 1;
+                position_ = 0;
+                phase_ = 0;
+                return *this;
+            };
+
+            /**
+             * Returns the most frames process can produce from a number of input frames.
+             *
+             * @param frames The number of input frames.
+             *
+             * @return The number of output frames.
+             */
+            size_t maxOutput (size_t frames) const { return static_cast<size_t> ((static_cast<Uint64> (frames + taps_) * up_ + down_ - 1) / down_ + 1); };
+
+            /**
+             * Resamples a piece of a stream, consuming all of it and producing every frame it completes.
+             *
+             * @param in The interleaved input frames.
+             * @param frames The number of input frames.
+             * @param out Receives the interleaved output frames, with room for maxOutput (frames).
+             *
+             * @return The number of output frames.
+             */
+            size_t process (const Sint16* in, size_t frames, Sint16* out) {
+                size_t produced = 0;
+                while (frames > 0) {
+                    size_t n = min (frames, stride_ - filled_);
+                    for (int c = 0; c < channels_; ++c) {
+                        float* dst = &buffer_[c * stride_ + filled_];
+                        for (size_t i = 0; i < n; ++i)
+                            dst[i] = in[i * channels_ + c];
+                    }
+                    filled_ += n;
+                    in += n * channels_;
+                    frames -= n;
+                    produced += drain (out + produced * channels_);
+                }
+                return produced;
+            };
+
+            /**
+             * Ends a stream by feeding silence through the filter, producing the last frames.
+             *
+             * @param out Receives the interleaved output frames, with room for maxOutput (latency ()).
+             *
+             * @return The number of output frames.
+             */
+            size_t flush (Sint16* out) {
+                vector<Sint16> silence (latency () * channels_, 0);
+                return process (&silence[0], latency (), out);
+            };
+
+            /**
+             * Resamples a whole buffer, matching the start and length of the input.
+             *
+             * @param in The interleaved input frames.
+             * @param frames The number of input frames.
+             * @param out Receives the interleaved output frames.
+             *
+             * @return A reference to this Resampler.
+             */
+            Resampler& convert (const Sint16* in, size_t frames, vector<Sint16>& out) {
+                reset ();
+                out.resize ((maxOutput (frames) + maxOutput (latency ())) * channels_);
+                size_t produced = process (in, frames, &out[0]);
+                produced += flush (&out[produced * channels_]);
+                out.resize (min (produced, static_cast<size_t> ((static_cast<Uint64> (frames) * up_ + down_ - 1) / down_)) * channels_);
+                reset ();
+                return *this;
+            };
+
+            /**
+             * Returns the delay of the filter.
+             *
+             * @return The delay in input frames.
+             */
+            unsigned int latency () const { return taps_ / 2; };
+
+            /**
+             * Returns the number of taps of each filter phase.
+             *
+             * @return The number of taps.
+             */
+            unsigned int taps () const { return taps_; };
+
+            /**
+             * Returns the number of channels.
+             *
+             * @return The number of channels.
+             */
+            int channels () const { return channels_; };
+
+        private:
+            /**
+             * Returns the greatest common divisor of two rates.
+             *
+             * @param a A rate.
+             * @param b A rate.
+             *
+             * @return The greatest common divisor.
+             */
+            static unsigned int gcd (unsigned int a, unsigned int b) {
+                while (b != 0) {
+                    unsigned int r = a % b;
+                    a = b;
+                    b = r;
+                }
+                return a;
+            };
+
+            /**
+             * Evaluates the zeroth order modified Bessel function of the first kind.
+             *
+             * @param x The argument.
+             *
+             * @return I0 (x).
+             */
+            static double bessel (double x) {
+                double sum = 1.0, term = 1.0;
+                for (int k = 1; k < 50 && term > sum * 1e-12; ++k) {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum += term;
+                }
+                return sum;
+            };
+
+            /**
+             * Tabulates the filter phases, each normalized to unity gain.
+             *
+             * @param quality The filter quality.
+             */
+            void design (Quality quality) {
+                static const unsigned int lengths[] = { 8, 16, 32 };
+                static const double betas[] = { 5.0, 7.0, 9.0 };
+                static const double rolloffs[] = { 0.85, 0.9, 0.95 };
+                double cutoff = min (1.0, static_cast<double> (up_) / down_) * rolloffs[quality];
+                unsigned int scale = (down_ + up_ - 1) / up_;
+                taps_ = lengths[quality] * scale;
+                phases_ = min (up_, MAX_PHASES);
+                coefficients_.resize (phases_ * taps_);
+                double half = taps_ / 2.0;
+                for (unsigned int p = 0; p < phases_; ++p) {
+                    double frac = static_cast<double> (p) / phases_;
+                    double sum = 0.0;
+                    vector<double> h (taps_);
+                    for (unsigned int k = 0; k < taps_; ++k) {
+                        double x = static_cast<double> (k) - (half - 1.0) - frac;
+                        double r = x / half;
+                        double window = r * r < 1.0 ? bessel (betas[quality] * sqrt (1.0 - r * r)) / bessel (betas[quality]) : 0.0;
+                        double arg = M_PI * cutoff * x;
+                        h[k] = (x == 0.0 ? 1.0 : sin (arg) / arg) * window;
+                        sum += h[k];
+                    }
+                    for (unsigned int k = 0; k < taps_; ++k)
+                        coefficients_[p * taps_ + k] = static_cast<float> (h[k] / sum);
+                }
+            };
+
+            /**
+             * Produces every output frame the buffered input completes, then moves the unused input
+             * to the front of the buffer.
+             *
+             * @param out Receives the interleaved output frames.
+             *
+             * @return The number of output frames.
+             */
+            size_t drain (Sint16* out) {
+                size_t produced = 0;
+                while (position_ + taps_ <= filled_) {
+                    const float* h = &coefficients_[(phases_ == up_ ? phase_ : static_cast<Uint64> (phase_) * phases_ / up_) * taps_];
+                    for (int c = 0; c < channels_; ++c) {
+                        float sample = min (max (dot (&buffer_[c * stride_ + position_], h, taps_), -32768.0f), 32767.0f);
+                        out[produced * channels_ + c] = static_cast<Sint16> (lrintf (sample));
+                    }
+                    ++produced;
+                    phase_ += down_;
+                    position_ += phase_ / up_;
+                    phase_ %= up_;
+                }
+                for (int c = 0; c < channels_; ++c) {
+                    float* channel = &buffer_[c * stride_];
+                    memmove (channel, channel + position_, (filled_ - position_) * sizeof (float));
+                }
+                filled_ -= position_;
+                position_ = 0;
+                return produced;
+            };
+
+            /**
+             * Computes a dot product in four lanes, summed the same way with and without SSE2 so
+             * both give identical output.
+             *
+             * @param x The input frames of one channel.
+             * @param h The filter phase.
+             * @param n The number of taps, a multiple of 4.
+             *
+             * @return The dot product.
+             */
+            static float dot (const float* x, const float* h, unsigned int n) {
+#ifdef __SSE2__
+                __m128 acc = _mm_setzero_ps ();
+                for (unsigned int k = 0; k < n; k += 4)
+                    acc = _mm_add_ps (acc, _mm_mul_ps (_mm_loadu_ps (x + k), _mm_loadu_ps (h + k)));
+                acc = _mm_add_ps (acc, _mm_movehl_ps (acc, acc));
+                acc = _mm_add_ss (acc, _mm_shuffle_ps (acc, acc, 1));
+                return _mm_cvtss_f32 (acc);
+#else
+                float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (unsigned int k = 0; k < n; k += 4)
+                    for (unsigned int j = 0; j < 4; ++j)
+                        acc[j] += x[k + j] * h[k + j];
+                return (acc[0] + acc[2]) + (acc[1] + acc[3]);
+#endif
+            };
+
+            /**
+             * The reduced output and input rates, L and M.
+             */
+            unsigned int up_, down_;
+
+            /**
+             * The number of channels.
+             */
+            int channels_;
+
+            /**
+             * The number of taps of each filter phase.
+             */
+            unsigned int taps_;
+
+            /**
+             * The number of filter phases tabulated.
+             */
+            unsigned int phases_;
+
+            /**
+             * The filter phases, taps_ coefficients each.
+             */
+            vector<float> coefficients_;
+
+            /**
+             * The buffered input, one run of stride_ frames per channel.
+             */
+            vector<float> buffer_;
+
+            /**
+             * The number of frames buffered per channel at most.
+             */
+            size_t stride_;
+
+            /**
+             * The number of frames buffered.
+             */
+            size_t filled_;
+
+            /**
+             * The first buffered frame under the filter for the next output frame.
+             */
+            size_t position_;
+
+            /**
+             * The fractional position of the next output frame, in units of 1 / L input frames.
+             */
+            unsigned int phase_;
+    }; //Resampler
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_RESAMPLER_H
@@ -0,0 +1,299 @@
+/**
+ * @file Reverb.h
+ * Contains the Reverb class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_REVERB_H
+#define SDL_AUDIO_REVERB_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <SDL.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "sdlpp/audio/Effect.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @class Reverb
+     * @brief A small Schroeder reverberator: four damped combs in parallel, then two allpasses.
+     *
+     * The channels are summed into the reverberator, and each output channel has its own
+     * combs and allpasses, the right's slightly longer, for a wide tail. The four combs of a
+     * channel run side by side in one SSE2 register, with the same operations and the same
+     * order of summing without SSE2, so both give identical output. The room size and damping
+     * glide per block and the wet and dry gains ramp across each block.
+     */
+    class Reverb : public Effect {
+        public:
+            /**
+             * Constructs a Reverb.
+             *
+             * @param room The size of the room, from 0 for a short tail to 1 for a long one.
+             * @param damping The damping of high frequencies in the tail, from 0 to 1.
+             * @param wet The gain of the reverberation.
+             * @param dry The gain of the input.
+             */
+            Reverb (float room = 0.5f, float damping = 0.5f, float wet = 0.3f, float dry = 1.0f)
+              : room_ (room), damping_ (damping), wet_ (wet), dry_ (dry), rate_ (44100), channels_ (2), glide_ (1.0f),
+                lines_ (), allpasses_ (), wetGain_ (wet), dryGain_ (dry) {
+                prepare (44100, 2, 64);
+            };
+
+            /**
+             * Returns the size of the room, from 0 to 1.
+             *
+             * @return The Parameter.
+             */
+            Parameter& room () { return room_; };
+
+            /**
+             * Returns the damping, from 0 to 1.
+             *
+             * @return The Parameter.
+             */
+            Parameter& damping () { return damping_; };
+
+            /**
+             * Returns the gain of the reverberation.
+             *
+             * @return The Parameter.
+             */
+            Parameter& wet () { return wet_; };
+
+            /**
+             * Returns the gain of the input.
+             *
+             * @return The Parameter.
+             */
+            Parameter& dry () { return dry_; };
+
+            /**
+             * Readies the Reverb for a format, sizing its delay lines for the rate.
+             *
+             * @param rate The rate in frames per second.
+             * @param channels The number of interleaved channels, 1 or 2.
+             * @param block The largest number of frames passed to process.
+             */
+            virtual void prepare (int rate, int channels, unsigned int block) {
+                static const unsigned int combs[COMBS] = { 1116, 1188, 1277, 1356 };
+                static const unsigned int allpasses[ALLPASSES] = { 556, 441 };
+                static const unsigned int spread = 23;
+                rate_ = rate;
+                channels_ = channels;
+                glide_ = glide (rate, block, 0.05);
+                double scale = rate / 44100.0;
+                lines_.resize (2 * COMBS);
+                allpasses_.resize (2 * ALLPASSES);
+                for (unsigned int c = 0; c < 2; ++c) {
+                    for (unsigned int k = 0; k < COMBS; ++k)
+                        lines_[c * COMBS + k].assign (max (1u, static_cast<unsigned int> ((combs[k] + c * spread) * scale)), 0.0f);
+                    for (unsigned int k = 0; k < ALLPASSES; ++k)
+                        allpasses_[c * ALLPASSES + k].assign (max (1u, static_cast<unsigned int> ((allpasses[k] + c * spread) * scale)), 0.0f);
+                }
+                reset ();
+            };
+
+            /**
+             * Adds reverberation to a block in place.
+             *
+             * @param samples The interleaved samples.
+             * @param frames The number of frames.
+             */
+            virtual void process (float* samples, unsigned int frames) {
+                room_.smooth (glide_);
+                damping_.smooth (glide_);
+                wet_.smooth (glide_);
+                dry_.smooth (glide_);
+                float feedback = 0.7f + 0.28f * min (max (room_.value (), 0.0f), 1.0f);
+                float damp = 0.4f * min (max (damping_.value (), 0.0f), 1.0f);
+                float wetStep = (wet_.value () - wetGain_) / frames;
+                float dryStep = (dry_.value () - dryGain_) / frames;
+                const float input = 0.03f;
+
+                for (unsigned int i = 0; i < frames; ++i) {
+                    float* frame = samples + i * channels_;
+                    float in = (channels_ == 2 ? frame[0] + frame[1] : frame[0]) * input;
+                    float wet = wetGain_ + wetStep * static_cast<float> (i);
+                    float dry = dryGain_ + dryStep * static_cast<float> (i);
+                    for (int c = 0; c < channels_; ++c) {
+                        float out = comb (c, in, feedback, damp);
+                        for (unsigned int k = 0; k < ALLPASSES; ++k) {
+                            unsigned int a = c * ALLPASSES + k;
+                            float& delayed = allpasses_[a][allpassPositions_[a]];
+                            float next = delayed - out;
+                            delayed = out + delayed * 0.5f;
+                            out = next;
+                            if (++allpassPositions_[a] == allpasses_[a].size ())
+                                allpassPositions_[a] = 0;
+                        }
+                        frame[c] = frame[c] * dry + out * wet;
+                    }
+                }
+                wetGain_ = wet_.value ();
+                dryGain_ = dry_.value ();
+                for (unsigned int k = 0; k < 2 * COMBS; ++k)
+                    if (fabs (filters_[k]) < 1e-20f)
+                        filters_[k] = 0.0f;
+            };
+
+            /**
+             * Clears the tail and snaps the parameters.
+             */
+            virtual void reset () {
+                for (vector<vector<float> >::iterator l = lines_.begin (); l != lines_.end (); ++l)
+                    fill (l->begin (), l->end (), 0.0f);
+                for (vector<vector<float> >::iterator l = allpasses_.begin (); l != allpasses_.end (); ++l)
+                    fill (l->begin (), l->end (), 0.0f);
+                fill (positions_, positions_ + 2 * COMBS, 0u);
+                fill (allpassPositions_, allpassPositions_ + 2 * ALLPASSES, 0u);
+                fill (filters_, filters_ + 2 * COMBS, 0.0f);
+                room_.snap ();
+                damping_.snap ();
+                wetGain_ = wet_.snap ();
+                dryGain_ = dry_.snap ();
+            };
+
+        private:
+            /**
+             * The number of combs per channel.
+             */
+            static const unsigned int COMBS = 4;
+
+            /**
+             * The number of allpasses per channel.
+             */
+            static const unsigned int ALLPASSES = 2;
+
+            /**
+             * Runs one frame through the combs of a channel.
+             *
+             * @param c The channel.
+             * @param in The input.
+             * @param feedback The feedback of the combs.
+             * @param damp The damping of the combs.
+             *
+             * @return The sum of the combs' outputs.
+             */
+            float comb (int c, float in, float feedback, float damp) {
+                unsigned int first = c * COMBS;
+                float out[COMBS];
+                for (unsigned int k = 0; k < COMBS; ++k)
+                    out[k] = lines_[first + k][positions_[first + k]];
+#ifdef __SSE2__
+                __m128 o = _mm_loadu_ps (out);
+                __m128 f = _mm_add_ps (_mm_mul_ps (o, _mm_set1_ps (1.0f - damp)), _mm_mul_ps (_mm_loadu_ps (filters_ + first), _mm_set1_ps (damp)));
+                _mm_storeu_ps (filters_ + first, f);
+                float stored[COMBS];
+                _mm_storeu_ps (stored, _mm_add_ps (_mm_set1_ps (in), _mm_mul_ps (f, _mm_set1_ps (feedback))));
+                __m128 sum = _mm_add_ps (o, _mm_movehl_ps (o, o));
+                sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+                float total = _mm_cvtss_f32 (sum);
+#else
+                float stored[COMBS];
+                for (unsigned int k = 0; k < COMBS; ++k) {
+                    filters_[first + k] = out[k] * (1.0f - damp) + filters_[first + k] * damp;
+                    stored[k] = in + filters_[first + k] * feedback;
+                }
+                float total = (out[0] + out[2]) + (out[1] + out[3]);
+#endif
+                for (unsigned int k = 0; k < COMBS; ++k) {
+                    lines_[first + k][positions_[first + k]] = stored[k];
+                    if (++positions_[first + k] == lines_[first + k].size ())
+                        positions_[first + k] = 0;
+                }
+                return total;
+            };
+
+            /**
+             * The size of the room.
+             */
+            Parameter room_;
+
+            /**
+             * The damping.
+             */
+            Parameter damping_;
+
+            /**
+             * The gain of the reverberation.
+             */
+            Parameter wet_;
+
+            /**
+             * The gain of the input.
+             */
+            Parameter dry_;
+
+            /**
+             * The rate.
+             */
+            int rate_;
+
+            /**
+             * The number of channels.
+             */
+            int channels_;
+
+            /**
+             * The per block share by which the parameters glide.
+             */
+            float glide_;
+
+            /**
+             * The comb delay lines, COMBS per channel.
+             */
+            vector<vector<float> > lines_;
+
+            /**
+             * The allpass delay lines, ALLPASSES per channel.
+             */
+            vector<vector<float> > allpasses_;
+
+            /**
+             * The position in each comb delay line.
+             */
+            unsigned int positions_[2 * COMBS];
+
+            /**
+             * The position in each allpass delay line.
+             */
+            unsigned int allpassPositions_[2 * ALLPASSES];
+
+            /**
+             * The damping filter memory of each comb.
+             */
+            float filters_[2 * COMBS];
+
+            /**
+             * The wet and dry gains reached at the end of the last block.
+             */
+            float wetGain_, dryGain_;
+    }; //Reverb
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_REVERB_H
@@ -0,0 +1,187 @@
+/**
+ * @file Sample.h
+ * Contains the Sample class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_SAMPLE_H
+#define SDL_AUDIO_SAMPLE_H
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/audio/Wav.h"
+#include "sdlpp/audio/Resampler.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @class Sample
+     * @brief Immutable 16 bit PCM audio at the mixer's rate, shared between copies.
+     *
+     * Frames are interleaved signed 16 bit samples in native byte order, one or two channels.
+     * Copies share the data, so a Sample can be handed to the Mixer cheaply. The data is either
+     * owned by the Sample or a view into memory kept alive by a shared owner, such as a mapped file.
+     */
+    class Sample {
+        public:
+            /**
+             * Constructs an empty Sample.
+             */
+            Sample () : owner_ (), data_ (NULL), count_ (0), channels_ (1) {};
+
+            /**
+             * Constructs a Sample from frames, taking their contents.
+             *
+             * @param frames The interleaved samples, emptied.
+             * @param channels The number of channels, 1 or 2.
+             *
+             * @throw runtime_error Throws a runtime_error if the number of channels is not 1 or 2.
+             */
+            Sample (vector<Sint16>& frames, int channels) : owner_ (), data_ (NULL), count_ (0), channels_ (channels) {
+                if (channels != 1 && channels != 2)
+                    throw runtime_error ("Samples have 1 or 2 channels.");
+                adopt (frames);
+            };
+
+            /**
+             * Constructs a Sample viewing frames owned by something else.
+             *
+             * @param owner Keeps the frames alive for as long as any copy of the Sample.
+             * @param data The interleaved samples, aligned to 2 bytes.
+             * @param frames The number of frames.
+             * @param channels The number of channels, 1 or 2.
+             *
+             * @throw runtime_error Throws a runtime_error if the number of channels is not 1 or 2.
+             */
+            Sample (const boost::shared_ptr<const void>& owner, const Sint16* data, size_t frames, int channels)
+              : owner_ (owner), data_ (frames == 0 ? NULL : data), count_ (frames * channels), channels_ (channels) {
+                if (channels != 1 && channels != 2)
+                    throw runtime_error ("Samples have 1 or 2 channels.");
+            };
+
+            /**
+             * Constructs a Sample by converting a Wav. SDL converts the format and channels, and a
+             * Resampler converts the rate, since SDL only resamples by powers of two.
+             *
+             * @param wav The Wav.
+             * @param rate The rate of the Sample in frames per second.
+             * @param channels The largest number of channels, 1 or 2. Mono Wavs stay mono.
+             * @param quality The quality of the rate conversion.
+             *
+             * @throw runtime_error Throws a runtime_error if the Wav cannot be converted.
+             */
+            Sample (const Wav& wav, int rate, int channels, Resampler::Quality quality = Resampler::MEDIUM)
+              : owner_ (), data_ (NULL), count_ (0), channels_ (min (static_cast<int> (wav.spec_.channels), channels)) {
+                if (channels_ != 1 && channels_ != 2)
+                    throw runtime_error (wav.name_ + " has an unsupported number of channels.");
+                SDL_AudioCVT cvt;
+                if (SDL_BuildAudioCVT (&cvt, wav.spec_.format, wav.spec_.channels, wav.spec_.freq, AUDIO_S16SYS, channels_, wav.spec_.freq) == -1)
+                    throw runtime_error (SDL_GetError ());
+                vector<Uint8> buffer (wav.audioLen_ * cvt.len_mult);
+                if (!buffer.empty ())
+                    memcpy (&buffer[0], wav.audioBuf_, wav.audioLen_);
+                cvt.buf = buffer.empty () ? NULL : &buffer[0];
+                cvt.len = wav.audioLen_;
+                if (SDL_ConvertAudio (&cvt) == -1)
+                    throw runtime_error (SDL_GetError ());
+                vector<Sint16> data (cvt.len_cvt / sizeof (Sint16));
+                if (!data.empty ())
+                    memcpy (&data[0], &buffer[0], data.size () * sizeof (Sint16));
+                if (wav.spec_.freq != rate && !data.empty ()) {
+                    vector<Sint16> resampled;
+                    Resampler (wav.spec_.freq, rate, channels_, quality).convert (&data[0], data.size () / channels_, resampled);
+                    data.swap (resampled);
+                }
+                adopt (data);
+            };
+
+            /**
+             * Returns the interleaved samples.
+             *
+             * @return The samples, NULL if empty.
+             */
+            const Sint16* data () const { return data_; };
+
+            /**
+             * Returns the number of frames.
+             *
+             * @return The number of frames.
+             */
+            size_t frames () const { return count_ / channels_; };
+
+            /**
+             * Returns the number of channels.
+             *
+             * @return 1 or 2.
+             */
+            int channels () const { return channels_; };
+
+            /**
+             * Returns the size of the data in bytes.
+             *
+             * @return The size in bytes.
+             */
+            size_t bytes () const { return count_ * sizeof (Sint16); };
+
+        private:
+            /**
+             * Takes the contents of frames as the data.
+             *
+             * @param frames The interleaved samples, emptied.
+             */
+            void adopt (vector<Sint16>& frames) {
+                boost::shared_ptr<vector<Sint16> > data (new vector<Sint16> ());
+                data->swap (frames);
+                owner_ = data;
+                data_ = data->empty () ? NULL : &(*data)[0];
+                count_ = data->size ();
+            };
+
+            /**
+             * Keeps the data alive.
+             */
+            boost::shared_ptr<const void> owner_;
+
+            /**
+             * The interleaved samples.
+             */
+            const Sint16* data_;
+
+            /**
+             * The number of samples, frames times channels.
+             */
+            size_t count_;
+
+            /**
+             * The number of channels.
+             */
+            int channels_;
+    }; //Sample
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_SAMPLE_H
@@ -0,0 +1,394 @@
+/**
+ * @file SampleBank.h
+ * Contains the SampleBank class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_SAMPLEBANK_H
+#define SDL_AUDIO_SAMPLEBANK_H
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/misc/MappedFile.h"
+#include "sdlpp/audio/WavHeader.h"
+#include "sdlpp/audio/Resampler.h"
+#include "sdlpp/audio/Sample.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+    using namespace misc;
+
+    /**
+     * @class SampleBank
+     * @brief Loads wav files once each, sharing them between every user.
+     *
+     * Files are memory mapped and their headers validated. 16 bit PCM already at the output rate
+     * and channels is not copied at all: the Sample is a view into the mapping, which stays
+     * mapped for as long as any copy of the Sample lives, and only the pages played become
+     * resident. Other files are decoded and converted once, and stay mapped while held by the
+     * SampleBank so duplicates can be compared against them. A file loaded again under the same
+     * path, or under another path with the same format and data, returns the same Sample. Only
+     * a file whose format and size match one already loaded has its data compared, byte for
+     * byte against that file, so loading other files in place reads no more than their headers.
+     */
+    class SampleBank {
+        public:
+            /**
+             * Constructs an empty SampleBank.
+             *
+             * @param rate The output rate in frames per second.
+             * @param channels The number of output channels, 1 or 2.
+             * @param quality The quality of rate conversions.
+             */
+            SampleBank (int rate, int channels, Resampler::Quality quality = Resampler::MEDIUM)
+              : paths_ (), contents_ (), rate_ (rate), channels_ (channels), quality_ (quality), mappedBytes_ (0), ownedBytes_ (0), shared_ (0) {};
+
+            /**
+             * Destroys the SampleBank. Samples still in use stay valid.
+             */
+            ~SampleBank () {};
+
+            /**
+             * Returns the Sample of a wav file, loading it on first use.
+             *
+             * @param fileName The name of the wav file.
+             *
+             * @return The Sample.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to map the file or it is not a supported wav file.
+             */
+            Sample load (const string& fileName) {
+                string path = canonical (fileName);
+                Paths::iterator known = paths_.find (path);
+                if (known != paths_.end ())
+                    return known->second->second.sample_;
+
+                boost::shared_ptr<MappedFile> file (new MappedFile (fileName));
+                WavHeader header;
+                header.parse (file->data (), file->size (), fileName);
+                const Uint8* data = file->data () + header.dataOffset_;
+                Uint64 key = signature (header);
+
+                pair<Contents::iterator, Contents::iterator> candidates = contents_.equal_range (key);
+                Contents::iterator same = candidates.second;
+                for (Contents::iterator cur = candidates.first; cur != candidates.second; ++cur) {
+                    if (identical (cur->second, header, data)) {
+                        same = cur;
+                        break;
+                    }
+                }
+                if (same == candidates.second) {
+                    Content content = { convert (file, header, data), direct (header), 0, file, header };
+                    same = contents_.insert (make_pair (key, content));
+                    (content.mapped_ ? mappedBytes_ : ownedBytes_) += content.sample_.bytes ();
+                } else {
+                    ++shared_;
+                }
+                ++same->second.paths_;
+                paths_.insert (make_pair (path, same));
+                return same->second.sample_;
+            };
+
+            /**
+             * Determines if a wav file is loaded.
+             *
+             * @param fileName The name of the wav file.
+             *
+             * @return True if loaded, false otherwise.
+             */
+            bool contains (const string& fileName) const { return paths_.find (canonical (fileName)) != paths_.end (); };
+
+            /**
+             * Forgets a wav file. Its Sample stays valid while in use and is dropped by the
+             * SampleBank once no other loaded path shares it.
+             *
+             * @param fileName The name of the wav file.
+             *
+             * @return A reference to this SampleBank.
+             */
+            SampleBank& release (const string& fileName) {
+                Paths::iterator known = paths_.find (canonical (fileName));
+                if (known == paths_.end ())
+                    return *this;
+                Contents::iterator content = known->second;
+                paths_.erase (known);
+                if (--content->second.paths_ == 0) {
+                    (content->second.mapped_ ? mappedBytes_ : ownedBytes_) -= content->second.sample_.bytes ();
+                    contents_.erase (content);
+                }
+                return *this;
+            };
+
+            /**
+             * Forgets every wav file.
+             *
+             * @return A reference to this SampleBank.
+             */
+            SampleBank& clear () {
+                paths_.clear ();
+                contents_.clear ();
+                mappedBytes_ = ownedBytes_ = 0;
+                return *this;
+            };
+
+            /**
+             * Returns the number of wav files loaded.
+             *
+             * @return The number of files.
+             */
+            size_t size () const { return paths_.size (); };
+
+            /**
+             * Returns the number of distinct Samples held.
+             *
+             * @return The number of Samples.
+             */
+            size_t unique () const { return contents_.size (); };
+
+            /**
+             * Returns the number of bytes of samples viewed in place in mapped files.
+             *
+             * @return The number of bytes.
+             */
+            size_t mappedBytes () const { return mappedBytes_; };
+
+            /**
+             * Returns the number of bytes of samples converted into memory.
+             *
+             * @return The number of bytes.
+             */
+            size_t ownedBytes () const { return ownedBytes_; };
+
+            /**
+             * Returns the number of files found to duplicate another file's contents.
+             *
+             * @return The number of files.
+             */
+            unsigned int shared () const { return shared_; };
+
+        private:
+            /**
+             * Copy constructs a SampleBank.
+             *
+             * @param rhs The SampleBank to copy.
+             */
+            SampleBank (const SampleBank& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The SampleBank from which to assign.
+             *
+             * @return A reference to this SampleBank.
+             */
+            SampleBank& operator= (const SampleBank& rhs);
+
+            /**
+             * @struct Content
+             * @brief A distinct Sample.
+             */
+            struct Content {
+                /**
+                 * The Sample.
+                 */
+                Sample sample_;
+
+                /**
+                 * Whether or not the Sample views a mapped file.
+                 */
+                bool mapped_;
+
+                /**
+                 * The number of loaded paths sharing the Sample.
+                 */
+                unsigned int paths_;
+
+                /**
+                 * The mapping of the file first loaded for the Sample, kept so later files are compared
+                 * against its data without mapping it again.
+                 */
+                boost::shared_ptr<MappedFile> file_;
+
+                /**
+                 * The WavHeader of the file first loaded for the Sample.
+                 */
+                WavHeader header_;
+            }; //Content
+
+            /**
+             * @typedef multimap<Uint64, Content> Contents
+             * @brief The type of the distinct Samples by the hash of their format and size.
+             */
+            typedef multimap<Uint64, Content> Contents;
+
+            /**
+             * @typedef map<string, Contents::iterator> Paths
+             * @brief The type of the loaded paths, each with its Sample.
+             */
+            typedef map<string, Contents::iterator> Paths;
+
+            /**
+             * Resolves a file name to one path per file.
+             *
+             * @param fileName The name of the file.
+             *
+             * @return The absolute path without links, or the name itself if it cannot be resolved.
+             */
+            static string canonical (const string& fileName) {
+#ifndef _WIN32
+                char path[PATH_MAX];
+                if (realpath (fileName.c_str (), path) != NULL)
+                    return path;
+#endif
+                return fileName;
+            };
+
+            /**
+             * Hashes the format and data size of a file with 64 bit FNV-1a, reading only the header.
+             *
+             * @param header The WavHeader of the file.
+             *
+             * @return The hash.
+             */
+            static Uint64 signature (const WavHeader& header) {
+                Uint64 h = 14695981039346656037ULL;
+                const Uint32 format[] = { static_cast<Uint32> (header.encoding_), static_cast<Uint32> (header.channels_), static_cast<Uint32> (header.rate_),
+                                          static_cast<Uint32> (header.bits_), header.blockAlign_, header.framesPerBlock_, header.dataBytes_ };
+                const Uint8* bytes = reinterpret_cast<const Uint8*> (format);
+                for (size_t i = 0; i < sizeof (format); ++i)
+                    h = (h ^ bytes[i]) * 1099511628211ULL;
+                return h;
+            };
+
+            /**
+             * Determines if a file holds the same format and data as the file of a loaded Sample,
+             * comparing the data byte for byte.
+             *
+             * @param content The loaded Sample.
+             * @param header The WavHeader of the file.
+             * @param data The data of the file.
+             *
+             * @return True if identical, false otherwise.
+             */
+            static bool identical (const Content& content, const WavHeader& header, const Uint8* data) {
+                const WavHeader& other = content.header_;
+                return other.encoding_ == header.encoding_ && other.channels_ == header.channels_ && other.rate_ == header.rate_
+                    && other.bits_ == header.bits_ && other.blockAlign_ == header.blockAlign_ && other.framesPerBlock_ == header.framesPerBlock_
+                    && other.dataBytes_ == header.dataBytes_ && memcmp (content.file_->data () + other.dataOffset_, data, header.dataBytes_) == 0;
+            };
+
+            /**
+             * Determines if a file can be played in place.
+             *
+             * @param header The WavHeader of the file.
+             *
+             * @return True if the data is native 16 bit PCM at the output rate and channels, false otherwise.
+             */
+            bool direct (const WavHeader& header) const {
+                return header.encoding_ == WavHeader::PCM && header.bits_ == 16 && header.rate_ == rate_ && header.channels_ <= channels_
+                    && header.dataOffset_ % 2 == 0 && SDL_BYTEORDER == SDL_LIL_ENDIAN;
+            };
+
+            /**
+             * Makes the Sample of a file, a view into the mapping if possible and a converted copy otherwise.
+             *
+             * @param file The mapped file.
+             * @param header The WavHeader of the file.
+             * @param data The data.
+             *
+             * @return The Sample.
+             */
+            Sample convert (const boost::shared_ptr<MappedFile>& file, const WavHeader& header, const Uint8* data) const {
+                size_t frames = header.frames ();
+                if (direct (header))
+                    return Sample (file, reinterpret_cast<const Sint16*> (data), frames, header.channels_);
+
+                vector<Sint16> decoded (frames * header.channels_);
+                size_t done = 0;
+                for (Uint32 offset = 0; offset < header.dataBytes_ && done < frames; offset += header.encoding_ == WavHeader::PCM ? header.dataBytes_ : header.blockAlign_) {
+                    unsigned int bytes = min (header.dataBytes_ - offset, header.encoding_ == WavHeader::PCM ? header.dataBytes_ : header.blockAlign_);
+                    done += header.decode (data + offset, bytes, &decoded[done * header.channels_]);
+                }
+                int channels = min (header.channels_, channels_);
+                if (channels != header.channels_) {
+                    for (size_t i = 0; i < frames; ++i)
+                        decoded[i] = static_cast<Sint16> ((decoded[2 * i] + decoded[2 * i + 1]) >> 1);
+                    decoded.resize (frames);
+                }
+                if (header.rate_ != rate_ && frames != 0) {
+                    vector<Sint16> resampled;
+                    Resampler (header.rate_, rate_, channels, quality_).convert (&decoded[0], frames, resampled);
+                    decoded.swap (resampled);
+                }
+                return Sample (decoded, channels);
+            };
+
+            /**
+             * The loaded paths.
+             */
+            Paths paths_;
+
+            /**
+             * The distinct Samples.
+             */
+            Contents contents_;
+
+            /**
+             * The output rate.
+             */
+            int rate_;
+
+            /**
+             * The number of output channels.
+             */
+            int channels_;
+
+            /**
+             * The quality of rate conversions.
+             */
+            Resampler::Quality quality_;
+
+            /**
+             * The number of bytes of samples viewed in place.
+             */
+            size_t mappedBytes_;
+
+            /**
+             * The number of bytes of samples converted into memory.
+             */
+            size_t ownedBytes_;
+
+            /**
+             * The number of files found to duplicate another file's contents.
+             */
+            unsigned int shared_;
+    }; //SampleBank
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_SAMPLEBANK_H
@@ -0,0 +1,301 @@
+/**
+ * @file SampleCache.h
+ * Contains the SampleCache class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_SAMPLECACHE_H
+#define SDL_AUDIO_SAMPLECACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <stdexcept>
+
+#include <SDL.h>
+
+#include "sdlpp/audio/Wav.h"
+#include "sdlpp/audio/Sample.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @class SampleCache
+     * @brief Memoizes Wavs converted to the output format.
+     *
+     * Converting a Wav resamples and reformats every sample, so it is done once per file, at
+     * load time or on first play, and the converted Sample is handed back until evicted. Samples
+     * are keyed by file name. The bytes held are bounded, the least recently used Samples are
+     * dropped first; a dropped Sample still playing stays alive until its voice finishes.
+     */
+    class SampleCache {
+        public:
+            /**
+             * Constructs an empty SampleCache.
+             *
+             * @param rate The output rate in frames per second.
+             * @param channels The number of output channels, 1 or 2.
+             * @param maxBytes The maximum number of bytes of samples to hold.
+             */
+            SampleCache (int rate, int channels, size_t maxBytes = 16 << 20)
+              : entries_ (), order_ (), rate_ (rate), channels_ (channels), bytes_ (0), maxBytes_ (maxBytes), misses_ (0) {};
+
+            /**
+             * Destroys the SampleCache.
+             */
+            ~SampleCache () {};
+
+            /**
+             * Returns the converted copy of a Wav, converting it on first use.
+             *
+             * @param wav The Wav to convert.
+             *
+             * @return The Sample.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to convert the Wav.
+             */
+            Sample get (const Wav& wav) {
+                Entries::iterator cur = entries_.find (wav.name_);
+                if (cur != entries_.end ())
+                    return touch (cur);
+                return insert (wav.name_, Sample (wav, rate_, channels_));
+            };
+
+            /**
+             * Returns the converted copy of a wav file, loading and converting it on first use.
+             *
+             * @param fileName The name of the wav file.
+             *
+             * @return The Sample.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to load or convert the file.
+             */
+            Sample load (const string& fileName) {
+                Entries::iterator cur = entries_.find (fileName);
+                if (cur != entries_.end ())
+                    return touch (cur);
+                Wav wav (fileName);
+                return insert (fileName, Sample (wav, rate_, channels_));
+            };
+
+            /**
+             * Determines if a wav file is held.
+             *
+             * @param fileName The name of the wav file.
+             *
+             * @return True if held, false otherwise.
+             */
+            bool contains (const string& fileName) const { return entries_.find (fileName) != entries_.end (); };
+
+            /**
+             * Drops the converted copy of a wav file.
+             *
+             * @param fileName The name of the wav file.
+             *
+             * @return A reference to this SampleCache.
+             */
+            SampleCache& release (const string& fileName) {
+                Entries::iterator cur = entries_.find (fileName);
+                if (cur != entries_.end ())
+                    erase (cur);
+                return *this;
+            };
+
+            /**
+             * Drops all converted copies.
+             *
+             * @return A reference to this SampleCache.
+             */
+            SampleCache& clear () {
+                entries_.clear ();
+                order_.clear ();
+                bytes_ = 0;
+                return *this;
+            };
+
+            /**
+             * Changes the output format, dropping every copy if it differs.
+             *
+             * @param rate The output rate in frames per second.
+             * @param channels The number of output channels, 1 or 2.
+             *
+             * @return A reference to this SampleCache.
+             */
+            SampleCache& retarget (int rate, int channels) {
+                if (rate != rate_ || channels != channels_)
+                    clear ();
+                rate_ = rate;
+                channels_ = channels;
+                return *this;
+            };
+
+            /**
+             * Returns the number of converted copies held.
+             *
+             * @return The number of converted copies.
+             */
+            size_t size () const { return entries_.size (); };
+
+            /**
+             * Returns the number of bytes of samples held.
+             *
+             * @return The number of bytes.
+             */
+            size_t bytes () const { return bytes_; };
+
+            /**
+             * Returns the maximum number of bytes of samples to hold.
+             *
+             * @return The number of bytes.
+             */
+            size_t maxBytes () const { return maxBytes_; };
+
+            /**
+             * Returns the number of conversions done, each a miss.
+             *
+             * @return The number of conversions.
+             */
+            unsigned int misses () const { return misses_; };
+
+        private:
+            /**
+             * Copy constructs a SampleCache.
+             *
+             * @param rhs The SampleCache to copy.
+             */
+            SampleCache (const SampleCache& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The SampleCache from which to assign.
+             *
+             * @return A reference to this SampleCache.
+             */
+            SampleCache& operator= (const SampleCache& rhs);
+
+            /**
+             * @struct Entry
+             * @brief A converted copy.
+             */
+            struct Entry {
+                /**
+                 * The converted copy.
+                 */
+                Sample sample_;
+
+                /**
+                 * The position of the file name in the use order.
+                 */
+                list<string>::iterator use_;
+            }; //Entry
+
+            /**
+             * @typedef map<string, Entry> Entries
+             * @brief The type of the cached copies.
+             */
+            typedef map<string, Entry> Entries;
+
+            /**
+             * Marks a copy most recently used.
+             *
+             * @param cur The copy.
+             *
+             * @return The Sample.
+             */
+            Sample touch (Entries::iterator cur) {
+                order_.splice (order_.end (), order_, cur->second.use_);
+                return cur->second.sample_;
+            };
+
+            /**
+             * Adds a copy.
+             *
+             * @param fileName The name of the wav file.
+             * @param sample The converted copy.
+             *
+             * @return The Sample.
+             */
+            Sample insert (const string& fileName, const Sample& sample) {
+                ++misses_;
+                Entry entry = { sample, order_.insert (order_.end (), fileName) };
+                entries_.insert (make_pair (fileName, entry));
+                bytes_ += sample.bytes ();
+                evict ();
+                return sample;
+            };
+
+            /**
+             * Drops a copy.
+             *
+             * @param cur The copy.
+             */
+            void erase (Entries::iterator cur) {
+                bytes_ -= cur->second.sample_.bytes ();
+                order_.erase (cur->second.use_);
+                entries_.erase (cur);
+            };
+
+            /**
+             * Drops the least recently used copies until the bound is met, always keeping the most recent.
+             */
+            void evict () {
+                while (bytes_ > maxBytes_ && order_.size () > 1)
+                    erase (entries_.find (order_.front ()));
+            };
+
+            /**
+             * The cached copies.
+             */
+            Entries entries_;
+
+            /**
+             * The file names from least to most recently used.
+             */
+            list<string> order_;
+
+            /**
+             * The output rate.
+             */
+            int rate_;
+
+            /**
+             * The number of output channels.
+             */
+            int channels_;
+
+            /**
+             * The number of bytes of samples held.
+             */
+            size_t bytes_;
+
+            /**
+             * The maximum number of bytes of samples to hold.
+             */
+            size_t maxBytes_;
+
+            /**
+             * The number of conversions done.
+             */
+            unsigned int misses_;
+    }; //SampleCache
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_SAMPLECACHE_H
@@ -0,0 +1,313 @@
+/**
+ * @file WavHeader.h
+ * Contains the WavHeader struct.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_WAVHEADER_H
+#define SDL_AUDIO_WAVHEADER_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include <SDL.h>
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+
+    /**
+     * @struct WavHeader
+     * @brief The format and data location of a RIFF WAVE file.
+     *
+     * Supports 8 and 16 bit PCM and 4 bit IMA ADPCM, mono or stereo. The header can be read
+     * from an open file, leaving the data to be streamed, or parsed from a file in memory, and
+     * decodes the data a run of frames or a block at a time.
+     */
+    struct WavHeader {
+        /**
+         * @enum Encoding
+         * @brief The format tags supported.
+         */
+        enum Encoding {
+            PCM = 0x0001,
+            IMA_ADPCM = 0x0011
+        };
+
+        /**
+         * Constructs an empty WavHeader.
+         */
+        WavHeader () : encoding_ (PCM), channels_ (0), rate_ (0), bits_ (0), blockAlign_ (0), framesPerBlock_ (1), dataOffset_ (0), dataBytes_ (0) {};
+
+        /**
+         * Reads the header of an open file, leaving it positioned at the start of the data.
+         *
+         * @param file The file, positioned at its start.
+         * @param name The name of the file, for errors.
+         *
+         * @throw runtime_error Throws a runtime_error if the file is not a supported wav file.
+         */
+        void read (FILE* file, const string& name) {
+            Uint8 riff[12];
+            if (fread (riff, sizeof (riff), 1, file) != 1 || memcmp (riff, "RIFF", 4) != 0 || memcmp (riff + 8, "WAVE", 4) != 0)
+                throw runtime_error (name + " is not a wav file.");
+            long offset = sizeof (riff);
+            bool format = false;
+            Uint8 chunk[8];
+            while (fread (chunk, sizeof (chunk), 1, file) == 1) {
+                Uint32 size = le32 (chunk + 4);
+                offset += sizeof (chunk);
+                if (memcmp (chunk, "fmt ", 4) == 0) {
+                    Uint8 fmt[20] = { 0 };
+                    if (size < 16 || fread (fmt, min (size, static_cast<Uint32> (sizeof (fmt))), 1, file) != 1)
+                        break;
+                    parseFormat (fmt, size, name);
+                    format = true;
+                } else if (memcmp (chunk, "data", 4) == 0) {
+                    if (!format)
+                        break;
+                    dataOffset_ = offset;
+                    dataBytes_ = size;
+                    fseek (file, 0, SEEK_END);
+                    long end = ftell (file);
+                    if (end >= offset && static_cast<Uint32> (end - offset) < dataBytes_)
+                        dataBytes_ = end - offset;
+                    fseek (file, offset, SEEK_SET);
+                    return;
+                }
+                offset += size + (size & 1);
+                if (fseek (file, offset, SEEK_SET) != 0)
+                    break;
+            }
+            throw runtime_error (name + " has no wav format or data.");
+        };
+
+        /**
+         * Parses the header of a file in memory.
+         *
+         * @param data The file.
+         * @param size The size of the file in bytes.
+         * @param name The name of the file, for errors.
+         *
+         * @throw runtime_error Throws a runtime_error if the file is not a supported wav file.
+         */
+        void parse (const Uint8* data, size_t size, const string& name) {
+            if (size < 12 || memcmp (data, "RIFF", 4) != 0 || memcmp (data + 8, "WAVE", 4) != 0)
+                throw runtime_error (name + " is not a wav file.");
+            size_t offset = 12;
+            bool format = false;
+            while (offset + 8 <= size) {
+                Uint32 length = le32 (data + offset + 4);
+                const Uint8* body = data + offset + 8;
+                size_t available = size - offset - 8;
+                if (memcmp (data + offset, "fmt ", 4) == 0) {
+                    if (length < 16 || available < 16)
+                        break;
+                    parseFormat (body, min (static_cast<size_t> (length), available), name);
+                    format = true;
+                } else if (memcmp (data + offset, "data", 4) == 0) {
+                    if (!format)
+                        break;
+                    dataOffset_ = offset + 8;
+                    dataBytes_ = min (static_cast<size_t> (length), available);
+                    return;
+                }
+                offset += 8 + static_cast<size_t> (length) + (length & 1);
+            }
+            throw runtime_error (name + " has no wav format or data.");
+        };
+
+        /**
+         * Returns the number of frames of audio, counting a short last ADPCM block.
+         *
+         * @return The number of frames.
+         */
+        size_t frames () const { return static_cast<size_t> (dataBytes_ / blockAlign_) * framesPerBlock_ + blockFrames (dataBytes_ % blockAlign_); };
+
+        /**
+         * Returns the number of frames in a block of a given size.
+         *
+         * @param bytes The size of the block in bytes, at most blockAlign_.
+         *
+         * @return The number of frames, 0 if the block is too short to hold any.
+         */
+        unsigned int blockFrames (unsigned int bytes) const {
+            if (encoding_ == PCM)
+                return bytes / blockAlign_;
+            return bytes < 4u * channels_ ? 0 : (bytes - 4 * channels_) / (4 * channels_) * 8 + 1;
+        };
+
+        /**
+         * Returns the duration of the audio.
+         *
+         * @return The duration in seconds.
+         */
+        double duration () const { return static_cast<double> (frames ()) / rate_; };
+
+        /**
+         * Decodes a run of PCM frames or one ADPCM block to interleaved 16 bit samples.
+         *
+         * @param data The encoded bytes.
+         * @param bytes The number of bytes, at most blockAlign_ for ADPCM.
+         * @param out Receives the samples, with room for framesPerBlock_ frames for ADPCM.
+         *
+         * @return The number of frames.
+         */
+        unsigned int decode (const Uint8* data, unsigned int bytes, Sint16* out) const {
+            unsigned int frames = encoding_ == PCM ? bytes / blockAlign_ : blockFrames (bytes);
+            if (encoding_ == PCM) {
+                unsigned int count = frames * channels_;
+                if (bits_ == 8) {
+                    for (unsigned int i = 0; i < count; ++i)
+                        out[i] = static_cast<Sint16> ((data[i] - 128) << 8);
+                } else {
+                    for (unsigned int i = 0; i < count; ++i)
+                        out[i] = static_cast<Sint16> (le16 (data + 2 * i));
+                }
+                return frames;
+            }
+
+            static const int steps[89] = {
+                7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+                107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+                876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871,
+                5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+                27086, 29794, 32767
+            };
+            static const int indices[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+            for (int c = 0; c < channels_ && frames != 0; ++c) {
+                int predictor = static_cast<Sint16> (le16 (data + 4 * c));
+                int index = min (static_cast<int> (data[4 * c + 2]), 88);
+                out[c] = predictor;
+                for (unsigned int group = 0; 1 + group * 8 < frames; ++group) {
+                    const Uint8* nibbles = data + 4 * channels_ + (group * channels_ + c) * 4;
+                    for (int k = 0; k < 8; ++k) {
+                        int code = (nibbles[k / 2] >> ((k & 1) * 4)) & 0x0f;
+                        int step = steps[index];
+                        int diff = step >> 3;
+                        if (code & 4)
+                            diff += step;
+                        if (code & 2)
+                            diff += step >> 1;
+                        if (code & 1)
+                            diff += step >> 2;
+                        predictor += code & 8 ? -diff : diff;
+                        predictor = max (-32768, min (32767, predictor));
+                        index = max (0, min (88, index + indices[code & 7]));
+                        out[(1 + group * 8 + k) * channels_ + c] = predictor;
+                    }
+                }
+            }
+            return frames;
+        };
+
+        /**
+         * Reads a little endian 16 bit value.
+         *
+         * @param p The bytes.
+         *
+         * @return The value.
+         */
+        static Uint16 le16 (const Uint8* p) { return p[0] | p[1] << 8; };
+
+        /**
+         * Reads a little endian 32 bit value.
+         *
+         * @param p The bytes.
+         *
+         * @return The value.
+         */
+        static Uint32 le32 (const Uint8* p) { return p[0] | p[1] << 8 | p[2] << 16 | static_cast<Uint32> (p[3]) << 24; };
+
+        /**
+         * The format tag.
+         */
+        Encoding encoding_;
+
+        /**
+         * The number of channels, 1 or 2.
+         */
+        int channels_;
+
+        /**
+         * The rate in frames per second.
+         */
+        int rate_;
+
+        /**
+         * The bits per sample, 8 or 16 for PCM and 4 for IMA ADPCM.
+         */
+        int bits_;
+
+        /**
+         * The size of a PCM frame or an ADPCM block in bytes.
+         */
+        unsigned int blockAlign_;
+
+        /**
+         * The number of frames in a block, 1 for PCM.
+         */
+        unsigned int framesPerBlock_;
+
+        /**
+         * The offset of the data from the start of the file.
+         */
+        Uint32 dataOffset_;
+
+        /**
+         * The size of the data in bytes.
+         */
+        Uint32 dataBytes_;
+
+        private:
+            /**
+             * Parses a fmt chunk.
+             *
+             * @param fmt The chunk, at least 16 bytes.
+             * @param size The size of the chunk.
+             * @param name The name of the file, for errors.
+             *
+             * @throw runtime_error Throws a runtime_error if the format is not supported.
+             */
+            void parseFormat (const Uint8* fmt, Uint32 size, const string& name) {
+                Uint16 tag = le16 (fmt);
+                channels_ = le16 (fmt + 2);
+                rate_ = le32 (fmt + 4);
+                blockAlign_ = le16 (fmt + 12);
+                bits_ = le16 (fmt + 14);
+                if (channels_ < 1 || channels_ > 2 || rate_ <= 0 || blockAlign_ == 0)
+                    throw runtime_error (name + " has an unsupported wav format.");
+                if (tag == PCM && (bits_ == 8 || bits_ == 16) && blockAlign_ == static_cast<unsigned int> (channels_ * bits_ / 8)) {
+                    encoding_ = PCM;
+                    framesPerBlock_ = 1;
+                } else if (tag == IMA_ADPCM && bits_ == 4 && blockAlign_ > 4u * channels_ && (blockAlign_ - 4 * channels_) % (4 * channels_) == 0) {
+                    encoding_ = IMA_ADPCM;
+                    framesPerBlock_ = (blockAlign_ - 4 * channels_) * 2 / channels_ + 1;
+                    if (size >= 20 && le16 (fmt + 16) >= 2 && le16 (fmt + 18) != framesPerBlock_)
+                        throw runtime_error (name + " has an inconsistent IMA ADPCM block size.");
+                } else {
+                    throw runtime_error (name + " has an unsupported wav encoding.");
+                }
+            };
+    }; //WavHeader
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_WAVHEADER_H
@@ -0,0 +1,602 @@
+/**
+ * @file WavStream.h
+ * Contains the WavStream class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_AUDIO_WAVSTREAM_H
+#define SDL_AUDIO_WAVSTREAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/audio/WavHeader.h"
+#include "sdlpp/audio/Resampler.h"
+#include "sdlpp/thread/Mutex.h"
+#include "sdlpp/thread/Condition.h"
+#include "sdlpp/thread/SpscQueue.h"
+#include "sdlpp/thread/Thread.h"
+
+namespace sdl {
+namespace audio {
+    using namespace std;
+    using namespace thread;
+
+    /**
+     * @class WavStream
+     * @brief Plays a long wav file from disk through a bounded read-ahead buffer.
+     *
+     * A reader thread decodes PCM or IMA ADPCM, converts it to the output rate and channels and
+     * fills a ring of blocks allocated up front, so memory stays bounded whatever the length of
+     * the file. The audio thread takes blocks through a lock-free queue and hands them back through
+     * another, so read never blocks or allocates. A seek tags the blocks read after it with a new
+     * epoch and read discards older ones, so seeking costs one file seek and one block decode.
+     * When the buffer runs dry read returns what it has and counts an underrun, and the missing
+     * frames play as silence. A WavStream plays on one voice at a time.
+     */
+    class WavStream {
+        public:
+            /**
+             * The number of source frames decoded per block.
+             */
+            static const unsigned int PASS = 2048;
+
+            /**
+             * Opens a wav file and starts reading ahead.
+             *
+             * @param fileName The name of the wav file.
+             * @param rate The output rate in frames per second.
+             * @param channels The largest number of output channels, 1 or 2. Mono files stay mono.
+             * @param seconds The amount of audio to read ahead.
+             * @param quality The quality of the rate conversion.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to open the file or it is not a supported wav file.
+             */
+            WavStream (const string& fileName, int rate, int channels, double seconds = 1.0, Resampler::Quality quality = Resampler::MEDIUM)
+              : name_ (fileName), file_ (fopen (fileName.c_str (), "rb")), header_ (), rate_ (rate), channels_ (0),
+                resampler_ (), blocks_ (), filled_ (0), free_ (0), current_ (NULL), offset_ (0), primed_ (0),
+                raw_ (), adpcm_ (), source_ (), mixed_ (), sourceFrame_ (0), adpcmBlock_ (0), adpcmFrames_ (0), adpcmOffset_ (0),
+                epoch_ (0), seekFrame_ (0), endedEpoch_ (0), loop_ (false), stop_ (false), ended_ (false),
+                played_ (0), buffered_ (0), underruns_ (0), underrunFrames_ (0), mutex_ (), wake_ (), reader_ () {
+                if (file_ == NULL)
+                    throw runtime_error ("Failed to open " + fileName);
+                try {
+                    header_.read (file_, fileName);
+                } catch (...) {
+                    fclose (file_);
+                    throw;
+                }
+                channels_ = min (header_.channels_, channels);
+                size_t capacity = PASS;
+                if (header_.rate_ != rate) {
+                    resampler_.reset (new Resampler (header_.rate_, rate, channels_, quality));
+                    capacity = resampler_->maxOutput (PASS);
+                }
+                unsigned int count = max (3u, static_cast<unsigned int> (ceil (seconds * header_.rate_ / PASS)));
+                blocks_.resize (count);
+                filled_.reset (new SpscQueue<Block*> (count));
+                free_.reset (new SpscQueue<Block*> (count));
+                for (vector<Block>::iterator b = blocks_.begin (); b != blocks_.end (); ++b) {
+                    b->samples_.resize (capacity * channels_);
+                    free_->push (&*b);
+                }
+                raw_.resize (max (PASS * header_.blockAlign_, header_.blockAlign_));
+                adpcm_.resize (header_.framesPerBlock_ * header_.channels_);
+                source_.resize (PASS * header_.channels_);
+                mixed_.resize (PASS * channels_);
+                reader_.reset (new Thread (boost::bind (&WavStream::run, this)));
+            };
+
+            /**
+             * Stops reading and closes the file.
+             */
+            ~WavStream () {
+                {
+                    Lock lock (mutex_);
+                    stop_.store (true);
+                    wake_.broadcast ();
+                }
+                reader_.reset ();
+                fclose (file_);
+            };
+
+            /**
+             * Takes the next frames. Called from the audio thread.
+             *
+             * @param out Receives the interleaved frames.
+             * @param frames The number of frames wanted.
+             *
+             * @return The number of frames taken, fewer than wanted if the buffer ran dry or the stream ended.
+             */
+            size_t read (Sint16* out, size_t frames) {
+                unsigned int epoch = epoch_.load (memory_order_acquire);
+                size_t done = 0;
+                while (done < frames) {
+                    if (current_ != NULL && (current_->epoch_ != epoch || offset_ == current_->frames_)) {
+                        buffered_ -= current_->frames_ - offset_;
+                        free_->push (current_);
+                        current_ = NULL;
+                    }
+                    if (current_ == NULL) {
+                        if (!filled_->pop (current_))
+                            break;
+                        offset_ = 0;
+                        if (current_->epoch_ == epoch)
+                            primed_ = epoch + 1;
+                        continue;
+                    }
+                    size_t n = min (frames - done, current_->frames_ - offset_);
+                    memcpy (out + done * channels_, &current_->samples_[offset_ * channels_], n * channels_ * sizeof (Sint16));
+                    offset_ += n;
+                    done += n;
+                    buffered_ -= n;
+                    played_.store (current_->start_ + offset_, memory_order_relaxed);
+                }
+                if (done < frames) {
+                    bool ended = current_ == NULL && endedEpoch_.load (memory_order_acquire) == epoch + 1 && filled_->size () == 0;
+                    ended_.store (ended);
+                    if (!ended && primed_ == epoch + 1) {
+                        ++underruns_;
+                        underrunFrames_ += frames - done;
+                    }
+                }
+                return done;
+            };
+
+            /**
+             * Determines if every frame has been read, as of the last read.
+             *
+             * @return True if the stream has ended, false otherwise.
+             */
+            bool ended () const { return ended_.load (); };
+
+            /**
+             * Moves playback. Called from the game thread. The frames already buffered are
+             * discarded, and the silence while the buffer refills is not counted as an underrun.
+             *
+             * @param seconds The position in seconds, clamped to the stream.
+             *
+             * @return A reference to this WavStream.
+             */
+            WavStream& seek (double seconds) {
+                seekFrame_.store (static_cast<Uint64> (max (0.0, seconds) * rate_ + 0.5));
+                ended_.store (false);
+                Lock lock (mutex_);
+                epoch_.fetch_add (1, memory_order_release);
+                wake_.signal ();
+                return *this;
+            };
+
+            /**
+             * Sets whether the stream starts over at its end, without a gap.
+             *
+             * @param loop Whether or not to loop.
+             *
+             * @return A reference to this WavStream.
+             */
+            WavStream& loop (bool loop) {
+                loop_.store (loop);
+                return *this;
+            };
+
+            /**
+             * Returns the position of the last frame read.
+             *
+             * @return The position in seconds.
+             */
+            double position () const {
+                double seconds = static_cast<double> (played_.load (memory_order_relaxed)) / rate_;
+                return duration () > 0.0 ? fmod (seconds, duration ()) : 0.0;
+            };
+
+            /**
+             * Returns the length of the stream.
+             *
+             * @return The length in seconds.
+             */
+            double duration () const { return header_.duration (); };
+
+            /**
+             * Returns the output rate.
+             *
+             * @return The rate in frames per second.
+             */
+            int rate () const { return rate_; };
+
+            /**
+             * Returns the number of output channels.
+             *
+             * @return 1 or 2.
+             */
+            int channels () const { return channels_; };
+
+            /**
+             * Returns the number of frames read ahead.
+             *
+             * @return The number of frames.
+             */
+            size_t buffered () const { return buffered_.load (); };
+
+            /**
+             * Returns the number of reads the buffer could not fill.
+             *
+             * @return The number of underruns.
+             */
+            unsigned int underruns () const { return underruns_.load (); };
+
+            /**
+             * Returns the number of frames played as silence because the buffer ran dry.
+             *
+             * @return The number of frames.
+             */
+            size_t underrunFrames () const { return underrunFrames_.load (); };
+
+            /**
+             * Returns the format of the file.
+             *
+             * @return The WavHeader.
+             */
+            const WavHeader& header () const { return header_; };
+
+        private:
+            /**
+             * @struct Block
+             * @brief A run of converted frames.
+             */
+            struct Block {
+                /**
+                 * Constructs an empty Block.
+                 */
+                Block () : samples_ (), frames_ (0), epoch_ (0), start_ (0) {};
+
+                /**
+                 * The interleaved samples.
+                 */
+                vector<Sint16> samples_;
+
+                /**
+                 * The number of frames.
+                 */
+                size_t frames_;
+
+                /**
+                 * The seek the Block was read after.
+                 */
+                unsigned int epoch_;
+
+                /**
+                 * The output position of the first frame.
+                 */
+                Uint64 start_;
+            }; //Block
+
+            /**
+             * Copy constructs a WavStream.
+             *
+             * @param rhs The WavStream to copy.
+             */
+            WavStream (const WavStream& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The WavStream from which to assign.
+             *
+             * @return A reference to this WavStream.
+             */
+            WavStream& operator= (const WavStream& rhs);
+
+            /**
+             * Fills free Blocks until the WavStream is destroyed, starting over after each seek.
+             */
+            void run () {
+                unsigned int epoch = 0;
+                Uint64 position = 0;
+                bool finished = false;
+                for (;;) {
+                    if (stop_.load ())
+                        return;
+                    unsigned int requested = epoch_.load (memory_order_acquire);
+                    if (requested != epoch) {
+                        epoch = requested;
+                        position = seekFrame_.load ();
+                        locate (static_cast<size_t> (position * header_.rate_ / rate_));
+                        if (resampler_)
+                            resampler_->reset ();
+                        finished = false;
+                    }
+                    Block* block;
+                    if (finished || !free_->pop (block)) {
+                        Lock lock (mutex_);
+                        if (!stop_.load () && epoch_.load () == epoch)
+                            wake_.wait (lock, 10);
+                        continue;
+                    }
+
+                    size_t n = decode ();
+                    if (n == 0 && loop_.load () && header_.frames () > 0) {
+                        locate (0);
+                        n = decode ();
+                    }
+                    if (resampler_)
+                        block->frames_ = n != 0 ? resampler_->process (&mixed_[0], n, &block->samples_[0]) : resampler_->flush (&block->samples_[0]);
+                    else
+                        block->frames_ = n;
+                    if (!resampler_ && n != 0)
+                        memcpy (&block->samples_[0], &mixed_[0], n * channels_ * sizeof (Sint16));
+                    block->epoch_ = epoch;
+                    block->start_ = position;
+                    position += block->frames_;
+                    buffered_ += block->frames_;
+                    filled_->push (block);
+                    if (n == 0) {
+                        finished = true;
+                        endedEpoch_.store (epoch + 1, memory_order_release);
+                    }
+                }
+            };
+
+            /**
+             * Positions the file at a source frame.
+             *
+             * @param frame The source frame, clamped to the stream.
+             */
+            void locate (size_t frame) {
+                frame = min (frame, header_.frames ());
+                sourceFrame_ = frame;
+                if (header_.encoding_ == WavHeader::PCM) {
+                    fseek (file_, header_.dataOffset_ + static_cast<long> (frame) * header_.blockAlign_, SEEK_SET);
+                    return;
+                }
+                adpcmBlock_ = frame / header_.framesPerBlock_;
+                adpcmFrames_ = adpcmOffset_ = 0;
+                fseek (file_, header_.dataOffset_ + static_cast<long> (adpcmBlock_) * header_.blockAlign_, SEEK_SET);
+                if (frame < header_.frames ()) {
+                    nextAdpcmBlock ();
+                    adpcmOffset_ = frame % header_.framesPerBlock_;
+                }
+            };
+
+            /**
+             * Decodes up to PASS source frames and converts them to the output channels in mixed_.
+             *
+             * @return The number of frames, 0 at the end of the stream.
+             */
+            size_t decode () {
+                int sourceChannels = header_.channels_;
+                size_t n = min (static_cast<size_t> (PASS), header_.frames () - sourceFrame_);
+                if (header_.encoding_ == WavHeader::PCM) {
+                    n = fread (&raw_[0], header_.blockAlign_, n, file_);
+                    header_.decode (&raw_[0], n * header_.blockAlign_, &source_[0]);
+                } else {
+                    size_t done = 0;
+                    while (done < n) {
+                        if (adpcmOffset_ == adpcmFrames_ && !nextAdpcmBlock ())
+                            break;
+                        size_t k = min (n - done, static_cast<size_t> (adpcmFrames_ - adpcmOffset_));
+                        memcpy (&source_[done * sourceChannels], &adpcm_[adpcmOffset_ * sourceChannels], k * sourceChannels * sizeof (Sint16));
+                        adpcmOffset_ += k;
+                        done += k;
+                    }
+                    n = done;
+                }
+                sourceFrame_ += n;
+                if (sourceChannels == channels_)
+                    copy (source_.begin (), source_.begin () + n * channels_, mixed_.begin ());
+                else
+                    for (size_t i = 0; i < n; ++i)
+                        mixed_[i] = static_cast<Sint16> ((source_[2 * i] + source_[2 * i + 1]) >> 1);
+                return n;
+            };
+
+            /**
+             * Reads and decodes the next IMA ADPCM block into adpcm_.
+             *
+             * @return True if a block was decoded, false at the end of the data.
+             */
+            bool nextAdpcmBlock () {
+                Uint32 start = adpcmBlock_ * header_.blockAlign_;
+                if (start >= header_.dataBytes_)
+                    return false;
+                unsigned int bytes = min (header_.blockAlign_, header_.dataBytes_ - start);
+                bytes = fread (&raw_[0], 1, bytes, file_);
+                adpcmFrames_ = header_.decode (&raw_[0], bytes, &adpcm_[0]);
+                adpcmOffset_ = 0;
+                ++adpcmBlock_;
+                return adpcmFrames_ != 0;
+            };
+
+            /**
+             * The name of the file.
+             */
+            string name_;
+
+            /**
+             * The file.
+             */
+            FILE* file_;
+
+            /**
+             * The format of the file.
+             */
+            WavHeader header_;
+
+            /**
+             * The output rate.
+             */
+            int rate_;
+
+            /**
+             * The number of output channels.
+             */
+            int channels_;
+
+            /**
+             * Converts the rate, NULL if the file is at the output rate.
+             */
+            boost::shared_ptr<Resampler> resampler_;
+
+            /**
+             * The Blocks, allocated up front.
+             */
+            vector<Block> blocks_;
+
+            /**
+             * The Blocks filled by the reader, in order.
+             */
+            boost::shared_ptr<SpscQueue<Block*> > filled_;
+
+            /**
+             * The Blocks handed back by the audio thread.
+             */
+            boost::shared_ptr<SpscQueue<Block*> > free_;
+
+            /**
+             * The Block being read by the audio thread.
+             */
+            Block* current_;
+
+            /**
+             * The next frame of current_.
+             */
+            size_t offset_;
+
+            /**
+             * One more than the last epoch read from, 0 before the first.
+             */
+            unsigned int primed_;
+
+            /**
+             * The raw bytes read by the reader.
+             */
+            vector<Uint8> raw_;
+
+            /**
+             * The decoded ADPCM block.
+             */
+            vector<Sint16> adpcm_;
+
+            /**
+             * The decoded source frames.
+             */
+            vector<Sint16> source_;
+
+            /**
+             * The source frames converted to the output channels.
+             */
+            vector<Sint16> mixed_;
+
+            /**
+             * The next source frame to decode.
+             */
+            size_t sourceFrame_;
+
+            /**
+             * The next ADPCM block to read.
+             */
+            size_t adpcmBlock_;
+
+            /**
+             * The number of frames in adpcm_.
+             */
+            unsigned int adpcmFrames_;
+
+            /**
+             * The next frame of adpcm_.
+             */
+            unsigned int adpcmOffset_;
+
+            /**
+             * The number of seeks.
+             */
+            atomic<unsigned int> epoch_;
+
+            /**
+             * The output frame of the last seek.
+             */
+            atomic<Uint64> seekFrame_;
+
+            /**
+             * One more than the epoch whose last Block has been queued, 0 for none.
+             */
+            atomic<unsigned int> endedEpoch_;
+
+            /**
+             * Whether or not to start over at the end.
+             */
+            atomic<bool> loop_;
+
+            /**
+             * Tells the reader to stop.
+             */
+            atomic<bool> stop_;
+
+            /**
+             * Whether or not the last read found the stream ended.
+             */
+            atomic<bool> ended_;
+
+            /**
+             * The output position of the last frame read.
+             */
+            atomic<Uint64> played_;
+
+            /**
+             * The number of frames read ahead.
+             */
+            atomic<size_t> buffered_;
+
+            /**
+             * The number of reads the buffer could not fill.
+             */
+            atomic<unsigned int> underruns_;
+
+            /**
+             * The number of frames played as silence because the buffer ran dry.
+             */
+            atomic<size_t> underrunFrames_;
+
+            /**
+             * Guards waiting for free Blocks or a seek.
+             */
+            Mutex mutex_;
+
+            /**
+             * Signaled on a seek or when the reader should stop.
+             */
+            Condition wake_;
+
+            /**
+             * The reader thread. Declared last so it is started after, and stopped before, the state it uses.
+             */
+            boost::shared_ptr<Thread> reader_;
+    }; //WavStream
+}; //audio
+}; //sdl
+
+#endif //SDL_AUDIO_WAVSTREAM_H
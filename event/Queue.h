@@ -130,7 +130,7 @@ namespace event {
              *
              * @return True if the event was pushed onto the Queue, false otherwise.
              */
-            bool push (SDL_Event& event) { return SDL_PushEvent (&event); };
+            bool push (SDL_Event& event) { return SDL_PushEvent (&event) == 0; };
 
             /*
              * Pumps the Queue.
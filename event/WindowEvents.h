@@ -24,6 +24,7 @@
 #include <SDL.h>
 
 #include "sdlpp/event/SimpleComparator.h"
+#include "sdlpp/event/Event.h"
 
 namespace sdl {
 namespace event {
@@ -0,0 +1,892 @@
+/**
+ * @file benchmark.cpp
+ * Contains the benchmarks.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sdlpp/Sdl.h"
+#include "sdlpp/subsystem/Subsystem.h"
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/video/DisplayFormatCache.h"
+#include "sdlpp/video/AsyncLoader.h"
+#include "sdlpp/video/TiledCompositor.h"
+#include "sdlpp/video/Scaler.h"
+#include "sdlpp/video/RleSprite.h"
+#include "sdlpp/video/DoubleOverlay.h"
+#include "sdlpp/video/Y4mPlayer.h"
+#include "sdlpp/video/Snapshot.h"
+#include "sdlpp/video/VirtualCanvas.h"
+#include "sdlpp/video/PixelConverter.h"
+#include "sdlpp/thread/Thread.h"
+#include "sdlpp/audio/Audio.h"
+#include "sdlpp/audio/Resampler.h"
+#include "sdlpp/audio/SampleBank.h"
+#include "sdlpp/audio/Biquad.h"
+#include "sdlpp/audio/Compressor.h"
+#include "sdlpp/audio/Reverb.h"
+#include "sdlpp/audio/OfflineRenderer.h"
+
+namespace sdl {
+namespace examples {
+    using namespace std;
+    using namespace sdl::misc;
+    using namespace sdl::video;
+    using namespace sdl::thread;
+
+    /**
+     * The width of the benchmark display.
+     */
+    static const int BENCH_WIDTH = 640;
+
+    /**
+     * The height of the benchmark display.
+     */
+    static const int BENCH_HEIGHT = 480;
+
+    /**
+     * Reports the result of a benchmark run.
+     *
+     * @param name The name of the run.
+     * @param iterations The number of iterations run.
+     * @param ms The number of milliseconds taken.
+     */
+    static void report (const string& name, unsigned int iterations, unsigned int ms) {
+        cout << name << ": " << iterations << " iterations in " << ms << " ms";
+        if (ms != 0)
+            cout << " (" << (iterations * 1000.0 / ms) << " per second)";
+        cout << endl;
+    };
+
+    /**
+     * Reports whether an output hash matches the value it is known to have.
+     *
+     * @param hash The hash of the output.
+     * @param expected The known hash.
+     *
+     * @return True if they match, false otherwise.
+     */
+    static bool golden (Uint64 hash, Uint64 expected) {
+        cout << "  output hash " << hex << hash;
+        if (hash != expected)
+            cout << " MISMATCH, expected " << expected;
+        cout << dec << endl;
+        return hash == expected;
+    };
+
+    /**
+     * Blits a Surface across the screen repeatedly.
+     *
+     * @param screen The screen Surface.
+     * @param sprite The Surface to blit.
+     * @param iterations The number of blits.
+     *
+     * @return The number of milliseconds taken.
+     */
+    static unsigned int blitLoop (Surface& screen, Surface& sprite, unsigned int iterations) {
+        unsigned int start = SDL_GetTicks ();
+        for (unsigned int i = 0; i < iterations; ++i) {
+            short x = (i * 37) % (screen.width () - sprite.width ());
+            short y = (i * 53) % (screen.height () - sprite.height ());
+            screen.blit (sprite, Rect (sprite.height (), sprite.width (), 0, 0), Rect (sprite.height (), sprite.width (), x, y));
+        }
+        return SDL_GetTicks () - start;
+    };
+
+    /**
+     * Compares blitting a Surface in its file format against its cached display format copy.
+     *
+     * @param fileName The bitmap to blit, or empty to use a generated 24 bit Surface.
+     */
+    static void displayFormat (const string& fileName) {
+        Surface screen (BENCH_WIDTH, BENCH_HEIGHT, 32, SDL_SWSURFACE);
+        Surface sprite = fileName.empty ()
+            ? Surface (SDL_CreateRGBSurface (SDL_SWSURFACE, 64, 64, 24, 0xff0000, 0x00ff00, 0x0000ff, 0))
+            : Surface (fileName);
+
+        const unsigned int iterations = 100000;
+        DisplayFormatCache cache;
+        Surface converted = cache.get (sprite);
+
+        //warm up both paths before timing the steady state.
+        blitLoop (screen, sprite, 1000);
+        blitLoop (screen, converted, 1000);
+        report ("file format blit", iterations, blitLoop (screen, sprite, iterations));
+        report ("display format blit", iterations, blitLoop (screen, converted, iterations));
+    };
+
+    /**
+     * Compares loading bitmaps one after another against loading them on an AsyncLoader.
+     *
+     * @param fileNames The bitmaps to load.
+     */
+    static void load (const vector<string>& fileNames) {
+        unsigned int start = SDL_GetTicks ();
+        for (vector<string>::const_iterator cur = fileNames.begin (); cur != fileNames.end (); ++cur)
+            Surface surface (*cur);
+        report ("serial load", fileNames.size (), SDL_GetTicks () - start);
+
+        start = SDL_GetTicks ();
+        {
+            AsyncLoader loader;
+            vector<Load> loads = loader.load (fileNames);
+            for (vector<Load>::iterator cur = loads.begin (); cur != loads.end (); ++cur)
+                cur->get ();
+        }
+        report ("parallel load", fileNames.size (), SDL_GetTicks () - start);
+    };
+
+    /**
+     * Creates a 32 bit software Surface with an alpha channel.
+     *
+     * @param width The width.
+     * @param height The height.
+     *
+     * @return The Surface.
+     */
+    static Surface rgba (int width, int height) {
+        return Surface (SDL_CreateRGBSurface (SDL_SWSURFACE, width, height, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000));
+    };
+
+    /**
+     * Queues a dashboard-like frame of fills and alpha blended sprites.
+     *
+     * @param compositor The TiledCompositor on which to queue.
+     * @param sprites The sprites to blit.
+     */
+    static void dashboard (TiledCompositor& compositor, vector<Surface>& sprites) {
+        srand (1);
+        compositor.clear (0xff202020);
+        for (int i = 0; i < 2000; ++i) {
+            if (i % 4 == 0)
+                compositor.fill (Rect (rand () % 300, rand () % 300, rand () % 2560, rand () % 1440), 0xff000000 | rand ());
+            else
+                compositor.blit (sprites[i % sprites.size ()], Rect (64, 64, 0, 0), rand () % 2560 - 32, rand () % 1440 - 32);
+        }
+    };
+
+    /**
+     * Measures compositing a 2560x1440 frame on 1 to N threads and checks every result against the serial one.
+     */
+    static void tiled () {
+        vector<Surface> sprites;
+        for (int i = 0; i < 8; ++i) {
+            Surface sprite = rgba (64, 64);
+            SDL_SetAlpha (sprite.to_c (), SDL_SRCALPHA, SDL_ALPHA_OPAQUE);
+            Uint32* pixels = static_cast<Uint32*> (sprite.to_c ()->pixels);
+            for (int p = 0; p < 64 * 64; ++p)
+                pixels[p] = (rand () & 0x00ffffff) | ((p % 64) * 4) << 24;
+            sprites.push_back (sprite);
+        }
+
+        const unsigned int frames = 20;
+        Surface serial = rgba (2560, 1440);
+        {
+            TiledCompositor compositor (serial, 128, 1);
+            unsigned int start = SDL_GetTicks ();
+            for (unsigned int f = 0; f < frames; ++f) {
+                dashboard (compositor, sprites);
+                compositor.flush (false);
+            }
+            report ("serial composite", frames, SDL_GetTicks () - start);
+        }
+
+        for (unsigned int threads = 1; threads <= Thread::processors (); ++threads) {
+            Surface target = rgba (2560, 1440);
+            TiledCompositor compositor (target, 128, threads);
+            unsigned int start = SDL_GetTicks ();
+            for (unsigned int f = 0; f < frames; ++f) {
+                dashboard (compositor, sprites);
+                compositor.flush ();
+            }
+            unsigned int ms = SDL_GetTicks () - start;
+            cout << threads << " thread(s), ";
+            report ("tiled composite", frames, ms);
+            if (memcmp (target.to_c ()->pixels, serial.to_c ()->pixels, target.to_c ()->pitch * target.to_c ()->h) != 0)
+                cout << "  result differs from serial composite!" << endl;
+        }
+    };
+
+    /**
+     * Measures scaling a 512x512 Surface up and down with each filter.
+     */
+    static void scale () {
+        Surface source = rgba (512, 512);
+        Uint32* pixels = static_cast<Uint32*> (source.to_c ()->pixels);
+        for (int p = 0; p < 512 * 512; ++p)
+            pixels[p] = rand ();
+
+        const char* names[] = { "nearest", "bilinear", "box" };
+        const unsigned int iterations = 50;
+        for (int filter = Scaler::NEAREST; filter <= Scaler::BOX; ++filter) {
+            unsigned int start = SDL_GetTicks ();
+            for (unsigned int i = 0; i < iterations; ++i)
+                source.scaled (1280, 720, static_cast<Scaler::Filter> (filter));
+            report (string (names[filter]) + " 512x512 to 1280x720", iterations, SDL_GetTicks () - start);
+
+            start = SDL_GetTicks ();
+            for (unsigned int i = 0; i < iterations; ++i)
+                source.scaled (128, 128, static_cast<Scaler::Filter> (filter));
+            report (string (names[filter]) + " 512x512 to 128x128", iterations, SDL_GetTicks () - start);
+        }
+
+        unsigned int start = SDL_GetTicks ();
+        for (unsigned int i = 0; i < iterations; ++i)
+            source.transformed (i * 7.0, 1.5);
+        report ("bilinear rotate and zoom 1.5x", iterations, SDL_GetTicks () - start);
+    };
+
+    /**
+     * Blits a Surface at pseudo random offsets.
+     *
+     * @param name The name of the run.
+     * @param target The Surface onto which to blit.
+     * @param sprite The Surface to blit.
+     * @param iterations The number of blits.
+     */
+    static void scatter (const string& name, Surface& target, Surface& sprite, unsigned int iterations) {
+        srand (2);
+        Rect all (sprite.height (), sprite.width (), 0, 0);
+        unsigned int start = SDL_GetTicks ();
+        for (unsigned int i = 0; i < iterations; ++i)
+            target.blit (sprite, all, Rect (0, 0, rand () % target.width () - 64, rand () % target.height () - 64));
+        report (name, iterations, SDL_GetTicks () - start);
+    };
+
+    /**
+     * Compares blitting a mostly transparent sprite with per-pixel alpha, color keys, SDL's RLE acceleration and RleSprite.
+     */
+    static void rle () {
+        const int size = 128;
+        const unsigned int iterations = 5000;
+        Surface target (SDL_CreateRGBSurface (SDL_SWSURFACE, 1024, 768, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0));
+
+        //a ring about 15% of the area with a soft outer edge.
+        Surface ring = rgba (size, size);
+        Surface keyed (SDL_CreateRGBSurface (SDL_SWSURFACE, size, size, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0));
+        for (int y = 0; y < size; ++y) {
+            Uint32* alpha = reinterpret_cast<Uint32*> (static_cast<Uint8*> (ring.to_c ()->pixels) + y * ring.to_c ()->pitch);
+            Uint32* key = reinterpret_cast<Uint32*> (static_cast<Uint8*> (keyed.to_c ()->pixels) + y * keyed.to_c ()->pitch);
+            for (int x = 0; x < size; ++x) {
+                int dx = x - size / 2;
+                int dy = y - size / 2;
+                int d = dx * dx + dy * dy;
+                Uint32 a = d < 50 * 50 || d > 62 * 62 ? 0 : d > 60 * 60 ? 128 : 255;
+                alpha[x] = (a << 24) | 0x00c08040;
+                key[x] = a == 0 ? 0x00ff00ff : 0x00c08040;
+            }
+        }
+
+        ring.alpha (SDL_ALPHA_OPAQUE);
+        scatter ("per-pixel alpha blit", target, ring, iterations);
+        ring.rle (true);
+        scatter ("per-pixel alpha blit, SDL_RLEACCEL", target, ring, iterations);
+        keyed.colorKey (0x00ff00ff);
+        scatter ("color key blit", target, keyed, iterations);
+        keyed.rle (true);
+        scatter ("color key blit, SDL_RLEACCEL", target, keyed, iterations);
+
+        ring.rle (false);
+        RleSprite sprite (ring, target.to_c ()->format);
+        srand (2);
+        unsigned int start = SDL_GetTicks ();
+        for (unsigned int i = 0; i < iterations; ++i)
+            sprite.blit (target, rand () % target.width () - 64, rand () % target.height () - 64);
+        report ("RleSprite blit", iterations, SDL_GetTicks () - start);
+        cout << "  " << sprite.visible () << " of " << size * size << " pixels visible, " << sprite.bytes () << " bytes encoded" << endl;
+    };
+
+    /**
+     * Measures converting 1280x720 frames to a YV12 Overlay on 1 to N threads and presenting them double buffered.
+     */
+    static void yuv () {
+        Surface screen (BENCH_WIDTH, BENCH_HEIGHT, 32, SDL_SWSURFACE);
+        Surface frame = rgba (1280, 720);
+        Uint32* pixels = static_cast<Uint32*> (frame.to_c ()->pixels);
+        for (int p = 0; p < 1280 * 720; ++p)
+            pixels[p] = rand ();
+
+        const unsigned int iterations = 100;
+        Overlay overlay (Rect (720, 1280, 0, 0), SDL_YV12_OVERLAY, screen);
+        for (unsigned int threads = 1; threads <= Thread::processors (); ++threads) {
+            YuvConverter converter (threads);
+            unsigned int start = SDL_GetTicks ();
+            for (unsigned int i = 0; i < iterations; ++i) {
+                overlay.lock ();
+                converter.convert (frame, overlay);
+                overlay.unlock ();
+            }
+            cout << threads << " thread(s), ";
+            report ("RGB to YV12 conversion", iterations, SDL_GetTicks () - start);
+        }
+
+        Rect dst (BENCH_HEIGHT, BENCH_WIDTH, 0, 0);
+        YuvConverter serial (1);
+        unsigned int start = SDL_GetTicks ();
+        for (unsigned int i = 0; i < iterations; ++i) {
+            overlay.lock ();
+            serial.convert (frame, overlay);
+            overlay.unlock ();
+            overlay.display (dst);
+        }
+        report ("single overlay convert then display", iterations, SDL_GetTicks () - start);
+
+        DoubleOverlay overlays (Rect (720, 1280, 0, 0), SDL_YV12_OVERLAY, screen, 1);
+        start = SDL_GetTicks ();
+        for (unsigned int i = 0; i < iterations; ++i)
+            overlays.present (frame, dst);
+        report ("double overlay convert while displaying", iterations, SDL_GetTicks () - start);
+    };
+
+    /**
+     * Measures reading the display back into a Snapshot and comparing it against the previous frame.
+     */
+    static void snapshot () {
+        Surface screen (BENCH_WIDTH, BENCH_HEIGHT, 32, SDL_SWSURFACE);
+        Surface sprite = rgba (64, 64);
+        Snapshot previous (screen);
+        Snapshot current;
+
+        const unsigned int iterations = 200;
+        unsigned int changed = 0;
+        unsigned int start = SDL_GetTicks ();
+        for (unsigned int i = 0; i < iterations; ++i) {
+            screen.blit (sprite, Rect (64, 64, 0, 0), Rect (64, 64, rand () % BENCH_WIDTH, rand () % BENCH_HEIGHT));
+            current.capture (screen);
+            changed += current.differences (previous);
+            std::swap (current, previous);
+        }
+        report ("display capture and compare", iterations, SDL_GetTicks () - start);
+        cout << "  " << changed << " pixels changed, last frame checksum " << hex << previous.checksum () << dec << endl;
+    };
+
+    /**
+     * Measures presenting a 320x240 VirtualCanvas at whole-number and fractional scales.
+     */
+    static void canvas () {
+        const int sizes[][2] = { { 320, 240 }, { 640, 480 }, { 1280, 960 }, { 800, 600 }, { 1366, 768 } };
+        const unsigned int iterations = 200;
+        for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); ++i) {
+            VirtualCanvas canvas (320, 240, sizes[i][0], sizes[i][1], 32, SDL_SWSURFACE);
+            Surface sprite = rgba (32, 32);
+            unsigned int start = SDL_GetTicks ();
+            for (unsigned int j = 0; j < iterations; ++j) {
+                canvas.canvas ().blit (sprite, Rect (32, 32, 0, 0), Rect (32, 32, rand () % 320, rand () % 240));
+                canvas.present ();
+            }
+            ostringstream name;
+            name << "320x240 canvas to " << sizes[i][0] << "x" << sizes[i][1] << " (scale " << canvas.scale () << ")";
+            report (name.str (), iterations, SDL_GetTicks () - start);
+        }
+    };
+
+    /**
+     * Measures recoloring a full 640x480 heat map per frame with SDL_MapRGBA per pixel and
+     * with a PixelConverter, into 32, 16 and 8 bit paletted Surfaces.
+     */
+    static void colors () {
+        const int size = BENCH_WIDTH * BENCH_HEIGHT;
+        vector<Color> heat (size);
+        for (int i = 0; i < size; ++i) {
+            Uint8 t = (i % BENCH_WIDTH + i / BENCH_WIDTH + rand () % 32) * 255 / (BENCH_WIDTH + BENCH_HEIGHT + 32);
+            heat[i] = Color (t, 255 - abs (2 * t - 255), 255 - t);
+        }
+        SDL_Color palette[256];
+        for (int i = 0; i < 256; ++i) {
+            palette[i].r = i;
+            palette[i].g = 255 - abs (2 * i - 255);
+            palette[i].b = 255 - i;
+        }
+
+        const int depths[] = { 32, 16, 8 };
+        const unsigned int iterations = 100;
+        for (int d = 0; d < 3; ++d) {
+            Masks masks = depths[d] == 32 ? Masks::argb8888 () : depths[d] == 16 ? Masks::rgb565 () : Masks (0, 0, 0, 0);
+            Surface target (SDL_SWSURFACE, Rect (BENCH_HEIGHT, BENCH_WIDTH, 0, 0), depths[d], masks);
+            SDL_Surface* s = target.to_c ();
+            if (depths[d] == 8)
+                SDL_SetColors (s, palette, 0, 256);
+
+            unsigned int start = SDL_GetTicks ();
+            for (unsigned int i = 0; i < iterations; ++i) {
+                SDL_LockSurface (s);
+                for (int y = 0; y < s->h; ++y) {
+                    Uint8* row = static_cast<Uint8*> (s->pixels) + y * s->pitch;
+                    for (int x = 0; x < s->w; ++x) {
+                        const Color& c = heat[y * s->w + x];
+                        Uint32 p = SDL_MapRGBA (s->format, c.red (), c.green (), c.blue (), c.alpha ());
+                        if (depths[d] == 32)
+                            reinterpret_cast<Uint32*> (row)[x] = p;
+                        else if (depths[d] == 16)
+                            reinterpret_cast<Uint16*> (row)[x] = p;
+                        else
+                            row[x] = p;
+                    }
+                }
+                SDL_UnlockSurface (s);
+            }
+            ostringstream name;
+            name << depths[d] << " bit SDL_MapRGBA per pixel";
+            report (name.str (), iterations, SDL_GetTicks () - start);
+
+            start = SDL_GetTicks ();
+            PixelConverter converter (target);
+            unsigned int built = SDL_GetTicks () - start;
+            start = SDL_GetTicks ();
+            for (unsigned int i = 0; i < iterations; ++i)
+                converter.draw (&heat[0], target);
+            name.str ("");
+            name << depths[d] << " bit PixelConverter::draw";
+            report (name.str (), iterations, SDL_GetTicks () - start);
+            if (depths[d] == 8)
+                cout << "  palette cube built in " << built << " ms" << endl;
+        }
+
+        Surface target (SDL_SWSURFACE, Rect (BENCH_HEIGHT, BENCH_WIDTH, 0, 0), 32, Masks::argb8888 ());
+        PixelConverter converter (target);
+        vector<Uint32> pixels (size);
+        converter.map (&heat[0], size, &pixels[0]);
+        unsigned int start = SDL_GetTicks ();
+        for (unsigned int i = 0; i < iterations; ++i)
+            converter.unmap (&pixels[0], size, &heat[0]);
+        report ("32 bit PixelConverter::unmap", iterations, SDL_GetTicks () - start);
+    };
+
+    /**
+     * Compares loading wav files with SDL_LoadWAV and converting each against loading them
+     * through a SampleBank, twice each so repeated loads are counted.
+     *
+     * @param fileNames The wav files to load.
+     */
+    static void bank (const vector<string>& fileNames) {
+        unsigned int start = SDL_GetTicks ();
+        size_t bytes = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (vector<string>::const_iterator cur = fileNames.begin (); cur != fileNames.end (); ++cur) {
+                audio::Wav wav (*cur);
+                bytes += audio::Sample (wav, 44100, 2).bytes ();
+            }
+        }
+        report ("SDL_LoadWAV and convert", fileNames.size () * 2, SDL_GetTicks () - start);
+        cout << "  " << bytes / 1024 << " KB converted" << endl;
+
+        start = SDL_GetTicks ();
+        audio::SampleBank samples (44100, 2);
+        for (int pass = 0; pass < 2; ++pass)
+            for (vector<string>::const_iterator cur = fileNames.begin (); cur != fileNames.end (); ++cur)
+                samples.load (*cur);
+        report ("SampleBank::load", fileNames.size () * 2, SDL_GetTicks () - start);
+        cout << "  " << samples.unique () << " distinct, " << samples.shared () << " duplicates, "
+             << samples.mappedBytes () / 1024 << " KB mapped, " << samples.ownedBytes () / 1024 << " KB converted" << endl;
+    };
+
+    /**
+     * Measures resampling ten seconds of stereo noise from 44.1 kHz to 48 kHz and back at each
+     * quality, whole and in callback-sized pieces.
+     */
+    static void resample () {
+        const int seconds = 10;
+        const char* qualities[] = { "FAST", "MEDIUM", "BEST" };
+        vector<Sint16> noise (48000 * seconds * 2);
+        for (size_t i = 0; i < noise.size (); ++i)
+            noise[i] = rand () % 16384 - 8192;
+        vector<Sint16> out;
+        for (int q = 0; q < 3; ++q) {
+            const int rates[][2] = { { 44100, 48000 }, { 48000, 44100 } };
+            for (int r = 0; r < 2; ++r) {
+                audio::Resampler resampler (rates[r][0], rates[r][1], 2, static_cast<audio::Resampler::Quality> (q));
+                size_t frames = static_cast<size_t> (rates[r][0]) * seconds;
+                unsigned int start = SDL_GetTicks ();
+                resampler.convert (&noise[0], frames, out);
+                unsigned int ms = SDL_GetTicks () - start;
+                ostringstream name;
+                name << qualities[q] << " " << rates[r][0] << " -> " << rates[r][1] << " (" << resampler.taps () << " taps)";
+                report (name.str (), 1, ms);
+                if (ms != 0)
+                    cout << "  " << out.size () / 2 * 1000.0 / ms / 1e6 << " M frames/s, " << seconds * 1000.0 / ms << "x real time" << endl;
+            }
+
+            audio::Resampler stream (44100, 48000, 2, static_cast<audio::Resampler::Quality> (q));
+            vector<Sint16> block (stream.maxOutput (1024) * 2);
+            unsigned int pieces = 0;
+            unsigned int start = SDL_GetTicks ();
+            for (size_t pos = 0; pos + 1024 <= noise.size () / 2; pos += 1024, ++pieces)
+                stream.process (&noise[pos * 2], 1024, &block[0]);
+            ostringstream name;
+            name << qualities[q] << " 1024 frame pieces";
+            report (name.str (), pieces, SDL_GetTicks () - start);
+        }
+    };
+
+    /**
+     * Measures mixing 32 looping voices into 16 bit stereo, then plays them through the audio
+     * callback for a second, on the dummy audio driver unless SDL_AUDIODRIVER chooses another,
+     * and reports how long the callbacks took.
+     */
+    static void mixer () {
+        const int rate = 44100;
+        const unsigned int voices = 32;
+        vector<audio::Sample> samples;
+        for (unsigned int v = 0; v < voices; ++v) {
+            vector<Sint16> frames ((rate / 4 + v * 97) * (v % 2 + 1));
+            for (size_t i = 0; i < frames.size (); ++i)
+                frames[i] = rand () % 8192 - 4096;
+            samples.push_back (audio::Sample (frames, v % 2 + 1));
+        }
+
+        audio::Mixer mixer (rate, 2, voices);
+        for (unsigned int v = 0; v < voices; ++v)
+            mixer.play (samples[v], 0.5f, (v % 9) / 4.0f - 1.0f, true);
+        vector<Sint16> out (1024 * 2);
+        const unsigned int iterations = 2000;
+        unsigned int start = SDL_GetTicks ();
+        for (unsigned int i = 0; i < iterations; ++i)
+            mixer.mix (&out[0], 1024);
+        unsigned int ms = SDL_GetTicks () - start;
+        report ("Mixer::mix 32 voices, 1024 frames", iterations, ms);
+        if (ms != 0)
+            cout << "  " << iterations * 1024.0 / rate * 1000.0 / ms << "x real time" << endl;
+
+        if (SDL_getenv ("SDL_AUDIODRIVER") == NULL)
+            subsystem::Audio::headless ();
+        subsystem::Audio::instance ();
+        cerr << "audio driver: " << subsystem::Audio::driverName () << endl;
+        audio::Audio device (rate, 2, 1024, voices);
+        for (unsigned int v = 0; v < voices; ++v)
+            device.play (samples[v], 0.5f, 0.0f, v % 4 == 0);
+        for (unsigned int i = 0; i < 100; ++i) {
+            SDL_Delay (10);
+            device.mixer ().update ();
+        }
+        cout << "  " << device.mixer ().active () << " voices active after 1 s, " << device.mixer ().rejected () << " rejected" << endl;
+        const audio::CallbackStats& stats = device.stats ();
+        cout << "  " << stats.callbacks () << " callbacks, mean " << stats.mean () * 1e6 << " us, max " << stats.max () * 1e6
+             << " us of a " << stats.deadline () * 1e6 << " us deadline (" << stats.peakLoad () * 100.0 << "% peak load)" << endl
+             << "  " << stats.overruns () << " overruns, " << stats.underruns () << " underruns, "
+             << stats.latency () * 1000.0 << " ms estimated latency" << endl;
+    };
+
+    /**
+     * Renders ten seconds of stereo noise through each Effect offline and reports its speed, and
+     * checks a hash of its output against the known value. The hashes are the same from build to
+     * build, with or without SSE2, as long as the compiler does not fuse multiplies and adds;
+     * build with -ffp-contract=off for targets with FMA.
+     *
+     * @return True if every hash matches, false otherwise.
+     */
+    static bool effects () {
+        const int rate = 44100;
+        const size_t frames = rate * 10;
+        vector<float> noise (frames * 2);
+        Uint32 seed = 1;
+        for (size_t i = 0; i < noise.size (); ++i) {
+            seed = seed * 1664525 + 1013904223;
+            noise[i] = static_cast<float> (static_cast<Sint32> (seed) >> 8) / 8388608.0f * (i < noise.size () / 2 ? 0.25f : 1.0f);
+        }
+
+        const char* names[] = { "low pass 1 kHz", "peak +6 dB at 3 kHz", "compressor 4:1 at -12 dB", "limiter at -6 dB", "reverb" };
+        const Uint64 expected[] = { 0x99bfe1e0f1ac11a8ULL, 0x5c40b8cd5785a6f4ULL, 0x5f259cd1ad57b5d5ULL, 0x029e6692ddc84c2dULL, 0xd7f40b212863ab06ULL };
+        bool ok = true;
+        for (unsigned int e = 0; e < 5; ++e) {
+            boost::shared_ptr<audio::Effect> effect;
+            if (e == 0)
+                effect.reset (new audio::Biquad (audio::Biquad::LOW_PASS, 1000.0f));
+            else if (e == 1)
+                effect.reset (new audio::Biquad (audio::Biquad::PEAK, 3000.0f, 1.0f, 6.0f));
+            else if (e == 2)
+                effect.reset (new audio::Compressor (-12.0f, 4.0f));
+            else if (e == 3)
+                effect.reset (new audio::Compressor (-6.0f, 1000.0f, 0.001f, 0.05f));
+            else
+                effect.reset (new audio::Reverb (0.8f, 0.4f, 0.3f, 1.0f));
+            audio::EffectChain chain (rate, 2);
+            chain.add (effect);
+            vector<float> out;
+            unsigned int start = SDL_GetTicks ();
+            chain.render (&noise[0], frames, out);
+            unsigned int ms = SDL_GetTicks () - start;
+
+            Uint64 hash = 14695981039346656037ULL;
+            const Uint8* bytes = reinterpret_cast<const Uint8*> (&out[0]);
+            for (size_t i = 0; i < out.size () * sizeof (float); ++i)
+                hash = (hash ^ bytes[i]) * 1099511628211ULL;
+            ostringstream name;
+            name << "EffectChain::render " << names[e] << ", 10 s";
+            report (name.str (), 1, ms);
+            cout << "  " << (ms != 0 ? 10000.0 / ms : 0.0) << "x real time" << endl;
+            ok = golden (hash, expected[e]) && ok;
+        }
+        return ok;
+    };
+
+    /**
+     * Renders 64 looping voices through a reverb on the master bus offline, and reports how much
+     * faster than real time it ran. The output is written to a wav file if one is named.
+     *
+     * @param seconds The number of seconds to render.
+     * @param buffer The buffer size in frames.
+     * @param fileName The name of the wav file, empty for none.
+     *
+     * @return The hash of the output.
+     */
+    static Uint64 scene (size_t seconds, unsigned int buffer, const string& fileName) {
+        const int rate = 44100;
+        const unsigned int voices = 64;
+        Uint32 seed = 1;
+        vector<audio::Sample> samples;
+        for (unsigned int v = 0; v < voices; ++v) {
+            vector<Sint16> frames ((rate / 4 + v * 97) * (v % 2 + 1));
+            for (size_t i = 0; i < frames.size (); ++i) {
+                seed = seed * 1664525 + 1013904223;
+                frames[i] = static_cast<Sint16> (static_cast<Sint32> (seed) >> 19);
+            }
+            samples.push_back (audio::Sample (frames, v % 2 + 1));
+        }
+
+        audio::Mixer mixer (rate, 2, voices, voices * 2);
+        mixer.master ().add (boost::shared_ptr<audio::Effect> (new audio::Reverb (0.6f, 0.5f, 0.2f, 1.0f)));
+        for (unsigned int v = 0; v < voices; ++v)
+            mixer.play (samples[v], 0.25f, (v % 9) / 4.0f - 1.0f, true);
+        audio::OfflineRenderer renderer (mixer, buffer);
+        vector<Sint16> out;
+        unsigned int start = SDL_GetTicks ();
+        if (fileName.empty ())
+            renderer.render (rate * seconds, out);
+        else
+            renderer.bounce (fileName, rate * seconds);
+        ostringstream name;
+        name << "OfflineRenderer 64 voices and a reverb, " << seconds << " s in " << buffer << " frame buffers";
+        report (name.str (), 1, SDL_GetTicks () - start);
+        cout << "  " << renderer.speed () << "x real time, " << renderer.throughput () << " voice seconds per second" << endl;
+        return renderer.hash ();
+    };
+
+    /**
+     * Renders a minute of the scene, checking a hash of its output against the known value. The
+     * hash is the same from build to build, with or without SSE2, as long as the compiler does
+     * not fuse multiplies and adds.
+     *
+     * @param fileName The name of a wav file to write, empty for none.
+     *
+     * @return True if the hash matches, false otherwise.
+     */
+    static bool render (const string& fileName) {
+        return golden (scene (60, 1024, fileName), 0x37105c371076a70cULL);
+    };
+
+    /**
+     * Checks the bit-exact output of the mixer and the effects quickly, for continuous
+     * integration: two seconds of the scene in buffers of several sizes, which must all give
+     * the same known hash, then each Effect.
+     *
+     * @return True if every hash matches, false otherwise.
+     */
+    static bool check () {
+        const unsigned int buffers[] = { 441, 1024, 4096 };
+        bool ok = true;
+        for (unsigned int i = 0; i < 3; ++i)
+            ok = golden (scene (2, buffers[i], ""), 0x296d2a9e454193c2ULL) && ok;
+        return effects () && ok;
+    };
+
+    /**
+     * Measures mixing 512 looping positional voices spread over a grid, first with every voice
+     * within hearing, then with a Listener that hears only the nearest few.
+     */
+    static void spatial () {
+        const int rate = 44100;
+        const unsigned int voices = 512;
+        vector<Sint16> frames (rate / 4);
+        for (size_t i = 0; i < frames.size (); ++i)
+            frames[i] = rand () % 8192 - 4096;
+        audio::Sample sample (frames, 1);
+        audio::Mixer mixer (rate, 2, voices, voices * 2);
+        for (unsigned int v = 0; v < voices; ++v)
+            mixer.playAt (sample, (v % 32) * 10.0f - 155.0f, 0.0f, (v / 32) * 10.0f - 75.0f, 0.05f, true);
+
+        const float ranges[] = { 1000.0f, 30.0f };
+        vector<Sint16> out (1024 * 2);
+        for (unsigned int r = 0; r < 2; ++r) {
+            mixer.listener (audio::Listener (0.0f, 1.5f, 0.0f, 0.0f, 1.0f, ranges[r]));
+            const unsigned int iterations = 200;
+            unsigned int start = SDL_GetTicks ();
+            for (unsigned int i = 0; i < iterations; ++i) {
+                if (i % 4 == 0)
+                    mixer.listener (audio::Listener (0.0f, 1.5f, 0.0f, i * 0.5f, 1.0f, ranges[r]));
+                mixer.mix (&out[0], 1024);
+            }
+            unsigned int ms = SDL_GetTicks () - start;
+            ostringstream name;
+            name << "Mixer::mix 512 positional voices, 1024 frames, " << ranges[r] << " hearing range";
+            report (name.str (), iterations, ms);
+            cout << "  " << mixer.culled () << " voices culled" << endl;
+        }
+    };
+
+    /**
+     * Opens the audio for a target latency and plays 32 looping voices for a few seconds,
+     * adapting the buffer once per frame, and reports each buffer size chosen.
+     *
+     * @param milliseconds The target latency in milliseconds.
+     */
+    static void latency (double milliseconds) {
+        const int rate = 44100;
+        const unsigned int voices = 32;
+        if (SDL_getenv ("SDL_AUDIODRIVER") == NULL)
+            subsystem::Audio::headless ();
+        subsystem::Audio::instance ();
+        cerr << "audio driver: " << subsystem::Audio::driverName () << endl;
+        audio::Audio device (rate, 2, audio::Latency (milliseconds), voices);
+        cout << "target " << milliseconds << " ms: opened " << device.spec ().samples << " samples, "
+             << device.stats ().latency () * 1000.0 << " ms estimated latency" << endl;
+
+        vector<Sint16> frames (rate / 2 * 2);
+        for (size_t i = 0; i < frames.size (); ++i)
+            frames[i] = rand () % 8192 - 4096;
+        audio::Sample sample (frames, 2);
+        for (unsigned int v = 0; v < voices; ++v)
+            device.play (sample, 0.25f, 0.0f, true);
+        for (unsigned int i = 0; i < 1000; ++i) {
+            SDL_Delay (10);
+            device.mixer ().update ();
+            if (device.adapt (2.0))
+                cout << "  " << i * 10 << " ms: " << device.spec ().samples << " samples, "
+                     << device.stats ().latency () * 1000.0 << " ms estimated latency" << endl;
+        }
+        cout << "  " << device.reopens () << " reopens, settled at " << device.spec ().samples << " samples" << endl;
+    };
+
+    /**
+     * Plays a YUV4MPEG2 stream in real time and reports how the frames were paced.
+     *
+     * @param fileName The name of the stream, "-" for standard input.
+     */
+    static void y4m (const string& fileName) {
+        Y4mSource source (fileName);
+        Surface screen (source.width (), source.height (), 32, SDL_SWSURFACE);
+        Overlay overlay (Rect (source.height (), source.width (), 0, 0), SDL_YV12_OVERLAY, screen);
+        Y4mPlayer player (source, overlay);
+        Rect dst (source.height (), source.width (), 0, 0);
+        unsigned int start = SDL_GetTicks ();
+        unsigned int calls = 0;
+        for (; player.present (dst); ++calls)
+            SDL_Delay (1);
+        report ("Y4M playback calls", calls, SDL_GetTicks () - start);
+
+        PlaybackStats stats = player.stats ();
+        cout << "  " << stats.presented_ << " presented, " << stats.dropped_ << " dropped, "
+             << stats.repeated_ << " repeated, " << stats.underruns_ << " underruns" << endl;
+        unsigned int frames = stats.presented_ + stats.dropped_;
+        if (frames != 0)
+            cout << "  per frame: read " << stats.decodeSeconds_ * 1000.0 / frames << " ms" << endl;
+        if (stats.presented_ != 0)
+            cout << "  per presented frame: upload " << stats.uploadSeconds_ * 1000.0 / stats.presented_
+                 << " ms, display " << stats.presentSeconds_ * 1000.0 / (stats.presented_ + stats.repeated_) << " ms" << endl;
+    };
+}; //examples
+}; //sdl
+
+/**
+ * The main function.
+ *
+ * @param int argc, The number of arguments.
+ * @param char** argv, The arguments.
+ *
+ * @return int, The exit status.
+ */
+int main (int argc, char** argv) {
+    using namespace sdl;
+    using namespace sdl::subsystem;
+    using namespace sdl::examples;
+
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " displayformat [file.bmp]" << endl
+             << "       " << argv[0] << " load file.bmp..." << endl
+             << "       " << argv[0] << " tiled" << endl
+             << "       " << argv[0] << " scale" << endl
+             << "       " << argv[0] << " rle" << endl
+             << "       " << argv[0] << " yuv" << endl
+             << "       " << argv[0] << " y4m file.y4m|-" << endl
+             << "       " << argv[0] << " snapshot" << endl
+             << "       " << argv[0] << " canvas" << endl
+             << "       " << argv[0] << " colors" << endl
+             << "       " << argv[0] << " mixer" << endl
+             << "       " << argv[0] << " spatial" << endl
+             << "       " << argv[0] << " effects" << endl
+             << "       " << argv[0] << " render [file.wav]" << endl
+             << "       " << argv[0] << " check" << endl
+             << "       " << argv[0] << " latency [milliseconds]" << endl
+             << "       " << argv[0] << " resample" << endl
+             << "       " << argv[0] << " bank file.wav..." << endl
+             << "Without a display the dummy video driver is used." << endl;
+        return 1;
+    }
+
+    Video::headlessIfNoDisplay ();
+    Sdl::instance ();
+    Video::instance ();
+    cerr << "video driver: " << Video::driverName () << endl;
+
+    string name (argv[1]);
+    if (name == "displayformat")
+        displayFormat (argc > 2 ? argv[2] : "");
+    else if (name == "load")
+        load (vector<string> (argv + 2, argv + argc));
+    else if (name == "tiled")
+        tiled ();
+    else if (name == "scale")
+        scale ();
+    else if (name == "rle")
+        rle ();
+    else if (name == "yuv")
+        yuv ();
+    else if (name == "y4m" && argc > 2)
+        y4m (argv[2]);
+    else if (name == "snapshot")
+        snapshot ();
+    else if (name == "canvas")
+        canvas ();
+    else if (name == "colors")
+        colors ();
+    else if (name == "mixer")
+        mixer ();
+    else if (name == "spatial")
+        spatial ();
+    else if (name == "effects")
+        return effects () ? 0 : 1;
+    else if (name == "render")
+        return render (argc > 2 ? argv[2] : "") ? 0 : 1;
+    else if (name == "check")
+        return check () ? 0 : 1;
+    else if (name == "latency")
+        latency (argc > 2 ? atof (argv[2]) : 10.0);
+    else if (name == "resample")
+        resample ();
+    else if (name == "bank")
+        bank (vector<string> (argv + 2, argv + argc));
+    else {
+        cerr << "Unknown benchmark " << name << endl;
+        return 1;
+    }
+    return 0;
+}; //main
@@ -0,0 +1,90 @@
+/**
+ * @file Clock.h
+ * Contains the Clock class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_MISC_CLOCK_H
+#define SDL_MISC_CLOCK_H
+
+#include <SDL.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+namespace sdl {
+namespace misc {
+
+    /**
+     * @class Clock
+     * @brief Measures elapsed time in seconds.
+     *
+     * Reads the monotonic clock where available, which unlike SDL_GetTicks resolves well below a
+     * millisecond, and falls back to SDL_GetTicks elsewhere.
+     */
+    class Clock {
+        public:
+            /**
+             * Constructs a Clock started now.
+             */
+            Clock () : start_ (now ()) {};
+
+            /**
+             * Returns the number of seconds since the Clock was started.
+             *
+             * @return The elapsed seconds.
+             */
+            double elapsed () const { return now () - start_; };
+
+            /**
+             * Restarts the Clock.
+             *
+             * @return The seconds elapsed before the restart.
+             */
+            double restart () {
+                double t = now ();
+                double elapsed = t - start_;
+                start_ = t;
+                return elapsed;
+            };
+
+            /**
+             * Returns the current time of the monotonic clock.
+             *
+             * @return The time in seconds from an unspecified origin.
+             */
+            static double now () {
+#if !defined (_WIN32) && defined (CLOCK_MONOTONIC)
+                timespec ts;
+                clock_gettime (CLOCK_MONOTONIC, &ts);
+                return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+                return SDL_GetTicks () * 1e-3;
+#endif
+            };
+
+        private:
+            /**
+             * The time the Clock was started.
+             */
+            double start_;
+    }; //Clock
+}; //misc
+}; //sdl
+
+#endif //SDL_MISC_CLOCK_H
@@ -1,6 +1,6 @@
 /**
  * @file Color.h
- * Contains the Color class.
+ * Contains the Color, Masks and PixelMapper classes.
  *
  * Copyright (C) 2005 Thomas P. Lahoda
  *
@@ -21,8 +21,6 @@
 #ifndef SDL_MISC_COLOR_H
 #define SDL_MISC_COLOR_H
 
-#include <boost/shared_ptr.hpp>
-
 #include <SDL.h>
 
 namespace sdl {
@@ -30,49 +28,80 @@ namespace misc {
     /**
      * @class Color
      * @brief Represents an RGBA color.
+     *
+     * A value packed into 32 bits as 0xRRGGBBAA, copied as cheaply as an int. The constructors are
+     * constexpr, so palettes can be compile-time tables.
      */
     class Color {
         public:
             /**
-             * Constructs a Color from a SDL_Color structure.
+             * Constructs a transparent black Color.
+             */
+            constexpr Color () : rgba_ (0) {};
+
+            /**
+             * Constructs a Color.
+             *
+             * @param red The red intensity.
+             * @param green The green intensity.
+             * @param blue The blue intensity.
+             * @param alpha The alpha intensity.
+             */
+            constexpr Color (Uint8 red, Uint8 green, Uint8 blue, Uint8 alpha = SDL_ALPHA_OPAQUE)
+              : rgba_ (static_cast<Uint32> (red) << 24 | static_cast<Uint32> (green) << 16 | static_cast<Uint32> (blue) << 8 | alpha) {};
+
+            /**
+             * Constructs a Color from a SDL_Color structure, whose unused field holds the alpha intensity.
              *
              * @param c The SDL_Color structure.
              */
-            Color (SDL_Color* c) : color_ (c) {};
+            constexpr Color (const SDL_Color& c) : rgba_ (static_cast<Uint32> (c.r) << 24 | static_cast<Uint32> (c.g) << 16 | static_cast<Uint32> (c.b) << 8 | c.unused) {};
 
             /**
-             * Constructs a Color.
+             * Constructs a Color from a packed value.
              *
-             * @param red, The red intensity.
-             * @param green, The green intensity.
-             * @param blue, The blue intensity.
-             * @param alpha, The alpha intensity.
-             */
-            Color (unsigned char red, unsigned char green, unsigned char blue, unsigned char alpha)
-                : color_ (new SDL_Color ()) {
-                color_->r = red;
-                color_->g = green;
-                color_->b = blue;
-                color_->unused = alpha;
-            };
+             * @param rgba The Color packed as 0xRRGGBBAA.
+             *
+             * @return The Color.
+             */
+            static constexpr Color fromRgba (Uint32 rgba) { return Color (rgba >> 24, rgba >> 16, rgba >> 8, rgba); };
 
-            /*
-             * Return the underlying SDL_Color structure.
+            /**
+             * Returns the Color as a SDL_Color structure, with the alpha intensity in the unused field.
              *
              * @return The SDL_Color structure.
              */
-            SDL_Color* operator* () const { 
-                return color_.get (); 
+            SDL_Color to_c () const {
+                SDL_Color c;
+                c.r = red ();
+                c.g = green ();
+                c.b = blue ();
+                c.unused = alpha ();
+                return c;
             };
 
+            /**
+             * Returns the packed value.
+             *
+             * @return The Color packed as 0xRRGGBBAA.
+             */
+            constexpr Uint32 rgba () const { return rgba_; };
+
+            /**
+             * Maps the Color to a pixel value of a format. Use a PixelMapper to map many Colors to one format.
+             *
+             * @param format The pixel format.
+             *
+             * @return The pixel value.
+             */
+            Uint32 map (const SDL_PixelFormat* format) const { return SDL_MapRGBA (const_cast<SDL_PixelFormat*> (format), red (), green (), blue (), alpha ()); };
+
             /**
              * Returns the red intensity.
              *
              * @return The red intensity.
              */
-            unsigned char red () const { 
-                return color_->r; 
-            };
+            constexpr Uint8 red () const { return rgba_ >> 24; };
 
             /**
              * Sets the red intensity.
@@ -81,19 +110,14 @@ namespace misc {
              *
              * @return A reference to this Color.
              */
-            Color& red (unsigned char r) {
-                color_->r = r;
-                return *this; 
-            };
+            Color& red (Uint8 r) { return set (24, r); };
 
             /**
              * Returns the green intensity.
              *
              * @return The green intensity.
              */
-            unsigned char green () const { 
-                return color_->g; 
-            };
+            constexpr Uint8 green () const { return rgba_ >> 16; };
 
             /**
              * Sets the green intensity.
@@ -102,59 +126,256 @@ namespace misc {
              *
              * @return A reference to this Color.
              */
-            Color& green (unsigned char g) { 
-                color_->g = g;
-                return *this; 
-            };
+            Color& green (Uint8 g) { return set (16, g); };
 
             /**
              * Returns the blue intensity.
              *
              * @return The blue intensity.
              */
-            unsigned char blue () const { 
-                return color_->b; 
-            };
+            constexpr Uint8 blue () const { return rgba_ >> 8; };
 
             /**
              * Sets the blue intensity.
              *
-             * @param The blue intensity.
+             * @param b The blue intensity.
              *
              * @return A reference to this Color.
              */
-            Color& blue (unsigned char b) { 
-                color_->b = b;
-                return *this; 
-            };
+            Color& blue (Uint8 b) { return set (8, b); };
 
             /**
              * Returns the alpha intensity.
              *
              * @return The alpha intensity.
              */
-            unsigned char alpha () const { 
-                return color_->unused; 
-            };
+            constexpr Uint8 alpha () const { return rgba_; };
 
             /**
              * Sets the alpha intensity.
              *
+             * @param a The alpha intensity.
+             *
              * @return A reference to this Color.
              */
-            Color& alpha (unsigned char a) { 
-                color_->unused = a;
-                return *this; 
-            };
+            Color& alpha (Uint8 a) { return set (0, a); };
+
+            /**
+             * Determines if two Colors are equal.
+             *
+             * @param rhs The Color to compare against.
+             *
+             * @return True if every intensity is equal, false otherwise.
+             */
+            constexpr bool operator== (const Color& rhs) const { return rgba_ == rhs.rgba_; };
+
+            /**
+             * Determines if two Colors differ.
+             *
+             * @param rhs The Color to compare against.
+             *
+             * @return True if any intensity differs, false otherwise.
+             */
+            constexpr bool operator!= (const Color& rhs) const { return rgba_ != rhs.rgba_; };
 
         private:
-            /*
-             * The SDL_Color structure.
+            /**
+             * Sets an intensity.
+             *
+             * @param shift The position of the intensity.
+             * @param value The intensity.
+             *
+             * @return A reference to this Color.
+             */
+            Color& set (int shift, Uint8 value) {
+                rgba_ = (rgba_ & ~(0xffu << shift)) | static_cast<Uint32> (value) << shift;
+                return *this;
+            };
+
+            /**
+             * The Color packed as 0xRRGGBBAA.
              */
-            boost::shared_ptr<SDL_Color> color_;
+            Uint32 rgba_;
     }; //Color
+
+    /**
+     * @struct Masks
+     * @brief The bit masks of the red, green, blue and alpha channels of a pixel format.
+     */
+    struct Masks {
+        /**
+         * Constructs Masks.
+         *
+         * @param red The red mask.
+         * @param green The green mask.
+         * @param blue The blue mask.
+         * @param alpha The alpha mask, 0 for none.
+         */
+        constexpr Masks (Uint32 red, Uint32 green, Uint32 blue, Uint32 alpha) : red_ (red), green_ (green), blue_ (blue), alpha_ (alpha) {};
+
+        /**
+         * Constructs the Masks of a pixel format.
+         *
+         * @param format The pixel format.
+         */
+        explicit Masks (const SDL_PixelFormat* format) : red_ (format->Rmask), green_ (format->Gmask), blue_ (format->Bmask), alpha_ (format->Amask) {};
+
+        /**
+         * Returns the Masks of 32 bit pixels holding 0xAARRGGBB, the usual display format.
+         *
+         * @return The Masks.
+         */
+        static constexpr Masks argb8888 () { return Masks (0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000); };
+
+        /**
+         * Returns the Masks of 32 bit pixels holding 0xRRGGBBAA.
+         *
+         * @return The Masks.
+         */
+        static constexpr Masks rgba8888 () { return Masks (0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff); };
+
+        /**
+         * Returns the Masks of 32 bit pixels laid out in memory as red, green, blue, alpha bytes.
+         *
+         * @return The Masks.
+         */
+        static constexpr Masks bytesRgba () {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            return rgba8888 ();
+#else
+            return Masks (0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+#endif
+        };
+
+        /**
+         * Returns the Masks of 16 bit pixels with 5 bits of red, 6 of green and 5 of blue.
+         *
+         * @return The Masks.
+         */
+        static constexpr Masks rgb565 () { return Masks (0xf800, 0x07e0, 0x001f, 0); };
+
+        /**
+         * The red mask.
+         */
+        Uint32 red_;
+
+        /**
+         * The green mask.
+         */
+        Uint32 green_;
+
+        /**
+         * The blue mask.
+         */
+        Uint32 blue_;
+
+        /**
+         * The alpha mask.
+         */
+        Uint32 alpha_;
+    }; //Masks
+
+    /**
+     * @class PixelMapper
+     * @brief Maps Colors to and from the pixel values of one format.
+     *
+     * Keeps the format's shifts and losses, so mapping a truecolor pixel is a few shifts inline
+     * rather than a call into SDL. Results equal SDL_MapRGBA and SDL_GetRGBA. Paletted formats
+     * go through SDL, remembering the last Color mapped since runs of one color are common.
+     * The format must outlive the PixelMapper.
+     */
+    class PixelMapper {
+        public:
+            /**
+             * Constructs a PixelMapper.
+             *
+             * @param format The pixel format.
+             */
+            explicit PixelMapper (const SDL_PixelFormat* format)
+              : format_ (const_cast<SDL_PixelFormat*> (format)), last_ (), lastPixel_ (format->palette != NULL ? SDL_MapRGBA (format_, 0, 0, 0, 0) : 0) {};
+
+            /**
+             * Maps a Color to a pixel value.
+             *
+             * @param color The Color.
+             *
+             * @return The pixel value.
+             */
+            Uint32 map (const Color& color) const {
+                const SDL_PixelFormat* f = format_;
+                if (f->palette != NULL) {
+                    if (color != last_) {
+                        last_ = color;
+                        lastPixel_ = SDL_MapRGBA (format_, color.red (), color.green (), color.blue (), color.alpha ());
+                    }
+                    return lastPixel_;
+                }
+                return (color.red () >> f->Rloss) << f->Rshift
+                     | (color.green () >> f->Gloss) << f->Gshift
+                     | (color.blue () >> f->Bloss) << f->Bshift
+                     | ((color.alpha () >> f->Aloss) << f->Ashift & f->Amask);
+            };
+
+            /**
+             * Maps a pixel value to a Color.
+             *
+             * @param pixel The pixel value.
+             *
+             * @return The Color, opaque if the format has no alpha.
+             */
+            Color unmap (Uint32 pixel) const {
+                const SDL_PixelFormat* f = format_;
+                if (f->palette != NULL || f->Rloss > 4 || f->Gloss > 4 || f->Bloss > 4 || (f->Amask != 0 && f->Aloss > 4)) {
+                    Uint8 r, g, b, a;
+                    SDL_GetRGBA (pixel, format_, &r, &g, &b, &a);
+                    return Color (r, g, b, a);
+                }
+                return Color (expand (pixel, f->Rmask, f->Rshift, f->Rloss),
+                              expand (pixel, f->Gmask, f->Gshift, f->Gloss),
+                              expand (pixel, f->Bmask, f->Bshift, f->Bloss),
+                              f->Amask != 0 ? expand (pixel, f->Amask, f->Ashift, f->Aloss) : SDL_ALPHA_OPAQUE);
+            };
+
+            /**
+             * Returns the pixel format.
+             *
+             * @return The pixel format.
+             */
+            const SDL_PixelFormat* format () const { return format_; };
+
+        private:
+            /**
+             * Widens a channel to 8 bits, replicating its high bits into the low ones so the
+             * largest value becomes 255.
+             *
+             * @param pixel The pixel value.
+             * @param mask The mask of the channel.
+             * @param shift The shift of the channel.
+             * @param loss The number of bits the channel lacks of 8.
+             *
+             * @return The 8 bit intensity.
+             */
+            static Uint8 expand (Uint32 pixel, Uint32 mask, Uint8 shift, Uint8 loss) {
+                unsigned int v = (pixel & mask) >> shift;
+                return (v << loss) + (v >> (8 - (loss << 1)));
+            };
+
+            /**
+             * The pixel format.
+             */
+            SDL_PixelFormat* format_;
+
+            /**
+             * The last Color mapped to a paletted format.
+             */
+            mutable Color last_;
+
+            /**
+             * The pixel value of the last Color mapped to a paletted format.
+             */
+            mutable Uint32 lastPixel_;
+    }; //PixelMapper
 }; //misc
 }; //sdl
 
 #endif //SDL_MISC_COLOR_H
-
@@ -0,0 +1,130 @@
+/**
+ * @file MappedFile.h
+ * Contains the MappedFile class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_MISC_MAPPEDFILE_H
+#define SDL_MISC_MAPPEDFILE_H
+
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace sdl {
+namespace misc {
+    using namespace std;
+
+    /**
+     * @class MappedFile
+     * @brief Maps a whole file into memory.
+     *
+     * The mapping is private, pages are shared with the page cache until written to, at which
+     * point the writer gets its own copy and the file is left untouched.
+     */
+    class MappedFile {
+        public:
+            /**
+             * Maps a file.
+             *
+             * @param fileName The name of the file.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to map the file.
+             */
+            explicit MappedFile (const string& fileName) : fileName_ (fileName), data_ (0), size_ (0) {
+                int fd = open (fileName.c_str (), O_RDONLY);
+                if (fd == -1)
+                    throw runtime_error ("Failed to open " + fileName);
+                struct stat st;
+                if (fstat (fd, &st) == -1 || st.st_size == 0) {
+                    close (fd);
+                    throw runtime_error ("Failed to map empty file " + fileName);
+                }
+                size_ = st.st_size;
+                void* data = mmap (0, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                close (fd);
+                if (data == MAP_FAILED)
+                    throw runtime_error ("Failed to map " + fileName);
+                data_ = static_cast<unsigned char*> (data);
+            };
+
+            /**
+             * Unmaps the file.
+             */
+            ~MappedFile () { munmap (data_, size_); };
+
+            /**
+             * Returns the name of the mapped file.
+             *
+             * @return The name of the file.
+             */
+            const string& fileName () const { return fileName_; };
+
+            /**
+             * Returns the start of the mapping.
+             *
+             * @return The start of the mapping.
+             */
+            unsigned char* data () const { return data_; };
+
+            /**
+             * Returns the size of the mapping in bytes.
+             *
+             * @return The size of the mapping.
+             */
+            size_t size () const { return size_; };
+
+        private:
+            /**
+             * Copy constructs a MappedFile.
+             *
+             * @param rhs The MappedFile to copy.
+             */
+            MappedFile (const MappedFile& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The MappedFile from which to assign.
+             *
+             * @return A reference to this MappedFile.
+             */
+            MappedFile& operator= (const MappedFile& rhs);
+
+            /**
+             * The name of the mapped file.
+             */
+            string fileName_;
+
+            /**
+             * The start of the mapping.
+             */
+            unsigned char* data_;
+
+            /**
+             * The size of the mapping in bytes.
+             */
+            size_t size_;
+    }; //MappedFile
+}; //misc
+}; //sdl
+
+#endif //SDL_MISC_MAPPEDFILE_H
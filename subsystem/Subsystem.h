@@ -21,6 +21,8 @@
 #ifndef SDL_SUBSYSTEM_SUBSYSTEM_H
 #define SDL_SUBSYSTEM_SUBSYSTEM_H
 
+#include <cstdlib>
+#include <list>
 #include <stdexcept>
 #include <string>
 
@@ -130,10 +132,68 @@ namespace subsystem {
             Subsystem& operator= (const Subsystem& rhs) {};
     }; //Subsystem
 
+    /**
+     * @struct EnvironmentBase
+     * @brief Base for the subsystems configured through environment variables.
+     */
+    struct EnvironmentBase {
+        protected:
+            /**
+             * Sets an environment variable, replacing any earlier value.
+             *
+             * @param name The name of the variable.
+             * @param value The value.
+             */
+            static void setEnvironment (const string& name, const string& value) {
+#ifndef _WIN32
+                setenv (name.c_str (), value.c_str (), 1);
+#else
+                //putenv keeps the pointer, so every setting ever made must outlive the process' use of it.
+                static list<string> settings;
+                settings.push_back (name + "=" + value);
+                SDL_putenv (const_cast<char*> (settings.back ().c_str ()));
+#endif
+            };
+    }; //EnvironmentBase
+
     /**
      * Base for the audio subsystem.
      */
-    struct AudioBase {
+    struct AudioBase : public EnvironmentBase {
+        /**
+         * Selects the audio driver by setting SDL_AUDIODRIVER. Takes effect the next time the
+         * Subsystem opens, so call it before the first call to instance or between close and open.
+         *
+         * @param name The name of the driver, such as "alsa", "pulse" or "dummy".
+         */
+        static void driver (const string& name) { setEnvironment ("SDL_AUDIODRIVER", name); };
+
+        /**
+         * Selects the dummy audio driver, which needs no sound card and discards the output while
+         * still running the callback in real time.
+         */
+        static void headless () { driver ("dummy"); };
+
+        /**
+         * Selects the disk audio driver, which writes the raw output to a file.
+         *
+         * @param fileName The name of the file.
+         */
+        static void disk (const string& fileName) {
+            setEnvironment ("SDL_DISKAUDIOFILE", fileName);
+            driver ("disk");
+        };
+
+        /**
+         * Returns the name of the audio driver in use.
+         *
+         * @return The name of the driver, empty if the Subsystem is not open.
+         */
+        static string driverName () {
+            char name[64];
+            return SDL_AudioDriverName (name, sizeof (name)) != NULL ? string (name) : string ();
+        };
+
         protected:
             /**
              * Returns the name of the Subsystem.
@@ -328,12 +388,60 @@ namespace subsystem {
     /**
      * @struct VideoBase, Base for the video subsystem.
      */
-    struct VideoBase {
+    struct VideoBase : public EnvironmentBase {
         /**
          * Swaps the OpenGL frame buffers if double-buffering is supported.
          */
         void swapBuffers () { SDL_GL_SwapBuffers (); };
 
+        /**
+         * Selects the video driver by setting SDL_VIDEODRIVER. Takes effect the next time the
+         * Subsystem opens, so call it before the first call to instance or between close and open.
+         *
+         * @param name The name of the driver, such as "x11" or "dummy".
+         */
+        static void driver (const string& name) { setEnvironment ("SDL_VIDEODRIVER", name); };
+
+        /**
+         * Selects the dummy video driver, which needs no display or GPU. The display Surface
+         * lives in memory and YUV Overlays are converted in software, so rendering behaves as it
+         * does on a software display and frames can be read back from the display Surface.
+         */
+        static void headless () { driver ("dummy"); };
+
+        /**
+         * Selects the dummy video driver if no display is available, unless a driver was
+         * chosen explicitly through SDL_VIDEODRIVER.
+         *
+         * @return True if the dummy driver was selected, false otherwise.
+         */
+        static bool headlessIfNoDisplay () {
+#ifndef _WIN32
+            if (SDL_getenv ("SDL_VIDEODRIVER") == NULL && SDL_getenv ("DISPLAY") == NULL) {
+                headless ();
+                return true;
+            }
+#endif
+            return false;
+        };
+
+        /**
+         * Returns the name of the video driver in use.
+         *
+         * @return The name of the driver, empty if the Subsystem is not open.
+         */
+        static string driverName () {
+            char name[64];
+            return SDL_VideoDriverName (name, sizeof (name)) != NULL ? string (name) : string ();
+        };
+
+        /**
+         * Determines if the dummy video driver is in use.
+         *
+         * @return True if running headless, false otherwise.
+         */
+        static bool isHeadless () { return driverName () == "dummy"; };
+
         protected:
             /**
              * Returns the name of the Subsystem.
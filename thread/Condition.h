@@ -0,0 +1,120 @@
+/**
+ * @file Condition.h
+ * Contains the Condition class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_THREAD_CONDITION_H
+#define SDL_THREAD_CONDITION_H
+
+#include <stdexcept>
+
+#include <SDL.h>
+#include <SDL_mutex.h>
+
+#include "sdlpp/thread/Mutex.h"
+
+namespace sdl {
+namespace thread {
+    using namespace std;
+
+    /**
+     * @class Condition
+     * @brief Represents a condition variable.
+     */
+    class Condition {
+        public:
+            /**
+             * Constructs a Condition.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create the condition variable.
+             */
+            Condition () : cond_ (SDL_CreateCond ()) {
+                if (cond_ == NULL)
+                    throw runtime_error (SDL_GetError ());
+            };
+
+            /**
+             * Destroys the Condition.
+             */
+            ~Condition () { SDL_DestroyCond (cond_); };
+
+            /**
+             * Wakes one thread waiting on the Condition.
+             *
+             * @return A reference to this Condition.
+             */
+            Condition& signal () {
+                SDL_CondSignal (cond_);
+                return *this;
+            };
+
+            /**
+             * Wakes all threads waiting on the Condition.
+             *
+             * @return A reference to this Condition.
+             */
+            Condition& broadcast () {
+                SDL_CondBroadcast (cond_);
+                return *this;
+            };
+
+            /**
+             * Atomically unlocks the Lock's Mutex and waits to be signaled. The Mutex is locked again on return.
+             *
+             * @param lock The Lock holding the Mutex.
+             *
+             * @return True if successful, false otherwise.
+             */
+            bool wait (Lock& lock) { return SDL_CondWait (cond_, lock.mutex ().to_c ()) == 0; };
+
+            /**
+             * Waits to be signaled for at most the given time.
+             *
+             * @param lock The Lock holding the Mutex.
+             * @param ms The number of milliseconds to wait.
+             *
+             * @return True if signaled, false if timed out or failed.
+             */
+            bool wait (Lock& lock, unsigned int ms) { return SDL_CondWaitTimeout (cond_, lock.mutex ().to_c (), ms) == 0; };
+
+        private:
+            /**
+             * Copy constructs a Condition.
+             *
+             * @param rhs The Condition to copy.
+             */
+            Condition (const Condition& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The Condition from which to assign.
+             *
+             * @return A reference to this Condition.
+             */
+            Condition& operator= (const Condition& rhs);
+
+            /**
+             * The SDL_cond structure.
+             */
+            SDL_cond* cond_;
+    }; //Condition
+}; //thread
+}; //sdl
+
+#endif //SDL_THREAD_CONDITION_H
@@ -0,0 +1,148 @@
+/**
+ * @file Mutex.h
+ * Contains the Mutex and Lock classes.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_THREAD_MUTEX_H
+#define SDL_THREAD_MUTEX_H
+
+#include <stdexcept>
+
+#include <SDL.h>
+#include <SDL_mutex.h>
+
+namespace sdl {
+namespace thread {
+    using namespace std;
+
+    /**
+     * @class Mutex
+     * @brief Represents a mutex.
+     */
+    class Mutex {
+        public:
+            /**
+             * Constructs a Mutex.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create the mutex.
+             */
+            Mutex () : mutex_ (SDL_CreateMutex ()) {
+                if (mutex_ == NULL)
+                    throw runtime_error (SDL_GetError ());
+            };
+
+            /**
+             * Destroys the Mutex.
+             */
+            ~Mutex () { SDL_DestroyMutex (mutex_); };
+
+            /**
+             * Locks the Mutex.
+             *
+             * @return True if successful, false otherwise.
+             */
+            bool lock () { return SDL_mutexP (mutex_) == 0; };
+
+            /**
+             * Unlocks the Mutex.
+             *
+             * @return True if successful, false otherwise.
+             */
+            bool unlock () { return SDL_mutexV (mutex_) == 0; };
+
+            /**
+             * Exposes the underlying SDL_mutex structure.
+             *
+             * @return The SDL_mutex structure.
+             */
+            SDL_mutex* to_c () const { return mutex_; };
+
+        private:
+            /**
+             * Copy constructs a Mutex.
+             *
+             * @param rhs The Mutex to copy.
+             */
+            Mutex (const Mutex& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The Mutex from which to assign.
+             *
+             * @return A reference to this Mutex.
+             */
+            Mutex& operator= (const Mutex& rhs);
+
+            /**
+             * The SDL_mutex structure.
+             */
+            SDL_mutex* mutex_;
+    }; //Mutex
+
+    /**
+     * @class Lock
+     * @brief Holds a Mutex locked for the lifetime of the Lock.
+     */
+    class Lock {
+        public:
+            /**
+             * Locks a Mutex.
+             *
+             * @param mutex The Mutex to lock.
+             */
+            explicit Lock (Mutex& mutex) : mutex_ (mutex) { mutex_.lock (); };
+
+            /**
+             * Unlocks the Mutex.
+             */
+            ~Lock () { mutex_.unlock (); };
+
+            /**
+             * Returns the locked Mutex.
+             *
+             * @return The Mutex.
+             */
+            Mutex& mutex () { return mutex_; };
+
+        private:
+            /**
+             * Copy constructs a Lock.
+             *
+             * @param rhs The Lock to copy.
+             */
+            Lock (const Lock& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The Lock from which to assign.
+             *
+             * @return A reference to this Lock.
+             */
+            Lock& operator= (const Lock& rhs);
+
+            /**
+             * The locked Mutex.
+             */
+            Mutex& mutex_;
+    }; //Lock
+}; //thread
+}; //sdl
+
+#endif //SDL_THREAD_MUTEX_H
@@ -0,0 +1,156 @@
+/**
+ * @file SpscQueue.h
+ * Contains the SpscQueue class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_THREAD_SPSCQUEUE_H
+#define SDL_THREAD_SPSCQUEUE_H
+
+#include <atomic>
+#include <vector>
+
+namespace sdl {
+namespace thread {
+    using namespace std;
+
+    /**
+     * @class SpscQueue
+     * @brief A bounded lock-free queue between one producer thread and one consumer thread.
+     *
+     * Neither push nor pop blocks or allocates, so it can feed a real-time thread such as the
+     * audio callback. Each end must only be used from its own thread.
+     *
+     * @tparam T The type of the items, copied in and out.
+     */
+    template<class T>
+    class SpscQueue {
+        public:
+            /**
+             * Constructs a SpscQueue.
+             *
+             * @param capacity The number of items it can hold, rounded up to a power of two.
+             */
+            explicit SpscQueue (size_t capacity) : items_ (round (capacity)), mask_ (items_.size () - 1), head_ (0), tail_ (0) {};
+
+            /**
+             * Adds an item. Called from the producer thread only.
+             *
+             * @param item The item.
+             *
+             * @return True if added, false if the SpscQueue is full.
+             */
+            bool push (const T& item) {
+                size_t tail = tail_.load (memory_order_relaxed);
+                if (tail - head_.load (memory_order_acquire) == items_.size ())
+                    return false;
+                items_[tail & mask_] = item;
+                tail_.store (tail + 1, memory_order_release);
+                return true;
+            };
+
+            /**
+             * Removes the oldest item. Called from the consumer thread only.
+             *
+             * @param item Receives the item.
+             *
+             * @return True if an item was removed, false if the SpscQueue is empty.
+             */
+            bool pop (T& item) {
+                size_t head = head_.load (memory_order_relaxed);
+                if (head == tail_.load (memory_order_acquire))
+                    return false;
+                item = items_[head & mask_];
+                head_.store (head + 1, memory_order_release);
+                return true;
+            };
+
+            /**
+             * Returns the number of items, exact only when called from either end.
+             *
+             * @return The number of items.
+             */
+            size_t size () const { return tail_.load (memory_order_acquire) - head_.load (memory_order_acquire); };
+
+            /**
+             * Returns the number of items the SpscQueue can hold.
+             *
+             * @return The capacity.
+             */
+            size_t capacity () const { return items_.size (); };
+
+        private:
+            /**
+             * Copy constructs a SpscQueue.
+             *
+             * @param rhs The SpscQueue to copy.
+             */
+            SpscQueue (const SpscQueue& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The SpscQueue from which to assign.
+             *
+             * @return A reference to this SpscQueue.
+             */
+            SpscQueue& operator= (const SpscQueue& rhs);
+
+            /**
+             * Rounds a capacity up to a power of two.
+             *
+             * @param capacity The capacity.
+             *
+             * @return The rounded capacity, at least 2.
+             */
+            static size_t round (size_t capacity) {
+                size_t size = 2;
+                while (size < capacity)
+                    size <<= 1;
+                return size;
+            };
+
+            /**
+             * The items.
+             */
+            vector<T> items_;
+
+            /**
+             * The size of items_ less one, masking a position to an index.
+             */
+            size_t mask_;
+
+            /**
+             * The position of the oldest item, advanced by the consumer. Padded away from tail_ so
+             * the two threads do not contend for one cache line.
+             */
+            atomic<size_t> head_;
+
+            /**
+             * Padding between head_ and tail_.
+             */
+            char pad_[64];
+
+            /**
+             * The position after the newest item, advanced by the producer.
+             */
+            atomic<size_t> tail_;
+    }; //SpscQueue
+}; //thread
+}; //sdl
+
+#endif //SDL_THREAD_SPSCQUEUE_H
@@ -0,0 +1,137 @@
+/**
+ * @file Thread.h
+ * Contains the Thread class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_THREAD_THREAD_H
+#define SDL_THREAD_THREAD_H
+
+#include <stdexcept>
+
+#include <boost/function.hpp>
+
+#include <SDL.h>
+#include <SDL_thread.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace sdl {
+namespace thread {
+    using namespace std;
+
+    /**
+     * @class Thread
+     * @brief Represents a thread of execution.
+     */
+    class Thread {
+        public:
+            /**
+             * @typedef boost::function<void ()> Function
+             * @brief The type of the function run by a Thread.
+             */
+            typedef boost::function<void ()> Function;
+
+            /**
+             * Starts a Thread running a function.
+             *
+             * @param function The function to run.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create the thread.
+             */
+            explicit Thread (const Function& function) : function_ (function), thread_ (SDL_CreateThread (&Thread::run, this)) {
+                if (thread_ == NULL)
+                    throw runtime_error (SDL_GetError ());
+            };
+
+            /**
+             * Waits for the Thread to finish.
+             */
+            ~Thread () { join (); };
+
+            /**
+             * Waits for the Thread to finish.
+             *
+             * @return A reference to this Thread.
+             */
+            Thread& join () {
+                if (thread_ != NULL) {
+                    SDL_WaitThread (thread_, NULL);
+                    thread_ = NULL;
+                }
+                return *this;
+            };
+
+            /**
+             * Returns the number of processors, which is a sensible default number of worker threads.
+             *
+             * @return The number of online processors, at least 1.
+             */
+            static unsigned int processors () {
+#ifdef _SC_NPROCESSORS_ONLN
+                long count = sysconf (_SC_NPROCESSORS_ONLN);
+                return count > 0 ? static_cast<unsigned int> (count) : 1;
+#else
+                return 1;
+#endif
+            };
+
+        private:
+            /**
+             * Copy constructs a Thread.
+             *
+             * @param rhs The Thread to copy.
+             */
+            Thread (const Thread& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The Thread from which to assign.
+             *
+             * @return A reference to this Thread.
+             */
+            Thread& operator= (const Thread& rhs);
+
+            /**
+             * The SDL thread entry point.
+             *
+             * @param data The Thread.
+             *
+             * @return The thread exit status.
+             */
+            static int run (void* data) {
+                static_cast<Thread*> (data)->function_ ();
+                return 0;
+            };
+
+            /**
+             * The function run by the Thread.
+             */
+            Function function_;
+
+            /**
+             * The SDL_Thread structure.
+             */
+            SDL_Thread* thread_;
+    }; //Thread
+}; //thread
+}; //sdl
+
+#endif //SDL_THREAD_THREAD_H
@@ -0,0 +1,236 @@
+/**
+ * @file ThreadPool.h
+ * Contains the ThreadPool class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_THREAD_THREADPOOL_H
+#define SDL_THREAD_THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+
+#include <boost/bind/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include "sdlpp/thread/Mutex.h"
+#include "sdlpp/thread/Condition.h"
+#include "sdlpp/thread/Thread.h"
+
+namespace sdl {
+namespace thread {
+    using namespace std;
+
+    /**
+     * @class ThreadPool
+     * @brief Runs submitted tasks on a fixed set of worker Threads.
+     */
+    class ThreadPool {
+        public:
+            /**
+             * @typedef boost::function<void ()> Task
+             * @brief The type of a task.
+             */
+            typedef boost::function<void ()> Task;
+
+            /**
+             * @typedef boost::function<void (size_t)> IndexedTask
+             * @brief The type of a task run once per index.
+             */
+            typedef boost::function<void (size_t)> IndexedTask;
+
+            /**
+             * Starts the worker Threads.
+             *
+             * @param threads The number of worker Threads, 0 for one per processor.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create a Thread, after stopping those already started.
+             */
+            explicit ThreadPool (unsigned int threads = 0)
+              : mutex_ (), work_ (), idle_ (), tasks_ (), active_ (0), stopping_ (false), threads_ () {
+                if (threads == 0)
+                    threads = Thread::processors ();
+                try {
+                    for (unsigned int i = 0; i < threads; ++i)
+                        threads_.push_back (new Thread (boost::bind (&ThreadPool::work, this)));
+                } catch (...) {
+                    stop ();
+                    throw;
+                }
+            };
+
+            /**
+             * Finishes the queued tasks and stops the worker Threads.
+             */
+            ~ThreadPool () { stop (); };
+
+            /**
+             * Queues a task.
+             *
+             * @param task The task.
+             *
+             * @return A reference to this ThreadPool.
+             */
+            ThreadPool& submit (const Task& task) {
+                Lock lock (mutex_);
+                tasks_.push_back (task);
+                work_.signal ();
+                return *this;
+            };
+
+            /**
+             * Waits until every queued task has finished.
+             *
+             * @return A reference to this ThreadPool.
+             */
+            ThreadPool& wait () {
+                Lock lock (mutex_);
+                while (!tasks_.empty () || active_ != 0)
+                    idle_.wait (lock);
+                return *this;
+            };
+
+            /**
+             * Runs a task once for every index in [0, count) and waits for all of them. Each worker
+             * claims the next unclaimed index when it finishes one, so uneven indices balance out.
+             *
+             * @param count The number of indices.
+             * @param task The task.
+             *
+             * @return A reference to this ThreadPool.
+             */
+            ThreadPool& forEach (size_t count, const IndexedTask& task) {
+                atomic<size_t> next (0);
+                size_t workers = min (count, threads_.size ());
+                for (size_t i = 0; i < workers; ++i)
+                    submit (boost::bind (&ThreadPool::claim, &next, count, boost::cref (task)));
+                return wait ();
+            };
+
+            /**
+             * Returns the number of worker Threads.
+             *
+             * @return The number of worker Threads.
+             */
+            size_t size () const { return threads_.size (); };
+
+        private:
+            /**
+             * Copy constructs a ThreadPool.
+             *
+             * @param rhs The ThreadPool to copy.
+             */
+            ThreadPool (const ThreadPool& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The ThreadPool from which to assign.
+             *
+             * @return A reference to this ThreadPool.
+             */
+            ThreadPool& operator= (const ThreadPool& rhs);
+
+            /**
+             * Wakes the worker Threads to finish the queued tasks and exit, and joins them.
+             */
+            void stop () {
+                {
+                    Lock lock (mutex_);
+                    stopping_ = true;
+                    work_.broadcast ();
+                }
+                threads_.clear ();
+            };
+
+            /**
+             * Runs a task for indices until none are left.
+             *
+             * @param next The next unclaimed index.
+             * @param count The number of indices.
+             * @param task The task.
+             */
+            static void claim (atomic<size_t>* next, size_t count, const IndexedTask& task) {
+                for (size_t i = (*next)++; i < count; i = (*next)++)
+                    task (i);
+            };
+
+            /**
+             * The worker Thread loop.
+             */
+            void work () {
+                Lock lock (mutex_);
+                for (;;) {
+                    while (tasks_.empty () && !stopping_)
+                        work_.wait (lock);
+                    if (tasks_.empty ())
+                        return;
+                    Task task = tasks_.front ();
+                    tasks_.pop_front ();
+                    ++active_;
+                    mutex_.unlock ();
+                    //tasks report their own errors, an escaping exception must not kill the worker.
+                    try {
+                        task ();
+                    } catch (...) {}
+                    mutex_.lock ();
+                    if (--active_ == 0 && tasks_.empty ())
+                        idle_.broadcast ();
+                }
+            };
+
+            /**
+             * Guards the task queue.
+             */
+            Mutex mutex_;
+
+            /**
+             * Signaled when a task is queued or the pool is stopping.
+             */
+            Condition work_;
+
+            /**
+             * Signaled when the pool runs out of work.
+             */
+            Condition idle_;
+
+            /**
+             * The queued tasks.
+             */
+            deque<Task> tasks_;
+
+            /**
+             * The number of tasks running.
+             */
+            unsigned int active_;
+
+            /**
+             * Whether or not the pool is stopping.
+             */
+            bool stopping_;
+
+            /**
+             * The worker Threads.
+             */
+            boost::ptr_vector<Thread> threads_;
+    }; //ThreadPool
+}; //thread
+}; //sdl
+
+#endif //SDL_THREAD_THREADPOOL_H
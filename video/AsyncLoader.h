@@ -0,0 +1,385 @@
+/**
+ * @file AsyncLoader.h
+ * Contains the Load and AsyncLoader classes.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_ASYNCLOADER_H
+#define SDL_VIDEO_ASYNCLOADER_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/video/DisplayFormatCache.h"
+#include "sdlpp/event/Queue.h"
+#include "sdlpp/event/UserDefined.h"
+#include "sdlpp/thread/Mutex.h"
+#include "sdlpp/thread/Condition.h"
+#include "sdlpp/thread/ThreadPool.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace thread;
+
+    /**
+     * @class Load
+     * @brief A handle to a bitmap being loaded in the background.
+     */
+    class Load {
+        public:
+            /**
+             * Returns the name of the file being loaded.
+             *
+             * @return The name of the file.
+             */
+            const string& fileName () const { return state_->fileName_; };
+
+            /**
+             * Determines if the load has finished, successfully or not.
+             *
+             * @return True if finished, false otherwise.
+             */
+            bool ready () const {
+                Lock lock (state_->mutex_);
+                return state_->done_;
+            };
+
+            /**
+             * Waits for the load to finish and returns the loaded Surface in its file format.
+             *
+             * @return The loaded Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if the bitmap could not be loaded.
+             */
+            Surface get () const {
+                Lock lock (state_->mutex_);
+                while (!state_->done_)
+                    state_->finished_.wait (lock);
+                if (state_->surface_.get () == NULL)
+                    throw runtime_error (state_->error_);
+                return *state_->surface_;
+            };
+
+            /**
+             * Waits for the load to finish and returns the loaded Surface converted to the display
+             * format. Must be called from the thread that set the video mode.
+             *
+             * @param cache The DisplayFormatCache through which to convert.
+             * @param alpha Whether or not to convert to the display format with an alpha channel.
+             *
+             * @return The converted Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if the bitmap could not be loaded or converted.
+             */
+            Surface get (DisplayFormatCache& cache, bool alpha = false) const { return cache.get (get (), alpha); };
+
+        private:
+            friend class AsyncLoader;
+
+            /**
+             * @struct State
+             * @brief The state shared between the loading worker and the Load handles.
+             */
+            struct State {
+                /**
+                 * Constructs the State of a pending load.
+                 *
+                 * @param fileName The name of the file.
+                 * @param id The identifier of the load.
+                 */
+                State (const string& fileName, int id)
+                  : fileName_ (fileName), id_ (id), mutex_ (), finished_ (), done_ (false), surface_ (), error_ () {};
+
+                /**
+                 * The name of the file.
+                 */
+                string fileName_;
+
+                /**
+                 * The identifier of the load, carried by the completion event.
+                 */
+                int id_;
+
+                /**
+                 * Guards the result.
+                 */
+                Mutex mutex_;
+
+                /**
+                 * Signaled when the load finishes.
+                 */
+                Condition finished_;
+
+                /**
+                 * Whether or not the load has finished.
+                 */
+                bool done_;
+
+                /**
+                 * The loaded Surface, empty on failure.
+                 */
+                boost::shared_ptr<Surface> surface_;
+
+                /**
+                 * The error on failure.
+                 */
+                string error_;
+            }; //State
+
+            /**
+             * Constructs a Load.
+             *
+             * @param state The shared State.
+             */
+            explicit Load (const boost::shared_ptr<State>& state) : state_ (state) {};
+
+            /**
+             * The shared State.
+             */
+            boost::shared_ptr<State> state_;
+    }; //Load
+
+    /**
+     * @class AsyncLoader
+     * @brief Decodes bitmaps on a pool of worker threads.
+     *
+     * Workers only produce Surfaces in the file format, conversion to the display format is left
+     * to the main thread through Load::get (DisplayFormatCache&). When notification is enabled every
+     * finished load pushes a Loaded user event onto the event Queue which is turned back into its
+     * Load with complete; every Loaded event must be passed to complete, or its load is held for
+     * good. SDL's event queue is small, so an event that finds it full is kept and pushed again
+     * by the next call to load, complete or wait on the main thread.
+     */
+    class AsyncLoader {
+        public:
+            /**
+             * The user event code of the completion event.
+             */
+            enum { LOADED = 0x4c44 };
+
+            /**
+             * @typedef event::UserDefined<LOADED> Loaded
+             * @brief The completion event.
+             */
+            typedef event::UserDefined<LOADED> Loaded;
+
+            /**
+             * Constructs an AsyncLoader.
+             *
+             * @param threads The number of worker threads, 0 for one per processor.
+             * @param notify Whether or not to push a Loaded event for every finished load.
+             */
+            explicit AsyncLoader (unsigned int threads = 0, bool notify = false)
+              : mutex_ (), finished_ (), unsent_ (), nextId_ (0), notify_ (notify), pool_ (threads) {};
+
+            /**
+             * Finishes the pending loads and stops the worker threads.
+             */
+            ~AsyncLoader () {};
+
+            /**
+             * Queues a bitmap to be loaded.
+             *
+             * @param fileName The name of the file.
+             *
+             * @return The Load handle.
+             */
+            Load load (const string& fileName) {
+                int id;
+                {
+                    Lock lock (mutex_);
+                    resend ();
+                    id = nextId_++;
+                }
+                boost::shared_ptr<Load::State> state (new Load::State (fileName, id));
+                pool_.submit (boost::bind (&AsyncLoader::decode, this, state));
+                return Load (state);
+            };
+
+            /**
+             * Queues many bitmaps to be loaded.
+             *
+             * @param fileNames The names of the files.
+             *
+             * @return The Load handles in the same order.
+             */
+            vector<Load> load (const vector<string>& fileNames) {
+                vector<Load> loads;
+                loads.reserve (fileNames.size ());
+                for (vector<string>::const_iterator cur = fileNames.begin (); cur != fileNames.end (); ++cur)
+                    loads.push_back (load (*cur));
+                return loads;
+            };
+
+            /**
+             * Returns the Load a completion event was pushed for.
+             *
+             * @param event The completion event.
+             *
+             * @return The finished Load.
+             *
+             * @throw runtime_error Throws a runtime_error if the event does not belong to this AsyncLoader.
+             */
+            Load complete (const Loaded& event) {
+                if (event.get ().data1 != this)
+                    throw runtime_error ("Load completion for another loader.");
+                Lock lock (mutex_);
+                resend ();
+                Finished::iterator cur = finished_.find (static_cast<int> (reinterpret_cast<size_t> (event.get ().data2)));
+                if (cur == finished_.end ())
+                    throw runtime_error ("Unknown load completion.");
+                Load load (cur->second);
+                finished_.erase (cur);
+                return load;
+            };
+
+            /**
+             * Waits until every queued load has finished.
+             *
+             * @return A reference to this AsyncLoader.
+             */
+            AsyncLoader& wait () {
+                pool_.wait ();
+                Lock lock (mutex_);
+                resend ();
+                return *this;
+            };
+
+        private:
+            /**
+             * Copy constructs an AsyncLoader.
+             *
+             * @param rhs The AsyncLoader to copy.
+             */
+            AsyncLoader (const AsyncLoader& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The AsyncLoader from which to assign.
+             *
+             * @return A reference to this AsyncLoader.
+             */
+            AsyncLoader& operator= (const AsyncLoader& rhs);
+
+            /**
+             * Decodes a bitmap on a worker thread.
+             *
+             * @param state The State of the load.
+             */
+            void decode (boost::shared_ptr<Load::State> state) {
+                boost::shared_ptr<Surface> surface;
+                string error;
+                try {
+                    surface.reset (new Surface (state->fileName_));
+                } catch (const exception& e) {
+                    error = e.what ();
+                }
+
+                {
+                    Lock lock (state->mutex_);
+                    state->surface_ = surface;
+                    state->error_ = error;
+                    state->done_ = true;
+                    state->finished_.broadcast ();
+                }
+
+                if (notify_) {
+                    Lock lock (mutex_);
+                    finished_[state->id_] = state;
+                    if (!unsent_.empty () || !push (state->id_))
+                        unsent_.push_back (state->id_);
+                }
+            };
+
+            /**
+             * Pushes the completion event of a load.
+             *
+             * @param id The identifier of the load.
+             *
+             * @return True if pushed, false if the event queue is full.
+             */
+            bool push (int id) {
+                SDL_Event event;
+                event.type = SDL_USEREVENT;
+                event.user.code = LOADED;
+                event.user.data1 = this;
+                event.user.data2 = reinterpret_cast<void*> (static_cast<size_t> (id));
+                return event::Queue::instance ().push (event);
+            };
+
+            /**
+             * Pushes the completion events that found the event queue full, in order, until it
+             * fills again. Called with mutex_ held.
+             */
+            void resend () {
+                size_t sent = 0;
+                while (sent < unsent_.size () && push (unsent_[sent]))
+                    ++sent;
+                unsent_.erase (unsent_.begin (), unsent_.begin () + sent);
+            };
+
+            /**
+             * @typedef map<int, boost::shared_ptr<Load::State> > Finished
+             * @brief Finished loads awaiting their completion event.
+             */
+            typedef map<int, boost::shared_ptr<Load::State> > Finished;
+
+            /**
+             * Guards the identifiers and the finished loads.
+             */
+            Mutex mutex_;
+
+            /**
+             * Finished loads awaiting their completion event.
+             */
+            Finished finished_;
+
+            /**
+             * The identifiers of finished loads whose completion events found the event queue full.
+             */
+            deque<int> unsent_;
+
+            /**
+             * The identifier of the next load.
+             */
+            int nextId_;
+
+            /**
+             * Whether or not to push completion events.
+             */
+            bool notify_;
+
+            /**
+             * The worker threads. Declared last so the workers stop before the state they use is destroyed.
+             */
+            ThreadPool pool_;
+    }; //AsyncLoader
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_ASYNCLOADER_H
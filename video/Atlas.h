@@ -0,0 +1,547 @@
+/**
+ * @file Atlas.h
+ * Contains the Skyline, Sprite, Atlas and AtlasBuilder classes.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_ATLAS_H
+#define SDL_VIDEO_ATLAS_H
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <SDL.h>
+
+#include "sdlpp/misc/Rect.h"
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/video/PixelFile.h"
+#include "sdlpp/video/MappedSurface.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace misc;
+
+    /**
+     * @class Skyline
+     * @brief Packs rectangles into a fixed size area using the bottom-left skyline heuristic.
+     */
+    class Skyline {
+        public:
+            /**
+             * Constructs an empty Skyline.
+             *
+             * @param width The width of the area.
+             * @param height The height of the area.
+             */
+            Skyline (int width, int height) : width_ (width), height_ (height), nodes_ (1, Node (0, 0, width)) {};
+
+            /**
+             * Finds room for a rectangle and reserves it.
+             *
+             * @param width The width of the rectangle.
+             * @param height The height of the rectangle.
+             * @param x Receives the x offset of the reserved rectangle.
+             * @param y Receives the y offset of the reserved rectangle.
+             *
+             * @return True if the rectangle fit, false otherwise.
+             */
+            bool insert (int width, int height, int& x, int& y) {
+                size_t best = nodes_.size ();
+                int bestY = height_;
+                int bestWidth = width_ + 1;
+                for (size_t i = 0; i < nodes_.size (); ++i) {
+                    int top = fit (i, width, height);
+                    if (top >= 0 && (top < bestY || (top == bestY && nodes_[i].width_ < bestWidth))) {
+                        best = i;
+                        bestY = top;
+                        bestWidth = nodes_[i].width_;
+                    }
+                }
+                if (best == nodes_.size ())
+                    return false;
+
+                x = nodes_[best].x_;
+                y = bestY;
+                nodes_.insert (nodes_.begin () + best, Node (x, y + height, width));
+
+                //shrink or remove the nodes now covered by the new one.
+                for (size_t i = best + 1; i < nodes_.size (); ) {
+                    int overlap = nodes_[i - 1].x_ + nodes_[i - 1].width_ - nodes_[i].x_;
+                    if (overlap <= 0)
+                        break;
+                    nodes_[i].x_ += overlap;
+                    nodes_[i].width_ -= overlap;
+                    if (nodes_[i].width_ > 0)
+                        break;
+                    nodes_.erase (nodes_.begin () + i);
+                }
+
+                //merge neighbors at the same height.
+                for (size_t i = 0; i + 1 < nodes_.size (); ) {
+                    if (nodes_[i].y_ == nodes_[i + 1].y_) {
+                        nodes_[i].width_ += nodes_[i + 1].width_;
+                        nodes_.erase (nodes_.begin () + i + 1);
+                    } else
+                        ++i;
+                }
+                return true;
+            };
+
+        private:
+            /**
+             * @struct Node
+             * @brief A horizontal segment of the skyline.
+             */
+            struct Node {
+                /**
+                 * Constructs a Node.
+                 *
+                 * @param x The x offset.
+                 * @param y The height of the skyline along the segment.
+                 * @param width The width of the segment.
+                 */
+                Node (int x, int y, int width) : x_ (x), y_ (y), width_ (width) {};
+
+                /**
+                 * The x offset.
+                 */
+                int x_;
+
+                /**
+                 * The height of the skyline along the segment.
+                 */
+                int y_;
+
+                /**
+                 * The width of the segment.
+                 */
+                int width_;
+            }; //Node
+
+            /**
+             * Determines where a rectangle would rest if its left edge is placed at a node.
+             *
+             * @param index The index of the node.
+             * @param width The width of the rectangle.
+             * @param height The height of the rectangle.
+             *
+             * @return The y offset of the rectangle, or -1 if it does not fit.
+             */
+            int fit (size_t index, int width, int height) const {
+                if (nodes_[index].x_ + width > width_)
+                    return -1;
+                int top = 0;
+                int remaining = width;
+                for (size_t i = index; remaining > 0; ++i) {
+                    if (i == nodes_.size ())
+                        return -1;
+                    top = max (top, nodes_[i].y_);
+                    if (top + height > height_)
+                        return -1;
+                    remaining -= nodes_[i].width_;
+                }
+                return top;
+            };
+
+            /**
+             * The width of the area.
+             */
+            int width_;
+
+            /**
+             * The height of the area.
+             */
+            int height_;
+
+            /**
+             * The skyline segments ordered left to right.
+             */
+            vector<Node> nodes_;
+    }; //Skyline
+
+    /**
+     * @class Sprite
+     * @brief A handle to a rectangle of an Atlas page.
+     */
+    class Sprite {
+        public:
+            /**
+             * Constructs a Sprite.
+             *
+             * @param page The Atlas page holding the pixels.
+             * @param rect The rectangle of the page holding the pixels.
+             */
+            Sprite (const Surface& page, const Rect& rect) : page_ (page), rect_ (rect) {};
+
+            /**
+             * Returns the Atlas page holding the pixels.
+             *
+             * @return The Atlas page.
+             */
+            Surface& page () { return page_; };
+
+            /**
+             * Returns the rectangle of the page holding the pixels. Pass this as the source
+             * rectangle to Surface::blit.
+             *
+             * @return The rectangle.
+             */
+            const Rect& rect () const { return rect_; };
+
+            /**
+             * Blits the Sprite onto a Surface.
+             *
+             * @param dst The Surface onto which to blit.
+             * @param x The x offset on the destination.
+             * @param y The y offset on the destination.
+             *
+             * @return A reference to this Sprite.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to blit.
+             */
+            Sprite& blit (Surface& dst, short x, short y) {
+                dst.blit (page_, rect_, Rect (rect_.height (), rect_.width (), x, y));
+                return *this;
+            };
+
+        private:
+            /**
+             * The Atlas page holding the pixels.
+             */
+            Surface page_;
+
+            /**
+             * The rectangle of the page holding the pixels.
+             */
+            Rect rect_;
+    }; //Sprite
+
+    /**
+     * @class Atlas
+     * @brief A set of pages holding many small Surfaces, addressed by name.
+     */
+    class Atlas {
+        public:
+            /**
+             * Constructs an empty Atlas.
+             */
+            Atlas () : pages_ (), entries_ () {};
+
+            /**
+             * Loads an Atlas saved with save.
+             *
+             * @param baseName The base name the Atlas was saved under.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to read the Atlas.
+             */
+            explicit Atlas (const string& baseName) : pages_ (), entries_ () {
+                ifstream index ((baseName + ".atlas").c_str ());
+                if (!index)
+                    throw runtime_error ("Failed to open atlas " + baseName);
+                size_t numPages = 0;
+                index >> numPages;
+                for (size_t i = 0; i < numPages; ++i)
+                    pages_.push_back (MappedSurface::loadPixels (pageName (baseName, i)));
+
+                string name;
+                Entry entry;
+                while (index >> name >> entry.page_ >> entry.x_ >> entry.y_ >> entry.width_ >> entry.height_) {
+                    if (entry.page_ >= pages_.size ())
+                        throw runtime_error ("Corrupt atlas " + baseName);
+                    entries_[name] = entry;
+                }
+            };
+
+            /**
+             * Determines if the Atlas holds a named Surface.
+             *
+             * @param name The name of the Surface.
+             *
+             * @return True if held, false otherwise.
+             */
+            bool contains (const string& name) const { return entries_.find (name) != entries_.end (); };
+
+            /**
+             * Returns the Sprite for a named Surface.
+             *
+             * @param name The name of the Surface.
+             *
+             * @return The Sprite.
+             *
+             * @throw runtime_error Throws a runtime_error if the Atlas does not hold the name.
+             */
+            Sprite operator[] (const string& name) const {
+                Entries::const_iterator cur = entries_.find (name);
+                if (cur == entries_.end ())
+                    throw runtime_error ("No sprite named " + name);
+                const Entry& e = cur->second;
+                return Sprite (pages_[e.page_], Rect (e.height_, e.width_, e.x_, e.y_));
+            };
+
+            /**
+             * Returns the number of pages.
+             *
+             * @return The number of pages.
+             */
+            size_t pages () const { return pages_.size (); };
+
+            /**
+             * Returns a page.
+             *
+             * @param index The index of the page.
+             *
+             * @return The page.
+             */
+            Surface& page (size_t index) { return pages_.at (index); };
+
+            /**
+             * Saves the Atlas as an index file, baseName.atlas, and one raw pixel file per page.
+             *
+             * @param baseName The base name under which to save.
+             *
+             * @return True if successful, false otherwise.
+             */
+            bool save (const string& baseName) const {
+                ofstream index ((baseName + ".atlas").c_str ());
+                index << pages_.size () << "\n";
+                for (Entries::const_iterator cur = entries_.begin (); cur != entries_.end (); ++cur) {
+                    const Entry& e = cur->second;
+                    index << cur->first << " " << e.page_ << " " << e.x_ << " " << e.y_ << " " << e.width_ << " " << e.height_ << "\n";
+                }
+                for (size_t i = 0; i < pages_.size (); ++i)
+                    if (!PixelFile::save (pages_[i], pageName (baseName, i)))
+                        return false;
+                return index.good ();
+            };
+
+        private:
+            friend class AtlasBuilder;
+
+            /**
+             * @struct Entry
+             * @brief Locates a Surface within the Atlas.
+             */
+            struct Entry {
+                /**
+                 * The index of the page.
+                 */
+                size_t page_;
+
+                /**
+                 * The rectangle within the page.
+                 */
+                int x_, y_, width_, height_;
+            }; //Entry
+
+            /**
+             * Returns the file name of a page.
+             *
+             * @param baseName The base name of the Atlas.
+             * @param index The index of the page.
+             *
+             * @return The file name.
+             */
+            static string pageName (const string& baseName, size_t index) {
+                ostringstream name;
+                name << baseName << "." << index << ".pix";
+                return name.str ();
+            };
+
+            /**
+             * @typedef map<string, Entry> Entries
+             * @brief Maps names to their location.
+             */
+            typedef map<string, Entry> Entries;
+
+            /**
+             * The pages.
+             */
+            vector<Surface> pages_;
+
+            /**
+             * The locations of the held Surfaces.
+             */
+            Entries entries_;
+    }; //Atlas
+
+    /**
+     * @class AtlasBuilder
+     * @brief Packs many small Surfaces into the pages of an Atlas.
+     */
+    class AtlasBuilder {
+        public:
+            /**
+             * Constructs an AtlasBuilder.
+             *
+             * @param pageWidth The width of a page.
+             * @param pageHeight The height of a page.
+             * @param padding The number of empty pixels kept between Surfaces.
+             */
+            AtlasBuilder (int pageWidth, int pageHeight, int padding = 1)
+              : pageWidth_ (pageWidth), pageHeight_ (pageHeight), padding_ (padding), items_ () {};
+
+            /**
+             * Adds a Surface to be packed.
+             *
+             * @param name The name under which to find the Surface in the Atlas.
+             * @param surface The Surface.
+             *
+             * @return A reference to this AtlasBuilder.
+             *
+             * @throw runtime_error Throws a runtime_error if the name is empty or holds whitespace, which
+             * the index cannot store, or if the Surface is larger than a page.
+             */
+            AtlasBuilder& add (const string& name, const Surface& surface) {
+                if (name.empty () || name.find_first_of (" \t\n\r\v\f") != string::npos)
+                    throw runtime_error ("Sprite name \"" + name + "\" must be non empty and hold no whitespace.");
+                SDL_Surface* s = surface.to_c ();
+                if (s->w + padding_ > pageWidth_ || s->h + padding_ > pageHeight_)
+                    throw runtime_error ("Surface " + name + " does not fit on an atlas page.");
+                items_.push_back (make_pair (name, surface));
+                return *this;
+            };
+
+            /**
+             * Packs the added Surfaces into 32 bit RGBA pages, tallest first.
+             *
+             * @return The Atlas.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create a page or blit.
+             */
+            Atlas build () {
+                stable_sort (items_.begin (), items_.end (), Taller ());
+
+                Atlas atlas;
+                vector<Skyline> skylines;
+                for (Items::iterator cur = items_.begin (); cur != items_.end (); ++cur) {
+                    SDL_Surface* s = cur->second.to_c ();
+                    Atlas::Entry entry;
+                    entry.width_ = s->w;
+                    entry.height_ = s->h;
+                    for (entry.page_ = 0; entry.page_ < skylines.size (); ++entry.page_)
+                        if (skylines[entry.page_].insert (s->w + padding_, s->h + padding_, entry.x_, entry.y_))
+                            break;
+                    if (entry.page_ == skylines.size ()) {
+                        skylines.push_back (Skyline (pageWidth_, pageHeight_));
+                        atlas.pages_.push_back (newPage ());
+                        skylines.back ().insert (s->w + padding_, s->h + padding_, entry.x_, entry.y_);
+                    }
+                    copy (cur->second, atlas.pages_[entry.page_], entry.x_, entry.y_);
+                    atlas.entries_[cur->first] = entry;
+                }
+                return atlas;
+            };
+
+        private:
+            /**
+             * @struct Taller
+             * @brief Orders Surfaces by descending height, then width.
+             */
+            struct Taller {
+                /**
+                 * Compares two named Surfaces.
+                 *
+                 * @param lhs The left hand side.
+                 * @param rhs The right hand side.
+                 *
+                 * @return True if lhs should be packed before rhs.
+                 */
+                bool operator() (const pair<string, Surface>& lhs, const pair<string, Surface>& rhs) const {
+                    const SDL_Surface* l = lhs.second.to_c ();
+                    const SDL_Surface* r = rhs.second.to_c ();
+                    return l->h > r->h || (l->h == r->h && l->w > r->w);
+                };
+            }; //Taller
+
+            /**
+             * Creates a transparent page.
+             *
+             * @return The page.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create the page.
+             */
+            Surface newPage () const {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+                Surface page (SDL_CreateRGBSurface (SDL_SWSURFACE, pageWidth_, pageHeight_, 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff));
+#else
+                Surface page (SDL_CreateRGBSurface (SDL_SWSURFACE, pageWidth_, pageHeight_, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000));
+#endif
+                SDL_FillRect (page.to_c (), NULL, 0);
+                return page;
+            };
+
+            /**
+             * Copies a Surface onto a page. Per pixel alpha is copied rather than blended and
+             * color keyed pixels are left transparent.
+             *
+             * @param src The Surface to copy.
+             * @param page The page.
+             * @param x The x offset on the page.
+             * @param y The y offset on the page.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to blit.
+             */
+            static void copy (const Surface& src, Surface& page, int x, int y) {
+                SDL_Surface* s = src.to_c ();
+                Uint32 flags = s->flags & (SDL_SRCALPHA | SDL_RLEACCEL);
+                Uint8 alpha = s->format->alpha;
+                SDL_SetAlpha (s, 0, alpha);
+                SDL_Rect dst;
+                dst.x = x;
+                dst.y = y;
+                int result = SDL_BlitSurface (s, NULL, page.to_c (), &dst);
+                SDL_SetAlpha (s, flags, alpha);
+                if (result == -1)
+                    throw runtime_error (SDL_GetError ());
+            };
+
+            /**
+             * @typedef vector<pair<string, Surface> > Items
+             * @brief The named Surfaces to pack.
+             */
+            typedef vector<pair<string, Surface> > Items;
+
+            /**
+             * The width of a page.
+             */
+            int pageWidth_;
+
+            /**
+             * The height of a page.
+             */
+            int pageHeight_;
+
+            /**
+             * The number of empty pixels kept between Surfaces.
+             */
+            int padding_;
+
+            /**
+             * The Surfaces to pack.
+             */
+            Items items_;
+    }; //AtlasBuilder
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_ATLAS_H
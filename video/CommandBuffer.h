@@ -0,0 +1,405 @@
+/**
+ * @file CommandBuffer.h
+ * Contains the CommandBuffer class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_COMMANDBUFFER_H
+#define SDL_VIDEO_COMMANDBUFFER_H
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <SDL.h>
+
+#include "sdlpp/misc/Rect.h"
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/video/TiledCompositor.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace misc;
+
+    /**
+     * @class CommandBuffer
+     * @brief Records fills, clears and blits for deferred execution.
+     *
+     * Commands are kept in a compact array and refer to their sources by index into a table of
+     * Surfaces, so a recorded frame can be optimized once and replayed every frame. Sources are
+     * held by handle, their pixels may change between replays.
+     */
+    class CommandBuffer {
+        public:
+            /**
+             * Constructs an empty CommandBuffer.
+             */
+            CommandBuffer () : commands_ (), surfaces_ (), indices_ () {};
+
+            /**
+             * Records a fill of the whole target.
+             *
+             * @param color The pixel value, as returned by SDL_MapRGB for the target's format.
+             *
+             * @return A reference to this CommandBuffer.
+             */
+            CommandBuffer& clear (Uint32 color) {
+                Command command = { CLEAR, NONE, color, 0, 0, 0, 0, 0, 0 };
+                commands_.push_back (command);
+                return *this;
+            };
+
+            /**
+             * Records a fill.
+             *
+             * @param rect The rectangle to fill.
+             * @param color The pixel value.
+             *
+             * @return A reference to this CommandBuffer.
+             */
+            CommandBuffer& fill (const Rect& rect, Uint32 color) {
+                if (rect.width () == 0 || rect.height () == 0)
+                    return *this;
+                Command command = { FILL, NONE, color, static_cast<Sint16> (rect.x ()), static_cast<Sint16> (rect.y ()),
+                                    static_cast<Uint16> (rect.width ()), static_cast<Uint16> (rect.height ()), 0, 0 };
+                commands_.push_back (command);
+                return *this;
+            };
+
+            /**
+             * Records a blit.
+             *
+             * @param src The Surface from which to blit.
+             * @param srcRect The source rectangle.
+             * @param x The x offset on the target.
+             * @param y The y offset on the target.
+             *
+             * @return A reference to this CommandBuffer.
+             *
+             * @throw runtime_error Throws a runtime_error if more than 65535 sources are recorded.
+             */
+            CommandBuffer& blit (const Surface& src, const Rect& srcRect, int x, int y) {
+                SDL_Surface* s = src.to_c ();
+                int sx = srcRect.x ();
+                int sy = srcRect.y ();
+                int w = srcRect.width ();
+                int h = srcRect.height ();
+
+                //clip against the source as SDL_UpperBlit does, the destination is clipped on replay.
+                if (sx < 0) {
+                    w += sx;
+                    x -= sx;
+                    sx = 0;
+                }
+                if (sy < 0) {
+                    h += sy;
+                    y -= sy;
+                    sy = 0;
+                }
+                w = min (w, s->w - sx);
+                h = min (h, s->h - sy);
+                if (w <= 0 || h <= 0)
+                    return *this;
+
+                Command command = { BLIT, source (src), 0, static_cast<Sint16> (x), static_cast<Sint16> (y),
+                                    static_cast<Uint16> (w), static_cast<Uint16> (h), static_cast<Sint16> (sx), static_cast<Sint16> (sy) };
+                commands_.push_back (command);
+                return *this;
+            };
+
+            /**
+             * Removes commands that later opaque commands cover completely. A fill or clear is
+             * opaque, as is a blit whose source has neither SDL_SRCALPHA nor SDL_SRCCOLORKEY set.
+             * Source flags are read now, call optimize again after changing them.
+             *
+             * @return A reference to this CommandBuffer.
+             */
+            CommandBuffer& cull () {
+                vector<Command> kept;
+                vector<const Command*> occluders;
+                bool cleared = false;
+                for (vector<Command>::reverse_iterator cur = commands_.rbegin (); cur != commands_.rend () && !cleared; ++cur) {
+                    if (cur->type_ != CLEAR && occluded (*cur, occluders))
+                        continue;
+                    kept.push_back (*cur);
+                    if (cur->type_ == CLEAR)
+                        cleared = true;
+                    else if (opaque (*cur))
+                        occluders.push_back (&*cur);
+                }
+                commands_.assign (kept.rbegin (), kept.rend ());
+                return *this;
+            };
+
+            /**
+             * Groups commands by source so consecutive blits read the same pixels. A command only
+             * moves ahead of commands whose destinations it does not overlap, so the result of a
+             * replay is unchanged.
+             *
+             * @param window The number of preceding commands searched for one with the same source.
+             *
+             * @return A reference to this CommandBuffer.
+             */
+            CommandBuffer& sort (size_t window = 64) {
+                vector<Command> sorted;
+                sorted.reserve (commands_.size ());
+                for (vector<Command>::const_iterator cur = commands_.begin (); cur != commands_.end (); ++cur) {
+                    size_t at = sorted.size ();
+                    size_t stop = sorted.size () > window ? sorted.size () - window : 0;
+                    for (size_t i = sorted.size (); cur->type_ != CLEAR && i > stop; --i) {
+                        const Command& prev = sorted[i - 1];
+                        if (prev.source_ == cur->source_ && prev.type_ != CLEAR) {
+                            at = i;
+                            break;
+                        }
+                        if (overlaps (prev, *cur))
+                            break;
+                    }
+                    sorted.insert (sorted.begin () + at, *cur);
+                }
+                commands_.swap (sorted);
+                return *this;
+            };
+
+            /**
+             * Culls then sorts the commands.
+             *
+             * @return A reference to this CommandBuffer.
+             */
+            CommandBuffer& optimize () { return cull ().sort (); };
+
+            /**
+             * Executes the commands one after another. The CommandBuffer is unchanged and may be replayed again.
+             *
+             * @param target The Surface onto which to draw.
+             *
+             * @return A reference to this CommandBuffer.
+             *
+             * @throw runtime_error Throws a runtime_error if a fill or blit fails.
+             */
+            CommandBuffer& replay (Surface& target) {
+                SDL_Surface* t = target.to_c ();
+                for (vector<Command>::const_iterator cur = commands_.begin (); cur != commands_.end (); ++cur) {
+                    SDL_Rect dst = { cur->x_, cur->y_, cur->w_, cur->h_ };
+                    int result;
+                    if (cur->type_ == CLEAR)
+                        result = SDL_FillRect (t, NULL, cur->color_);
+                    else if (cur->type_ == FILL)
+                        result = SDL_FillRect (t, &dst, cur->color_);
+                    else {
+                        SDL_Rect src = { cur->srcX_, cur->srcY_, cur->w_, cur->h_ };
+                        result = SDL_BlitSurface (surfaces_[cur->source_].to_c (), &src, t, &dst);
+                    }
+                    if (result == -1)
+                        throw runtime_error (SDL_GetError ());
+                }
+                return *this;
+            };
+
+            /**
+             * Executes the commands on a TiledCompositor's worker threads. The CommandBuffer is unchanged and may be replayed again.
+             *
+             * @param compositor The TiledCompositor, holding the Surface onto which to draw.
+             *
+             * @return A reference to this CommandBuffer.
+             *
+             * @throw runtime_error Throws a runtime_error if a tile fails.
+             */
+            CommandBuffer& replay (TiledCompositor& compositor) {
+                compositor.reset ();
+                for (vector<Command>::const_iterator cur = commands_.begin (); cur != commands_.end (); ++cur) {
+                    if (cur->type_ == CLEAR)
+                        compositor.clear (cur->color_);
+                    else if (cur->type_ == FILL)
+                        compositor.fill (Rect (cur->h_, cur->w_, cur->x_, cur->y_), cur->color_);
+                    else
+                        compositor.blit (surfaces_[cur->source_], Rect (cur->h_, cur->w_, cur->srcX_, cur->srcY_), cur->x_, cur->y_);
+                }
+                compositor.flush ();
+                return *this;
+            };
+
+            /**
+             * Discards the commands and sources.
+             *
+             * @return A reference to this CommandBuffer.
+             */
+            CommandBuffer& reset () {
+                commands_.clear ();
+                surfaces_.clear ();
+                indices_.clear ();
+                return *this;
+            };
+
+            /**
+             * Returns the number of recorded commands.
+             *
+             * @return The number of commands.
+             */
+            size_t size () const { return commands_.size (); };
+
+            /**
+             * Returns the number of times the source changes from one blit to the next, a measure of how well sorted the commands are.
+             *
+             * @return The number of source changes.
+             */
+            size_t switches () const {
+                size_t count = 0;
+                Uint16 last = NONE;
+                for (vector<Command>::const_iterator cur = commands_.begin (); cur != commands_.end (); ++cur) {
+                    if (cur->type_ == BLIT && cur->source_ != last) {
+                        ++count;
+                        last = cur->source_;
+                    }
+                }
+                return count;
+            };
+
+        private:
+            /**
+             * The kinds of command.
+             */
+            enum Type { CLEAR, FILL, BLIT };
+
+            /**
+             * The source index of fills and clears.
+             */
+            enum { NONE = 0xffff };
+
+            /**
+             * @struct Command
+             * @brief A recorded command.
+             */
+            struct Command {
+                /**
+                 * The kind of command.
+                 */
+                Uint8 type_;
+
+                /**
+                 * The index of the source Surface, NONE for fills and clears.
+                 */
+                Uint16 source_;
+
+                /**
+                 * The fill pixel value.
+                 */
+                Uint32 color_;
+
+                /**
+                 * The destination offset.
+                 */
+                Sint16 x_, y_;
+
+                /**
+                 * The size, already clipped against the source.
+                 */
+                Uint16 w_, h_;
+
+                /**
+                 * The source offset.
+                 */
+                Sint16 srcX_, srcY_;
+            }; //Command
+
+            /**
+             * Returns the index of a source, adding it to the table if needed.
+             *
+             * @param src The source Surface.
+             *
+             * @return The index.
+             *
+             * @throw runtime_error Throws a runtime_error if the table is full.
+             */
+            Uint16 source (const Surface& src) {
+                map<SDL_Surface*, Uint16>::iterator found = indices_.find (src.to_c ());
+                if (found != indices_.end ())
+                    return found->second;
+                if (surfaces_.size () == NONE)
+                    throw runtime_error ("Too many sources in CommandBuffer.");
+                Uint16 index = surfaces_.size ();
+                surfaces_.push_back (src);
+                indices_[src.to_c ()] = index;
+                return index;
+            };
+
+            /**
+             * Returns whether or not a command replaces every pixel it touches.
+             *
+             * @param command The command.
+             *
+             * @return True if opaque, false otherwise.
+             */
+            bool opaque (const Command& command) const {
+                if (command.type_ != BLIT)
+                    return true;
+                return (surfaces_[command.source_].to_c ()->flags & (SDL_SRCALPHA | SDL_SRCCOLORKEY)) == 0;
+            };
+
+            /**
+             * Returns whether or not one of the occluders covers a command.
+             *
+             * @param command The command.
+             * @param occluders The opaque commands that follow it.
+             *
+             * @return True if covered, false otherwise.
+             */
+            static bool occluded (const Command& command, const vector<const Command*>& occluders) {
+                for (vector<const Command*>::const_iterator cur = occluders.begin (); cur != occluders.end (); ++cur) {
+                    const Command& o = **cur;
+                    if (o.x_ <= command.x_ && o.y_ <= command.y_ &&
+                        o.x_ + o.w_ >= command.x_ + command.w_ && o.y_ + o.h_ >= command.y_ + command.h_)
+                        return true;
+                }
+                return false;
+            };
+
+            /**
+             * Returns whether or not the destinations of two commands overlap.
+             *
+             * @param a The first command.
+             * @param b The second command.
+             *
+             * @return True if they overlap, false otherwise.
+             */
+            static bool overlaps (const Command& a, const Command& b) {
+                if (a.type_ == CLEAR || b.type_ == CLEAR)
+                    return true;
+                return a.x_ < b.x_ + b.w_ && b.x_ < a.x_ + a.w_ && a.y_ < b.y_ + b.h_ && b.y_ < a.y_ + a.h_;
+            };
+
+            /**
+             * The recorded commands.
+             */
+            vector<Command> commands_;
+
+            /**
+             * The sources, indexed by Command::source_.
+             */
+            vector<Surface> surfaces_;
+
+            /**
+             * The index of each source.
+             */
+            map<SDL_Surface*, Uint16> indices_;
+    }; //CommandBuffer
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_COMMANDBUFFER_H
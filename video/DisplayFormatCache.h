@@ -0,0 +1,265 @@
+/**
+ * @file DisplayFormatCache.h
+ * Contains the DisplayFormatCache class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_DISPLAYFORMATCACHE_H
+#define SDL_VIDEO_DISPLAYFORMATCACHE_H
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <boost/mpl/vector.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/event/Event.h"
+#include "sdlpp/event/WindowEvents.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace event;
+
+    /**
+     * @class DisplayFormatCache
+     * @brief Memoizes copies of Surfaces converted to the display format.
+     *
+     * Blitting a Surface whose format differs from the display surface converts every pixel on
+     * every blit. The cache converts each source Surface once and hands back the converted copy
+     * until the video mode changes, either through a Resize event or a new call to SDL_SetVideoMode.
+     */
+    class DisplayFormatCache {
+        public:
+            /**
+             * The events handled by the DisplayFormatCache.
+             */
+            typedef boost::mpl::vector<Resize> Events;
+
+            /**
+             * Constructs an empty DisplayFormatCache.
+             */
+            DisplayFormatCache () : entries_ (), mode_ () {};
+
+            /**
+             * Destroys the DisplayFormatCache.
+             */
+            ~DisplayFormatCache () {};
+
+            /**
+             * Returns the display format copy of a Surface, converting it on first use.
+             *
+             * @param surface The Surface to convert.
+             * @param alpha Whether or not to convert to the display format with an alpha channel.
+             *
+             * @return The converted Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to convert the Surface.
+             */
+            Surface get (const Surface& surface, bool alpha = false) {
+                validate ();
+                Key key (surface.to_c (), alpha);
+                Entries::iterator cur = entries_.find (key);
+                if (cur != entries_.end ())
+                    return cur->second.second;
+                Surface converted = alpha ? surface.displayFormatAlpha () : surface.displayFormat ();
+                entries_.insert (make_pair (key, make_pair (surface, converted)));
+                return converted;
+            };
+
+            /**
+             * Loads a bitmap and returns its display format copy.
+             *
+             * @param fileName The name of the file.
+             * @param alpha Whether or not to convert to the display format with an alpha channel.
+             *
+             * @return The converted Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to load or convert the bitmap.
+             */
+            Surface load (const string& fileName, bool alpha = false) { return get (Surface (fileName), alpha); };
+
+            /**
+             * Drops the converted copies of a Surface.
+             *
+             * @param surface The Surface whose copies to drop.
+             *
+             * @return A reference to this DisplayFormatCache.
+             */
+            DisplayFormatCache& release (const Surface& surface) {
+                entries_.erase (Key (surface.to_c (), false));
+                entries_.erase (Key (surface.to_c (), true));
+                return *this;
+            };
+
+            /**
+             * Drops all converted copies.
+             *
+             * @return A reference to this DisplayFormatCache.
+             */
+            DisplayFormatCache& invalidate () {
+                entries_.clear ();
+                mode_ = Mode ();
+                return *this;
+            };
+
+            /**
+             * Returns the number of converted copies held.
+             *
+             * @return The number of converted copies.
+             */
+            size_t size () const { return entries_.size (); };
+
+            /**
+             * Handles resize events. The display surface is recreated on resize so all copies are dropped.
+             *
+             * @param event The event.
+             */
+            void handle (const Resize& event) { invalidate (); };
+
+        private:
+            /**
+             * Copy constructs a DisplayFormatCache.
+             *
+             * @param rhs The DisplayFormatCache to copy.
+             */
+            DisplayFormatCache (const DisplayFormatCache& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The DisplayFormatCache from which to assign.
+             *
+             * @return A reference to this DisplayFormatCache.
+             */
+            DisplayFormatCache& operator= (const DisplayFormatCache& rhs);
+
+            /**
+             * @struct Mode
+             * @brief Describes the video mode the cached copies were converted for.
+             */
+            struct Mode {
+                /**
+                 * Constructs a Mode describing no display surface.
+                 */
+                Mode () : screen_ (0), width_ (0), height_ (0), flags_ (0), bpp_ (0), rmask_ (0), gmask_ (0), bmask_ (0), amask_ (0) {};
+
+                /**
+                 * Constructs a Mode from a display surface.
+                 *
+                 * @param screen The SDL_Surface structure of the display.
+                 */
+                Mode (const SDL_Surface* screen)
+                  : screen_ (screen),
+                    width_ (screen->w),
+                    height_ (screen->h),
+                    flags_ (screen->flags),
+                    bpp_ (screen->format->BitsPerPixel),
+                    rmask_ (screen->format->Rmask),
+                    gmask_ (screen->format->Gmask),
+                    bmask_ (screen->format->Bmask),
+                    amask_ (screen->format->Amask) {};
+
+                /**
+                 * Determines if two Modes are the same.
+                 *
+                 * @param rhs The Mode to compare against.
+                 *
+                 * @return True if the Modes are the same, false otherwise.
+                 */
+                bool operator== (const Mode& rhs) const {
+                    return screen_ == rhs.screen_ && width_ == rhs.width_ && height_ == rhs.height_ && flags_ == rhs.flags_
+                        && bpp_ == rhs.bpp_ && rmask_ == rhs.rmask_ && gmask_ == rhs.gmask_ && bmask_ == rhs.bmask_ && amask_ == rhs.amask_;
+                };
+
+                /**
+                 * The SDL_Surface structure of the display.
+                 */
+                const SDL_Surface* screen_;
+
+                /**
+                 * The width of the display.
+                 */
+                int width_;
+
+                /**
+                 * The height of the display.
+                 */
+                int height_;
+
+                /**
+                 * The display surface flags.
+                 */
+                Uint32 flags_;
+
+                /**
+                 * The number of bits per pixel.
+                 */
+                Uint8 bpp_;
+
+                /**
+                 * The red, green, blue and alpha masks.
+                 */
+                Uint32 rmask_, gmask_, bmask_, amask_;
+            }; //Mode
+
+            /**
+             * Drops all copies if the video mode changed since they were converted.
+             *
+             * @throw runtime_error Throws a runtime_error if there is no display surface.
+             */
+            void validate () {
+                const SDL_Surface* screen = SDL_GetVideoSurface ();
+                if (screen == NULL)
+                    throw runtime_error ("No video mode set.");
+                Mode mode (screen);
+                if (!(mode == mode_)) {
+                    entries_.clear ();
+                    mode_ = mode;
+                }
+            };
+
+            /**
+             * @typedef pair<const SDL_Surface*, bool> Key
+             * @brief Identifies a source Surface and the conversion applied to it.
+             */
+            typedef pair<const SDL_Surface*, bool> Key;
+
+            /**
+             * @typedef map<Key, pair<Surface, Surface> > Entries
+             * @brief Maps a source to the source Surface and its converted copy. Holding the source
+             * keeps its SDL_Surface alive so its address cannot be reused by another Surface.
+             */
+            typedef map<Key, pair<Surface, Surface> > Entries;
+
+            /**
+             * The cached copies.
+             */
+            Entries entries_;
+
+            /**
+             * The video mode the cached copies were converted for.
+             */
+            Mode mode_;
+    }; //DisplayFormatCache
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_DISPLAYFORMATCACHE_H
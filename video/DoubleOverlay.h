@@ -0,0 +1,234 @@
+/**
+ * @file DoubleOverlay.h
+ * Contains the DoubleOverlay class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_DOUBLEOVERLAY_H
+#define SDL_VIDEO_DOUBLEOVERLAY_H
+
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+
+#include <boost/bind/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/misc/Rect.h"
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/video/Overlay.h"
+#include "sdlpp/video/YuvConverter.h"
+#include "sdlpp/thread/ThreadPool.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace misc;
+    using namespace thread;
+
+    /**
+     * @class DoubleOverlay
+     * @brief Two Overlays, one displayed while the next frame is converted into the other.
+     *
+     * The back Overlay is locked and unlocked on the calling thread, only the conversion into its
+     * planes runs in the background, so no SDL video call is made from another thread.
+     */
+    class DoubleOverlay {
+        public:
+            /**
+             * Constructs a DoubleOverlay.
+             *
+             * @param rect A rectangle describing the height and width of the Overlays.
+             * @param format The format of the Overlays, SDL_YV12_OVERLAY or SDL_IYUV_OVERLAY.
+             * @param display The Surface on which to display the Overlays.
+             * @param threads The number of threads converting a frame, 0 for one per processor.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create the Overlays.
+             */
+            DoubleOverlay (const Rect& rect, Uint32 format, const Surface& display, unsigned int threads = 0)
+              : front_ (new Overlay (rect, format, display)),
+                back_ (new Overlay (rect, format, display)),
+                converter_ (threads),
+                pending_ (false),
+                converted_ (false),
+                error_ (),
+                async_ (1) {};
+
+            /**
+             * Waits for the conversion in progress and destroys the DoubleOverlay.
+             */
+            ~DoubleOverlay () {
+                async_.wait ();
+                if (pending_)
+                    back_->unlock ();
+            };
+
+            /**
+             * Starts converting a frame into the back Overlay and returns without waiting for it. A
+             * conversion still in progress is waited for and swapped in first.
+             *
+             * @param frame The frame. It must not be drawn on until swap returns.
+             *
+             * @return A reference to this DoubleOverlay.
+             *
+             * @throw runtime_error Throws a runtime_error if the previous conversion failed or the back Overlay cannot be locked.
+             */
+            DoubleOverlay& convert (const Surface& frame) {
+                if (pending_)
+                    swap ();
+                if (!back_->lock ())
+                    throw runtime_error (SDL_GetError ());
+                pending_ = true;
+                async_.submit (boost::bind (&DoubleOverlay::work, this, frame));
+                return *this;
+            };
+
+            /**
+             * Waits for the conversion in progress and makes the back Overlay the front one.
+             *
+             * @return A reference to this DoubleOverlay.
+             *
+             * @throw runtime_error Throws a runtime_error if the conversion failed.
+             */
+            DoubleOverlay& swap () {
+                if (!pending_)
+                    return *this;
+                async_.wait ();
+                back_->unlock ();
+                pending_ = false;
+                if (!error_.empty ()) {
+                    string error;
+                    error.swap (error_);
+                    throw runtime_error (error);
+                }
+                std::swap (front_, back_);
+                converted_ = true;
+                return *this;
+            };
+
+            /**
+             * Displays the front Overlay.
+             *
+             * @param dstRect The rectangle onto which to display.
+             *
+             * @return True if successful or nothing has been converted yet, false otherwise.
+             */
+            bool display (Rect& dstRect) { return !converted_ || front_->display (dstRect); };
+
+            /**
+             * Starts converting the next frame, displays the previous one meanwhile and swaps. Frames
+             * are displayed one call after they are passed in.
+             *
+             * @param next The next frame.
+             * @param dstRect The rectangle onto which to display.
+             *
+             * @return True if the display succeeded, false otherwise.
+             *
+             * @throw runtime_error Throws a runtime_error if the conversion fails.
+             */
+            bool present (const Surface& next, Rect& dstRect) {
+                convert (next);
+                bool ok = display (dstRect);
+                swap ();
+                return ok;
+            };
+
+            /**
+             * Returns the front Overlay, the one displayed.
+             *
+             * @return The front Overlay.
+             */
+            Overlay& front () { return *front_; };
+
+            /**
+             * Returns the back Overlay, the one converted into.
+             *
+             * @return The back Overlay.
+             */
+            Overlay& back () { return *back_; };
+
+        private:
+            /**
+             * Copy constructs a DoubleOverlay.
+             *
+             * @param rhs The DoubleOverlay to copy.
+             */
+            DoubleOverlay (const DoubleOverlay& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The DoubleOverlay from which to assign.
+             *
+             * @return A reference to this DoubleOverlay.
+             */
+            DoubleOverlay& operator= (const DoubleOverlay& rhs);
+
+            /**
+             * Converts a frame into the locked back Overlay in the background.
+             *
+             * @param frame The frame.
+             */
+            void work (Surface frame) {
+                try {
+                    converter_.convert (frame, *back_);
+                } catch (const exception& e) {
+                    error_ = e.what ();
+                }
+            };
+
+            /**
+             * The Overlay displayed.
+             */
+            boost::shared_ptr<Overlay> front_;
+
+            /**
+             * The Overlay converted into.
+             */
+            boost::shared_ptr<Overlay> back_;
+
+            /**
+             * Converts frames on its own worker threads.
+             */
+            YuvConverter converter_;
+
+            /**
+             * Whether or not a conversion was started and not yet swapped in.
+             */
+            bool pending_;
+
+            /**
+             * Whether or not a frame has been swapped to the front.
+             */
+            bool converted_;
+
+            /**
+             * The error of a failed conversion.
+             */
+            string error_;
+
+            /**
+             * Runs conversions in the background. Declared last so it stops before the state it uses is destroyed.
+             */
+            ThreadPool async_;
+    }; //DoubleOverlay
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_DOUBLEOVERLAY_H
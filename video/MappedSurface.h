@@ -0,0 +1,278 @@
+/**
+ * @file MappedSurface.h
+ * Contains the MappedSurface class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_MAPPEDSURFACE_H
+#define SDL_VIDEO_MAPPEDSURFACE_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include <boost/shared_ptr.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/misc/MappedFile.h"
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/video/PixelFile.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace misc;
+
+    /**
+     * @struct MappedSurface
+     * @brief Builds Surfaces whose pixels point straight into a memory mapped file.
+     *
+     * The mapping lives as long as the last Surface sharing it, so a large static background costs
+     * neither a copy nor a heap allocation. Pixels are mapped copy on write, drawing on the Surface
+     * never modifies the file.
+     *
+     * Bitmaps qualify when they are uncompressed, 16, 24 or 32 bits per pixel, stored top to bottom
+     * (negative height) and their rows start suitably aligned. SDL_Surface has no negative pitch so
+     * the common bottom to top bitmap is loaded through SDL_LoadBMP instead, as are all other bitmaps
+     * that do not qualify. Raw pixel files written by PixelFile always qualify.
+     */
+    struct MappedSurface {
+        /**
+         * Loads a bitmap, mapping it when possible.
+         *
+         * @param fileName The name of the bitmap.
+         *
+         * @return The Surface.
+         *
+         * @throw runtime_error Throws a runtime_error if unable to load the bitmap.
+         */
+        static Surface loadBMP (const string& fileName) {
+            //the headers are read on their own so a bitmap that does not qualify is not mapped as well.
+            unsigned char header[BMP_HEADER_BYTES];
+            FILE* in = fopen (fileName.c_str (), "rb");
+            if (in == NULL)
+                throw runtime_error ("Unable to open " + fileName);
+            size_t size = fread (header, 1, sizeof (header), in);
+            fclose (in);
+
+            Layout layout;
+            if (!bmpLayout (header, size, layout))
+                return Surface (fileName);
+            boost::shared_ptr<MappedFile> file (new MappedFile (fileName));
+            if (file->size () < layout.offset_ + static_cast<size_t> (layout.pitch_) * layout.height_)
+                return Surface (fileName);
+            return create (file, layout);
+        };
+
+        /**
+         * Loads a raw pixel file written by PixelFile.
+         *
+         * @param fileName The name of the raw pixel file.
+         *
+         * @return The Surface.
+         *
+         * @throw runtime_error Throws a runtime_error if the file is not a valid raw pixel file.
+         */
+        static Surface loadPixels (const string& fileName) {
+            boost::shared_ptr<MappedFile> file (new MappedFile (fileName));
+            if (file->size () < sizeof (PixelFileHeader))
+                throw runtime_error ("Invalid pixel file " + fileName);
+            PixelFileHeader header;
+            memcpy (&header, file->data (), sizeof (header));
+            if (!header.valid () || header.pitch_ > 0xffff
+                || file->size () < header.dataOffset_ + static_cast<size_t> (header.pitch_) * header.height_)
+                throw runtime_error ("Invalid pixel file " + fileName);
+
+            Layout layout;
+            layout.width_ = header.width_;
+            layout.height_ = header.height_;
+            layout.bpp_ = header.bpp_;
+            layout.pitch_ = header.pitch_;
+            layout.offset_ = header.dataOffset_;
+            layout.rmask_ = header.rmask_;
+            layout.gmask_ = header.gmask_;
+            layout.bmask_ = header.bmask_;
+            layout.amask_ = header.amask_;
+            return create (file, layout);
+        };
+
+        private:
+            /**
+             * The size of the bitmap file header, info header and masks read by bmpLayout in bytes.
+             */
+            static const size_t BMP_HEADER_BYTES = 14 + 56;
+
+            /**
+             * @struct Layout
+             * @brief Describes pixels held in a mapped file.
+             */
+            struct Layout {
+                /**
+                 * The width and height in pixels.
+                 */
+                int width_, height_;
+
+                /**
+                 * The number of bits per pixel.
+                 */
+                int bpp_;
+
+                /**
+                 * The size of a row in bytes.
+                 */
+                int pitch_;
+
+                /**
+                 * The offset of the first row from the start of the file.
+                 */
+                size_t offset_;
+
+                /**
+                 * The red, green, blue and alpha masks.
+                 */
+                Uint32 rmask_, gmask_, bmask_, amask_;
+            }; //Layout
+
+            /**
+             * @struct Release
+             * @brief Frees a mapped SDL_Surface structure, then lets go of its mapping.
+             */
+            struct Release {
+                /**
+                 * Constructs a Release.
+                 *
+                 * @param file The mapping holding the pixels.
+                 */
+                explicit Release (const boost::shared_ptr<MappedFile>& file) : file_ (file) {};
+
+                /**
+                 * Frees the SDL_Surface structure.
+                 *
+                 * @param surface The SDL_Surface structure.
+                 */
+                void operator() (SDL_Surface* surface) {
+                    SDL_FreeSurface (surface);
+                    file_.reset ();
+                };
+
+                /**
+                 * The mapping holding the pixels.
+                 */
+                boost::shared_ptr<MappedFile> file_;
+            }; //Release
+
+            /**
+             * Reads a little endian 16 bit value.
+             *
+             * @param p The bytes.
+             *
+             * @return The value.
+             */
+            static Uint16 le16 (const unsigned char* p) { return p[0] | (p[1] << 8); };
+
+            /**
+             * Reads a little endian 32 bit value.
+             *
+             * @param p The bytes.
+             *
+             * @return The value.
+             */
+            static Uint32 le32 (const unsigned char* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<Uint32> (p[3]) << 24); };
+
+            /**
+             * Determines if a bitmap can be used in place and describes its pixels.
+             *
+             * @param data The start of the bitmap, at most BMP_HEADER_BYTES bytes.
+             * @param size The number of bytes in data.
+             * @param layout Receives the pixel layout.
+             *
+             * @return True if the pixels can be used in place once the file is large enough to hold them, false otherwise.
+             */
+            static bool bmpLayout (const unsigned char* data, size_t size, Layout& layout) {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+                //pixels are stored little endian and would need swapping.
+                return false;
+#endif
+                if (size < 54 || data[0] != 'B' || data[1] != 'M')
+                    return false;
+                Uint32 offset = le32 (data + 10);
+                Uint32 infoSize = le32 (data + 14);
+                if (infoSize < 40 || offset < 14 + infoSize)
+                    return false;
+                Sint32 width = static_cast<Sint32> (le32 (data + 18));
+                Sint32 height = static_cast<Sint32> (le32 (data + 22));
+                Uint16 bpp = le16 (data + 28);
+                Uint32 compression = le32 (data + 30);
+                if (width <= 0 || height >= 0 || (bpp != 16 && bpp != 24 && bpp != 32))
+                    return false;
+
+                layout.width_ = width;
+                layout.height_ = -height;
+                layout.bpp_ = bpp;
+                layout.pitch_ = ((width * bpp + 31) / 32) * 4;
+                layout.offset_ = offset;
+                layout.amask_ = 0;
+                if (compression == 0) {
+                    if (bpp == 16) {
+                        layout.rmask_ = 0x7c00;
+                        layout.gmask_ = 0x03e0;
+                        layout.bmask_ = 0x001f;
+                    } else {
+                        layout.rmask_ = 0x00ff0000;
+                        layout.gmask_ = 0x0000ff00;
+                        layout.bmask_ = 0x000000ff;
+                    }
+                } else if (compression == 3 && bpp != 24) {
+                    //the masks follow a 40 byte header and are part of larger headers.
+                    if (size < 14 + 40 + 12 || (infoSize >= 56 && size < 14 + 56))
+                        return false;
+                    layout.rmask_ = le32 (data + 54);
+                    layout.gmask_ = le32 (data + 58);
+                    layout.bmask_ = le32 (data + 62);
+                    if (infoSize >= 56)
+                        layout.amask_ = le32 (data + 66);
+                } else
+                    return false;
+
+                return layout.pitch_ <= 0xffff && offset % (bpp == 16 ? 2 : 4) == 0;
+            };
+
+            /**
+             * Creates a Surface over mapped pixels.
+             *
+             * @param file The mapping.
+             * @param layout The pixel layout.
+             *
+             * @return The Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create the Surface.
+             */
+            static Surface create (const boost::shared_ptr<MappedFile>& file, const Layout& layout) {
+                SDL_Surface* s = SDL_CreateRGBSurfaceFrom (file->data () + layout.offset_, layout.width_, layout.height_,
+                                                           layout.bpp_, layout.pitch_,
+                                                           layout.rmask_, layout.gmask_, layout.bmask_, layout.amask_);
+                if (s == NULL)
+                    throw runtime_error (SDL_GetError ());
+                return Surface (boost::shared_ptr<SDL_Surface> (s, Release (file)));
+            };
+    }; //MappedSurface
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_MAPPEDSURFACE_H
@@ -21,6 +21,8 @@
 #ifndef SDL_VIDEO_OVERLAY_H
 #define SDL_VIDEO_OVERLAY_H
 
+#include <stdexcept>
+
 #include <SDL.h>
 
 #include "sdlpp/misc/Rect.h"
@@ -28,6 +30,7 @@
 
 namespace sdl {
 namespace video {
+    using namespace std;
     using namespace misc;
 
     /**
@@ -42,9 +45,14 @@ namespace video {
              * @param rect A rectangle describing the height and width of the Overlay.
              * @param format The format of the Overlay.
              * @param display The Surface on which to display the Overlay.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create the Overlay.
              */
             Overlay (const Rect& rect, Uint32 format, const Surface& display)
-              : overlay_ (SDL_CreateYUVOverlay (rect.width (), rect.height (), format, display.to_c ())) {};
+              : overlay_ (SDL_CreateYUVOverlay (rect.width (), rect.height (), format, display.to_c ())) {
+                if (overlay_ == NULL)
+                    throw runtime_error (SDL_GetError ());
+            };
 
             /**
              * Destroys the Overlay.
@@ -72,6 +80,66 @@ namespace video {
              */
             bool display (Rect& dstRect) { return SDL_DisplayYUVOverlay (overlay_, *dstRect) == 0; };
 
+            /**
+             * Returns the width.
+             *
+             * @return The width.
+             */
+            int width () const { return overlay_->w; };
+
+            /**
+             * Returns the height.
+             *
+             * @return The height.
+             */
+            int height () const { return overlay_->h; };
+
+            /**
+             * Returns the format, one of the SDL_*_OVERLAY values.
+             *
+             * @return The format.
+             */
+            Uint32 format () const { return overlay_->format; };
+
+            /**
+             * Returns the number of planes, 3 for planar formats and 1 for packed ones.
+             *
+             * @return The number of planes.
+             */
+            int planes () const { return overlay_->planes; };
+
+            /**
+             * Returns the pixels of a plane. Only valid while the Overlay is locked.
+             *
+             * @param plane The plane. YV12 stores Y, V, U and IYUV stores Y, U, V.
+             *
+             * @return The pixels of the plane.
+             */
+            Uint8* pixels (int plane) const { return overlay_->pixels[plane]; };
+
+            /**
+             * Returns the size of a row of a plane in bytes.
+             *
+             * @param plane The plane.
+             *
+             * @return The pitch of the plane.
+             */
+            int pitch (int plane) const { return overlay_->pitches[plane]; };
+
+            /**
+             * Returns whether or not the Overlay is hardware accelerated.
+             *
+             * @return True if hardware accelerated, false otherwise.
+             */
+            bool hardware () const { return overlay_->hw_overlay != 0; };
+
+            /**
+             * Exposes the underlying SDL_Overlay structure.
+             *
+             * @return The SDL_Overlay structure.
+             */
+            SDL_Overlay* to_c () const { return overlay_; };
+
         private:
             /**
              * Copy constructs and Overlay.
@@ -0,0 +1,525 @@
+/**
+ * @file PixelConverter.h
+ * Contains the PaletteCube and PixelConverter classes.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_PIXELCONVERTER_H
+#define SDL_VIDEO_PIXELCONVERTER_H
+
+#include <stdexcept>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <SDL.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "sdlpp/misc/Color.h"
+#include "sdlpp/video/Surface.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace misc;
+
+    /**
+     * @class PaletteCube
+     * @brief Maps colors to the nearest entry of a palette through a 32x32x32 lookup table.
+     *
+     * Each cell holds the entry nearest to its center, found once at construction, so mapping
+     * is a single lookup instead of SDL's search of the whole palette. Colors are quantized to
+     * 5 bits per channel first, so a color near the boundary of two entries may map to the
+     * other one than SDL_MapRGB would.
+     */
+    class PaletteCube {
+        public:
+            /**
+             * Constructs a PaletteCube.
+             *
+             * @param palette The palette.
+             *
+             * @throw runtime_error Throws a runtime_error if the palette is empty.
+             */
+            explicit PaletteCube (const SDL_Palette* palette) : cells_ (32 * 32 * 32) {
+                if (palette == NULL || palette->ncolors == 0)
+                    throw runtime_error ("PaletteCube requires a palette.");
+                for (int r = 0; r < 32; ++r)
+                    for (int g = 0; g < 32; ++g)
+                        for (int b = 0; b < 32; ++b)
+                            cells_[r << 10 | g << 5 | b] = nearest (palette, r << 3 | 4, g << 3 | 4, b << 3 | 4);
+            };
+
+            /**
+             * Returns the palette index of a Color.
+             *
+             * @param color The Color.
+             *
+             * @return The index of the nearest entry.
+             */
+            Uint8 operator() (const Color& color) const { return cells_[cell (color.rgba ())]; };
+
+            /**
+             * Returns the palette indices of Colors.
+             *
+             * @param colors The Colors.
+             * @param count The number of Colors.
+             * @param indices Receives the indices.
+             */
+            void map (const Color* colors, size_t count, Uint8* indices) const {
+                const Uint32* in = reinterpret_cast<const Uint32*> (colors);
+                size_t i = 0;
+#ifdef __SSE2__
+                //the cell numbers are computed four at a time, the lookups themselves cannot be vectorized.
+                const __m128i five = _mm_set1_epi32 (0x1f);
+                for (; i + 4 <= count; i += 4) {
+                    __m128i c = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + i));
+                    __m128i r = _mm_and_si128 (_mm_srli_epi32 (c, 27), five);
+                    __m128i g = _mm_and_si128 (_mm_srli_epi32 (c, 19), five);
+                    __m128i b = _mm_and_si128 (_mm_srli_epi32 (c, 11), five);
+                    __m128i n = _mm_or_si128 (_mm_or_si128 (_mm_slli_epi32 (r, 10), _mm_slli_epi32 (g, 5)), b);
+                    Uint32 cells[4];
+                    _mm_storeu_si128 (reinterpret_cast<__m128i*> (cells), n);
+                    indices[i] = cells_[cells[0]];
+                    indices[i + 1] = cells_[cells[1]];
+                    indices[i + 2] = cells_[cells[2]];
+                    indices[i + 3] = cells_[cells[3]];
+                }
+#endif
+                for (; i < count; ++i)
+                    indices[i] = cells_[cell (in[i])];
+            };
+
+            /**
+             * Returns the size of the table in bytes.
+             *
+             * @return The size in bytes.
+             */
+            size_t bytes () const { return cells_.size (); };
+
+        private:
+            /**
+             * Returns the cell of a packed Color.
+             *
+             * @param rgba The Color packed as 0xRRGGBBAA.
+             *
+             * @return The cell.
+             */
+            static Uint32 cell (Uint32 rgba) { return (rgba >> 27) << 10 | (rgba >> 19 & 0x1f) << 5 | (rgba >> 11 & 0x1f); };
+
+            /**
+             * Finds the palette entry nearest a color, measured as SDL does.
+             *
+             * @param palette The palette.
+             * @param r The red intensity.
+             * @param g The green intensity.
+             * @param b The blue intensity.
+             *
+             * @return The index of the nearest entry.
+             */
+            static Uint8 nearest (const SDL_Palette* palette, int r, int g, int b) {
+                int best = 0;
+                unsigned int distance = ~0u;
+                for (int i = 0; i < palette->ncolors; ++i) {
+                    const SDL_Color& c = palette->colors[i];
+                    int dr = c.r - r;
+                    int dg = c.g - g;
+                    int db = c.b - b;
+                    unsigned int d = dr * dr + dg * dg + db * db;
+                    if (d < distance) {
+                        distance = d;
+                        best = i;
+                    }
+                }
+                return best;
+            };
+
+            /**
+             * The palette index of each cell.
+             */
+            vector<Uint8> cells_;
+    }; //PaletteCube
+
+    /**
+     * @class PixelConverter
+     * @brief Converts arrays of Colors to and from the pixels of a format.
+     *
+     * Truecolor formats are converted four pixels at a time with SSE2, with results equal to
+     * SDL_MapRGBA and SDL_GetRGBA. Paletted 8 bit formats map through a PaletteCube built on
+     * construction, about 10ms for 256 colors, and unmap through the palette. The format must
+     * outlive the PixelConverter, and a PixelConverter for a paletted format must be built again
+     * when its palette changes.
+     */
+    class PixelConverter {
+        public:
+            /**
+             * Constructs a PixelConverter for a format.
+             *
+             * @param format The pixel format, which must outlive the PixelConverter.
+             */
+            explicit PixelConverter (const SDL_PixelFormat* format)
+              : surface_ (), format_ (format), mapper_ (format), cube_ (format->palette != NULL ? new PaletteCube (format->palette) : NULL) {};
+
+            /**
+             * Constructs a PixelConverter for the format of a Surface, sharing ownership of the
+             * Surface so the format lives as long as the PixelConverter.
+             *
+             * @param surface The Surface.
+             */
+            explicit PixelConverter (const Surface& surface)
+              : surface_ (new Surface (surface)), format_ (surface.to_c ()->format), mapper_ (format_),
+                cube_ (format_->palette != NULL ? new PaletteCube (format_->palette) : NULL) {};
+
+            /**
+             * Maps Colors to pixel values.
+             *
+             * @param colors The Colors.
+             * @param count The number of Colors.
+             * @param pixels Receives the pixel values.
+             */
+            void map (const Color* colors, size_t count, Uint32* pixels) const {
+                size_t i = 0;
+                if (cube_) {
+                    for (; i < count; ++i)
+                        pixels[i] = (*cube_) (colors[i]);
+                    return;
+                }
+#ifdef __SSE2__
+                const Uint32* in = reinterpret_cast<const Uint32*> (colors);
+                Kernel k (format_);
+                for (; i + 4 <= count; i += 4)
+                    _mm_storeu_si128 (reinterpret_cast<__m128i*> (pixels + i), k.map (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + i))));
+#endif
+                for (; i < count; ++i)
+                    pixels[i] = mapper_.map (colors[i]);
+            };
+
+            /**
+             * Maps pixel values to Colors.
+             *
+             * @param pixels The pixel values.
+             * @param count The number of pixel values.
+             * @param colors Receives the Colors, opaque if the format has no alpha.
+             */
+            void unmap (const Uint32* pixels, size_t count, Color* colors) const {
+                size_t i = 0;
+#ifdef __SSE2__
+                if (Kernel::exact (format_)) {
+                    Kernel k (format_);
+                    Uint32* out = reinterpret_cast<Uint32*> (colors);
+                    for (; i + 4 <= count; i += 4)
+                        _mm_storeu_si128 (reinterpret_cast<__m128i*> (out + i), k.unmap (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (pixels + i))));
+                }
+#endif
+                for (; i < count; ++i)
+                    colors[i] = mapper_.unmap (pixels[i]);
+            };
+
+            /**
+             * Maps Colors into a row of pixels stored at the format's size.
+             *
+             * @param colors The Colors.
+             * @param count The number of Colors.
+             * @param dst The row.
+             */
+            void store (const Color* colors, size_t count, void* dst) const {
+                switch (format_->BytesPerPixel) {
+                    case 4:
+                        map (colors, count, static_cast<Uint32*> (dst));
+                        break;
+                    case 2:
+                        store16 (colors, count, static_cast<Uint16*> (dst));
+                        break;
+                    case 1:
+                        if (cube_)
+                            cube_->map (colors, count, static_cast<Uint8*> (dst));
+                        else
+                            for (size_t i = 0; i < count; ++i)
+                                static_cast<Uint8*> (dst)[i] = mapper_.map (colors[i]);
+                        break;
+                    default:
+                        store24 (colors, count, static_cast<Uint8*> (dst));
+                        break;
+                }
+            };
+
+            /**
+             * Maps a row of pixels stored at the format's size to Colors.
+             *
+             * @param src The row.
+             * @param count The number of pixels.
+             * @param colors Receives the Colors.
+             */
+            void load (const void* src, size_t count, Color* colors) const {
+                Uint32 buffer[256];
+                const Uint8* in = static_cast<const Uint8*> (src);
+                int bytes = format_->BytesPerPixel;
+                if (bytes == 4) {
+                    unmap (static_cast<const Uint32*> (src), count, colors);
+                    return;
+                }
+                for (size_t done = 0; done < count; done += 256) {
+                    size_t n = count - done < 256 ? count - done : 256;
+                    for (size_t i = 0; i < n; ++i, in += bytes)
+                        buffer[i] = bytes == 2 ? *reinterpret_cast<const Uint16*> (in) : bytes == 1 ? *in : read24 (in);
+                    unmap (buffer, n, colors + done);
+                }
+            };
+
+            /**
+             * Draws an image of Colors onto a Surface of the converter's format, such as a heat map recolored every frame.
+             *
+             * @param colors The Colors, width * height of the Surface, row by row.
+             * @param surface The Surface.
+             *
+             * @return True if successful, false if the Surface could not be locked.
+             */
+            bool draw (const Color* colors, Surface& surface) const {
+                SDL_Surface* s = surface.to_c ();
+                if (SDL_MUSTLOCK (s) && SDL_LockSurface (s) == -1)
+                    return false;
+                for (int y = 0; y < s->h; ++y)
+                    store (colors + y * s->w, s->w, static_cast<Uint8*> (s->pixels) + y * s->pitch);
+                if (SDL_MUSTLOCK (s))
+                    SDL_UnlockSurface (s);
+                return true;
+            };
+
+            /**
+             * Returns the pixel format.
+             *
+             * @return The pixel format.
+             */
+            const SDL_PixelFormat* format () const { return format_; };
+
+        private:
+#ifdef __SSE2__
+            /**
+             * @struct Kernel
+             * @brief The shifts and masks of a truecolor format in SSE2 registers.
+             */
+            struct Kernel {
+                /**
+                 * Loads the shifts and masks of a format.
+                 *
+                 * @param f The pixel format.
+                 */
+                explicit Kernel (const SDL_PixelFormat* f)
+                  : byte_ (_mm_set1_epi32 (0xff)), amask_ (_mm_set1_epi32 (f->Amask)), opaque_ (_mm_set1_epi32 (SDL_ALPHA_OPAQUE)), alpha_ (f->Amask != 0) {
+                    const Uint32 masks[4] = { f->Rmask, f->Gmask, f->Bmask, f->Amask };
+                    const Uint8 shifts[4] = { f->Rshift, f->Gshift, f->Bshift, f->Ashift };
+                    const Uint8 losses[4] = { f->Rloss, f->Gloss, f->Bloss, f->Aloss };
+                    for (int c = 0; c < 4; ++c) {
+                        mask_[c] = _mm_set1_epi32 (masks[c]);
+                        shift_[c] = _mm_cvtsi32_si128 (shifts[c]);
+                        loss_[c] = _mm_cvtsi32_si128 (losses[c]);
+                        spread_[c] = _mm_cvtsi32_si128 (losses[c] <= 4 ? 8 - (losses[c] << 1) : 0);
+                    }
+                };
+
+                /**
+                 * Determines if unmap matches SDL_GetRGBA for a format, which holds for
+                 * truecolor formats with at least 4 bits per channel.
+                 *
+                 * @param f The pixel format.
+                 *
+                 * @return True if unmap is exact, false otherwise.
+                 */
+                static bool exact (const SDL_PixelFormat* f) {
+                    return f->palette == NULL && f->Rloss <= 4 && f->Gloss <= 4 && f->Bloss <= 4 && (f->Amask == 0 || f->Aloss <= 4);
+                };
+
+                /**
+                 * Maps four Colors.
+                 *
+                 * @param c The Colors packed as 0xRRGGBBAA.
+                 *
+                 * @return The pixel values.
+                 */
+                __m128i map (__m128i c) const {
+                    __m128i r = _mm_srli_epi32 (c, 24);
+                    __m128i g = _mm_and_si128 (_mm_srli_epi32 (c, 16), byte_);
+                    __m128i b = _mm_and_si128 (_mm_srli_epi32 (c, 8), byte_);
+                    __m128i a = _mm_and_si128 (c, byte_);
+                    __m128i p = _mm_sll_epi32 (_mm_srl_epi32 (r, loss_[0]), shift_[0]);
+                    p = _mm_or_si128 (p, _mm_sll_epi32 (_mm_srl_epi32 (g, loss_[1]), shift_[1]));
+                    p = _mm_or_si128 (p, _mm_sll_epi32 (_mm_srl_epi32 (b, loss_[2]), shift_[2]));
+                    return _mm_or_si128 (p, _mm_and_si128 (_mm_sll_epi32 (_mm_srl_epi32 (a, loss_[3]), shift_[3]), amask_));
+                };
+
+                /**
+                 * Unmaps four pixel values.
+                 *
+                 * @param p The pixel values.
+                 *
+                 * @return The Colors packed as 0xRRGGBBAA.
+                 */
+                __m128i unmap (__m128i p) const {
+                    __m128i c = _mm_or_si128 (_mm_slli_epi32 (channel (p, 0), 24), _mm_slli_epi32 (channel (p, 1), 16));
+                    c = _mm_or_si128 (c, _mm_slli_epi32 (channel (p, 2), 8));
+                    return _mm_or_si128 (c, alpha_ ? channel (p, 3) : opaque_);
+                };
+
+                /**
+                 * Widens a channel of four pixel values to 8 bits, as SDL_GetRGBA does.
+                 *
+                 * @param p The pixel values.
+                 * @param i The channel, 0 to 3 for red, green, blue and alpha.
+                 *
+                 * @return The intensities.
+                 */
+                __m128i channel (__m128i p, int i) const {
+                    __m128i v = _mm_srl_epi32 (_mm_and_si128 (p, mask_[i]), shift_[i]);
+                    return _mm_and_si128 (_mm_add_epi32 (_mm_sll_epi32 (v, loss_[i]), _mm_srl_epi32 (v, spread_[i])), byte_);
+                };
+
+                /**
+                 * The low byte of each lane.
+                 */
+                __m128i byte_;
+
+                /**
+                 * The alpha mask.
+                 */
+                __m128i amask_;
+
+                /**
+                 * The alpha of formats without one.
+                 */
+                __m128i opaque_;
+
+                /**
+                 * Whether or not the format has alpha.
+                 */
+                bool alpha_;
+
+                /**
+                 * The masks of the red, green, blue and alpha channels.
+                 */
+                __m128i mask_[4];
+
+                /**
+                 * The shifts of the channels, as shift counts.
+                 */
+                __m128i shift_[4];
+
+                /**
+                 * The losses of the channels, as shift counts.
+                 */
+                __m128i loss_[4];
+
+                /**
+                 * The shifts replicating the high bits of each channel into its low bits.
+                 */
+                __m128i spread_[4];
+            }; //Kernel
+#endif
+
+            /**
+             * Maps Colors into a row of 16 bit pixels.
+             *
+             * @param colors The Colors.
+             * @param count The number of Colors.
+             * @param dst The row.
+             */
+            void store16 (const Color* colors, size_t count, Uint16* dst) const {
+                size_t i = 0;
+                if (cube_) {
+                    for (; i < count; ++i)
+                        dst[i] = (*cube_) (colors[i]);
+                    return;
+                }
+#ifdef __SSE2__
+                Kernel k (format_);
+                const Uint32* in = reinterpret_cast<const Uint32*> (colors);
+                for (; i + 8 <= count; i += 8) {
+                    __m128i lo = k.map (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + i)));
+                    __m128i hi = k.map (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + i + 4)));
+                    //sign extend the low halves so the saturating pack keeps their bits.
+                    lo = _mm_srai_epi32 (_mm_slli_epi32 (lo, 16), 16);
+                    hi = _mm_srai_epi32 (_mm_slli_epi32 (hi, 16), 16);
+                    _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst + i), _mm_packs_epi32 (lo, hi));
+                }
+#endif
+                for (; i < count; ++i)
+                    dst[i] = mapper_.map (colors[i]);
+            };
+
+            /**
+             * Maps Colors into a row of 24 bit pixels.
+             *
+             * @param colors The Colors.
+             * @param count The number of Colors.
+             * @param dst The row.
+             */
+            void store24 (const Color* colors, size_t count, Uint8* dst) const {
+                for (size_t i = 0; i < count; ++i, dst += 3) {
+                    Uint32 p = mapper_.map (colors[i]);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+                    dst[0] = p >> 16;
+                    dst[1] = p >> 8;
+                    dst[2] = p;
+#else
+                    dst[0] = p;
+                    dst[1] = p >> 8;
+                    dst[2] = p >> 16;
+#endif
+                }
+            };
+
+            /**
+             * Reads a 24 bit pixel.
+             *
+             * @param src The pixel.
+             *
+             * @return The pixel value.
+             */
+            static Uint32 read24 (const Uint8* src) {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+                return src[0] << 16 | src[1] << 8 | src[2];
+#else
+                return src[0] | src[1] << 8 | src[2] << 16;
+#endif
+            };
+
+            /**
+             * The Surface whose format is converted to, NULL if constructed from a format.
+             */
+            boost::shared_ptr<Surface> surface_;
+
+            /**
+             * The pixel format.
+             */
+            const SDL_PixelFormat* format_;
+
+            /**
+             * Maps single pixels.
+             */
+            PixelMapper mapper_;
+
+            /**
+             * The lookup table of a paletted format, NULL otherwise.
+             */
+            boost::shared_ptr<PaletteCube> cube_;
+    }; //PixelConverter
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_PIXELCONVERTER_H
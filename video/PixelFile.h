@@ -0,0 +1,202 @@
+/**
+ * @file PixelFile.h
+ * Contains the PixelFile class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_PIXELFILE_H
+#define SDL_VIDEO_PIXELFILE_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include <SDL.h>
+
+#include "sdlpp/video/Surface.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+
+    /**
+     * @struct PixelFileHeader
+     * @brief The header of a raw pixel file.
+     *
+     * A raw pixel file is the header followed, at dataOffset_, by height_ rows of pitch_ bytes
+     * stored top to bottom in the native byte order of the machine that wrote it. Unlike bitmaps
+     * it keeps the alpha channel and the exact pixel format of the Surface.
+     */
+    struct PixelFileHeader {
+        /**
+         * The file magic.
+         */
+        char magic_[8];
+
+        /**
+         * Written as 0x01020304 to detect files from a machine of the other endianness.
+         */
+        Uint32 byteOrder_;
+
+        /**
+         * The width in pixels.
+         */
+        Uint32 width_;
+
+        /**
+         * The height in pixels.
+         */
+        Uint32 height_;
+
+        /**
+         * The size of a row in bytes.
+         */
+        Uint32 pitch_;
+
+        /**
+         * The number of bits per pixel.
+         */
+        Uint32 bpp_;
+
+        /**
+         * The red, green, blue and alpha masks.
+         */
+        Uint32 rmask_, gmask_, bmask_, amask_;
+
+        /**
+         * The offset of the first row from the start of the file.
+         */
+        Uint32 dataOffset_;
+
+        /**
+         * The offset of the first row. Rows start on a 64 byte boundary so they can be used in place.
+         */
+        static const Uint32 DATA_OFFSET = 64;
+
+        /**
+         * Returns the file magic.
+         *
+         * @return The file magic.
+         */
+        static const char* magic () { return "SDLPIX01"; };
+
+        /**
+         * Determines if the header describes a file this machine can read.
+         *
+         * @return True if valid, false otherwise.
+         */
+        bool valid () const {
+            return memcmp (magic_, magic (), sizeof (magic_)) == 0
+                && byteOrder_ == 0x01020304
+                && (bpp_ == 8 || bpp_ == 16 || bpp_ == 24 || bpp_ == 32)
+                && pitch_ >= width_ * (bpp_ / 8)
+                && dataOffset_ >= sizeof (PixelFileHeader);
+        };
+    }; //PixelFileHeader
+
+    /**
+     * @struct PixelFile
+     * @brief Reads and writes Surfaces as raw pixel files.
+     */
+    struct PixelFile {
+        /**
+         * Saves a Surface to a raw pixel file.
+         *
+         * @param surface The Surface to save. Paletted Surfaces are not supported.
+         * @param fileName The name of the file.
+         *
+         * @return True if successful, false otherwise.
+         */
+        static bool save (const Surface& surface, const string& fileName) {
+            SDL_Surface* s = surface.to_c ();
+            if (s->format->BitsPerPixel == 8)
+                return false;
+
+            PixelFileHeader header;
+            memset (&header, 0, sizeof (header));
+            memcpy (header.magic_, PixelFileHeader::magic (), sizeof (header.magic_));
+            header.byteOrder_ = 0x01020304;
+            header.width_ = s->w;
+            header.height_ = s->h;
+            header.pitch_ = s->w * s->format->BytesPerPixel;
+            header.bpp_ = s->format->BitsPerPixel;
+            header.rmask_ = s->format->Rmask;
+            header.gmask_ = s->format->Gmask;
+            header.bmask_ = s->format->Bmask;
+            header.amask_ = s->format->Amask;
+            header.dataOffset_ = PixelFileHeader::DATA_OFFSET;
+
+            FILE* file = fopen (fileName.c_str (), "wb");
+            if (file == NULL)
+                return false;
+            char padding[PixelFileHeader::DATA_OFFSET] = { 0 };
+            bool ok = fwrite (&header, sizeof (header), 1, file) == 1
+                   && fwrite (padding, header.dataOffset_ - sizeof (header), 1, file) == 1;
+            if (ok && SDL_LockSurface (s) == 0) {
+                const Uint8* row = static_cast<const Uint8*> (s->pixels);
+                for (int y = 0; ok && y < s->h; ++y, row += s->pitch)
+                    ok = fwrite (row, header.pitch_, 1, file) == 1;
+                SDL_UnlockSurface (s);
+            } else
+                ok = false;
+            return fclose (file) == 0 && ok;
+        };
+
+        /**
+         * Loads a Surface from a raw pixel file.
+         *
+         * @param fileName The name of the file.
+         *
+         * @return The loaded Surface.
+         *
+         * @throw runtime_error Throws a runtime_error if unable to read the file.
+         */
+        static Surface load (const string& fileName) {
+            FILE* file = fopen (fileName.c_str (), "rb");
+            if (file == NULL)
+                throw runtime_error ("Failed to open " + fileName);
+            PixelFileHeader header;
+            if (fread (&header, sizeof (header), 1, file) != 1 || !header.valid ()
+                || fseek (file, header.dataOffset_, SEEK_SET) != 0) {
+                fclose (file);
+                throw runtime_error ("Invalid pixel file " + fileName);
+            }
+
+            SDL_Surface* s = SDL_CreateRGBSurface (SDL_SWSURFACE, header.width_, header.height_, header.bpp_,
+                                                   header.rmask_, header.gmask_, header.bmask_, header.amask_);
+            if (s == NULL) {
+                fclose (file);
+                throw runtime_error (SDL_GetError ());
+            }
+            Surface surface (s);
+
+            bool ok = true;
+            Uint8* row = static_cast<Uint8*> (s->pixels);
+            for (Uint32 y = 0; ok && y < header.height_; ++y, row += s->pitch)
+                ok = fread (row, header.width_ * (header.bpp_ / 8), 1, file) == 1
+                  && fseek (file, header.pitch_ - header.width_ * (header.bpp_ / 8), SEEK_CUR) == 0;
+            fclose (file);
+            if (!ok)
+                throw runtime_error ("Truncated pixel file " + fileName);
+            return surface;
+        };
+    }; //PixelFile
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_PIXELFILE_H
@@ -0,0 +1,134 @@
+/**
+ * @file Qoi.h
+ * Contains the Qoi class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_QOI_H
+#define SDL_VIDEO_QOI_H
+
+#include <cstring>
+#include <vector>
+
+#include <SDL.h>
+
+namespace sdl {
+namespace video {
+    using namespace std;
+
+    /**
+     * @struct Qoi
+     * @brief Encodes images in the "Quite OK Image" format.
+     *
+     * A lossless format that typically compresses screenshots to a fraction of a bitmap at a
+     * fraction of the cost of deflate, which makes it suitable for dumping frames in real time.
+     */
+    struct Qoi {
+        /**
+         * Encodes RGBA pixels.
+         *
+         * @param pixels The pixels, four bytes per pixel in red, green, blue, alpha order.
+         * @param width The width in pixels.
+         * @param height The height in pixels.
+         * @param pitch The size of a row in bytes.
+         * @param channels 4 to record an alpha channel, 3 otherwise.
+         * @param out Receives the encoded image.
+         */
+        static void encode (const Uint8* pixels, int width, int height, int pitch, int channels, vector<Uint8>& out) {
+            out.clear ();
+            out.reserve (14 + width * height + 8);
+            out.push_back ('q');
+            out.push_back ('o');
+            out.push_back ('i');
+            out.push_back ('f');
+            put32 (out, width);
+            put32 (out, height);
+            out.push_back (channels);
+            out.push_back (0);
+
+            Uint8 index[64][4];
+            memset (index, 0, sizeof (index));
+            Uint8 prev[4] = { 0, 0, 0, 255 };
+            int run = 0;
+            for (int y = 0; y < height; ++y) {
+                const Uint8* px = pixels + y * pitch;
+                for (int x = 0; x < width; ++x, px += 4) {
+                    if (memcmp (px, prev, 4) == 0) {
+                        if (++run == 62) {
+                            out.push_back (0xc0 | (run - 1));
+                            run = 0;
+                        }
+                        continue;
+                    }
+                    if (run > 0) {
+                        out.push_back (0xc0 | (run - 1));
+                        run = 0;
+                    }
+
+                    int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+                    if (memcmp (index[hash], px, 4) == 0)
+                        out.push_back (hash);
+                    else {
+                        memcpy (index[hash], px, 4);
+                        if (px[3] == prev[3]) {
+                            signed char vr = px[0] - prev[0];
+                            signed char vg = px[1] - prev[1];
+                            signed char vb = px[2] - prev[2];
+                            signed char vgr = vr - vg;
+                            signed char vgb = vb - vg;
+                            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                                out.push_back (0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                            else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                                out.push_back (0x80 | (vg + 32));
+                                out.push_back ((vgr + 8) << 4 | (vgb + 8));
+                            } else {
+                                out.push_back (0xfe);
+                                out.insert (out.end (), px, px + 3);
+                            }
+                        } else {
+                            out.push_back (0xff);
+                            out.insert (out.end (), px, px + 4);
+                        }
+                    }
+                    memcpy (prev, px, 4);
+                }
+            }
+            if (run > 0)
+                out.push_back (0xc0 | (run - 1));
+
+            static const Uint8 end[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+            out.insert (out.end (), end, end + 8);
+        };
+
+        private:
+            /**
+             * Appends a big endian 32 bit value.
+             *
+             * @param out The buffer.
+             * @param value The value.
+             */
+            static void put32 (vector<Uint8>& out, Uint32 value) {
+                out.push_back (value >> 24);
+                out.push_back (value >> 16);
+                out.push_back (value >> 8);
+                out.push_back (value);
+            };
+    }; //Qoi
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_QOI_H
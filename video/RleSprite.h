@@ -0,0 +1,510 @@
+/**
+ * @file RleSprite.h
+ * Contains the RleSprite class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_RLESPRITE_H
+#define SDL_VIDEO_RLESPRITE_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <SDL.h>
+
+#include "sdlpp/video/Surface.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+
+    /**
+     * @struct RleFileHeader
+     * @brief The header of a run-length encoded sprite file.
+     *
+     * The header is followed by the row run offsets, the row pixel offsets, the runs, the pixels
+     * and one alpha per pixel, all in the native byte order of the machine that wrote it.
+     */
+    struct RleFileHeader {
+        /**
+         * The file magic.
+         */
+        char magic_[8];
+
+        /**
+         * Written as 0x01020304 to detect files from a machine of the other endianness.
+         */
+        Uint32 byteOrder_;
+
+        /**
+         * The width in pixels.
+         */
+        Uint32 width_;
+
+        /**
+         * The height in pixels.
+         */
+        Uint32 height_;
+
+        /**
+         * The red, green, blue and alpha masks of the 32 bit pixels.
+         */
+        Uint32 rmask_, gmask_, bmask_, amask_;
+
+        /**
+         * The number of run lengths.
+         */
+        Uint32 runs_;
+
+        /**
+         * The number of stored pixels.
+         */
+        Uint32 pixels_;
+
+        /**
+         * Returns the file magic.
+         *
+         * @return The file magic.
+         */
+        static const char* magic () { return "SDLRLE01"; };
+
+        /**
+         * Determines if the header describes a file this machine can read.
+         *
+         * @return True if valid, false otherwise.
+         */
+        bool valid () const {
+            return memcmp (magic_, magic (), sizeof (magic_)) == 0
+                && byteOrder_ == 0x01020304
+                && width_ <= 0xffff && height_ <= 0xffff
+                && runs_ % 3 == 0 && pixels_ <= width_ * height_;
+        };
+    }; //RleFileHeader
+
+    /**
+     * @class RleSprite
+     * @brief A sprite stored as runs of transparent, opaque and translucent pixels.
+     *
+     * Each row is a list of (skip, opaque, translucent) run lengths. Blitting skips transparent
+     * runs without reading them, copies opaque runs with memcpy and blends only the translucent
+     * ones, so a mostly transparent sprite costs little more than its visible pixels. As with
+     * SDL's alpha blitters, a destination's alpha channel is left untouched, so opaque runs onto
+     * a destination with alpha are copied a pixel at a time to keep it. Unlike SDL_RLEACCEL the
+     * encoding is done once, can be saved and loaded, and the pixels are stored already in the
+     * destination format.
+     */
+    class RleSprite {
+        public:
+            /**
+             * Encodes a Surface. Pixels matching the color key or with an alpha of 0 become
+             * transparent. Alpha comes from the alpha channel when alpha blending is enabled, or
+             * from the Surface's alpha if it has no alpha channel.
+             *
+             * @param surface The Surface to encode.
+             * @param format The 32 bit format of the Surfaces the sprite will be blitted onto, usually
+             * the display's, NULL for the format of surface.
+             *
+             * @throw runtime_error Throws a runtime_error if the format is not 32 bits or surface is too large.
+             */
+            RleSprite (const Surface& surface, const SDL_PixelFormat* format = NULL)
+              : width_ (0), height_ (0), rmask_ (0), gmask_ (0), bmask_ (0), amask_ (0),
+                rows_ (), rowPixels_ (), runs_ (), pixels_ (), alphas_ () {
+                SDL_Surface* s = surface.to_c ();
+                if (format == NULL)
+                    format = s->format;
+                if (format->BytesPerPixel != 4)
+                    throw runtime_error ("RleSprite requires a 32 bit format.");
+                if (s->w > 0xffff || s->h > 0xffff)
+                    throw runtime_error ("Surface too large for RleSprite.");
+                width_ = s->w;
+                height_ = s->h;
+                rmask_ = format->Rmask;
+                gmask_ = format->Gmask;
+                bmask_ = format->Bmask;
+                amask_ = format->Amask;
+
+                if (SDL_MUSTLOCK (s) && SDL_LockSurface (s) == -1)
+                    throw runtime_error (SDL_GetError ());
+                bool keyed = (s->flags & SDL_SRCCOLORKEY) != 0;
+                bool blended = (s->flags & SDL_SRCALPHA) != 0;
+                vector<Uint8> alpha (width_);
+                vector<Uint32> mapped (width_);
+                for (int y = 0; y < height_; ++y) {
+                    const Uint8* in = static_cast<const Uint8*> (s->pixels) + y * s->pitch;
+                    for (int x = 0; x < width_; ++x) {
+                        Uint32 pixel = read (in + x * s->format->BytesPerPixel, s->format->BytesPerPixel);
+                        Uint8 r, g, b, a;
+                        SDL_GetRGBA (pixel, s->format, &r, &g, &b, &a);
+                        if (keyed && pixel == s->format->colorkey)
+                            a = 0;
+                        else if (!blended)
+                            a = SDL_ALPHA_OPAQUE;
+                        else if (s->format->Amask == 0)
+                            a = s->format->alpha;
+                        alpha[x] = a;
+                        mapped[x] = SDL_MapRGBA (format, r, g, b, a);
+                    }
+                    encode (alpha, mapped);
+                }
+                if (SDL_MUSTLOCK (s))
+                    SDL_UnlockSurface (s);
+                rows_.push_back (runs_.size ());
+                rowPixels_.push_back (pixels_.size ());
+            };
+
+            /**
+             * Loads a sprite saved with save.
+             *
+             * @param fileName The name of the file.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to read the file.
+             */
+            explicit RleSprite (const string& fileName)
+              : width_ (0), height_ (0), rmask_ (0), gmask_ (0), bmask_ (0), amask_ (0),
+                rows_ (), rowPixels_ (), runs_ (), pixels_ (), alphas_ () {
+                FILE* file = fopen (fileName.c_str (), "rb");
+                if (file == NULL)
+                    throw runtime_error ("Failed to open " + fileName);
+                RleFileHeader header;
+                bool ok = fread (&header, sizeof (header), 1, file) == 1 && header.valid ();
+                if (ok) {
+                    width_ = header.width_;
+                    height_ = header.height_;
+                    rmask_ = header.rmask_;
+                    gmask_ = header.gmask_;
+                    bmask_ = header.bmask_;
+                    amask_ = header.amask_;
+                    rows_.resize (height_ + 1);
+                    rowPixels_.resize (height_ + 1);
+                    runs_.resize (header.runs_);
+                    pixels_.resize (header.pixels_);
+                    alphas_.resize (header.pixels_);
+                    ok = read (file, rows_) && read (file, rowPixels_) && read (file, runs_) && read (file, pixels_) && read (file, alphas_);
+                }
+                fclose (file);
+                if (!ok || !consistent ())
+                    throw runtime_error ("Invalid sprite file " + fileName);
+            };
+
+            /**
+             * Saves the sprite.
+             *
+             * @param fileName The name of the file.
+             *
+             * @return True if successful, false otherwise.
+             */
+            bool save (const string& fileName) const {
+                RleFileHeader header;
+                memset (&header, 0, sizeof (header));
+                memcpy (header.magic_, RleFileHeader::magic (), sizeof (header.magic_));
+                header.byteOrder_ = 0x01020304;
+                header.width_ = width_;
+                header.height_ = height_;
+                header.rmask_ = rmask_;
+                header.gmask_ = gmask_;
+                header.bmask_ = bmask_;
+                header.amask_ = amask_;
+                header.runs_ = runs_.size ();
+                header.pixels_ = pixels_.size ();
+
+                FILE* file = fopen (fileName.c_str (), "wb");
+                if (file == NULL)
+                    return false;
+                bool ok = fwrite (&header, sizeof (header), 1, file) == 1
+                       && write (file, rows_) && write (file, rowPixels_) && write (file, runs_) && write (file, pixels_) && write (file, alphas_);
+                return fclose (file) == 0 && ok;
+            };
+
+            /**
+             * Blits the sprite, clipped to the destination's clip rectangle.
+             *
+             * @param dst The Surface onto which to blit, in the format the sprite was encoded for.
+             * @param x The x offset on the destination.
+             * @param y The y offset on the destination.
+             *
+             * @return A reference to this RleSprite.
+             *
+             * @throw runtime_error Throws a runtime_error if the destination's format differs or it cannot be locked.
+             */
+            const RleSprite& blit (Surface& dst, int x, int y) const {
+                SDL_Surface* d = dst.to_c ();
+                SDL_PixelFormat* f = d->format;
+                if (f->BytesPerPixel != 4 || f->Rmask != rmask_ || f->Gmask != gmask_ || f->Bmask != bmask_)
+                    throw runtime_error ("RleSprite blitted onto a Surface of another format.");
+                const SDL_Rect& clip = d->clip_rect;
+                int x0 = max (x, static_cast<int> (clip.x));
+                int x1 = min (x + width_, clip.x + clip.w);
+                int y0 = max (y, static_cast<int> (clip.y));
+                int y1 = min (y + height_, clip.y + clip.h);
+                if (x0 >= x1 || y0 >= y1)
+                    return *this;
+
+                if (SDL_MUSTLOCK (d) && SDL_LockSurface (d) == -1)
+                    throw runtime_error (SDL_GetError ());
+                int shifts[3] = { shift (rmask_), shift (gmask_), shift (bmask_) };
+                Uint32 keep = ~(rmask_ | gmask_ | bmask_);
+                for (int dy = y0; dy < y1; ++dy) {
+                    int row = dy - y;
+                    Uint32* out = reinterpret_cast<Uint32*> (static_cast<Uint8*> (d->pixels) + dy * d->pitch);
+                    Uint32 pixel = rowPixels_[row];
+                    int cx = x;
+                    for (Uint32 r = rows_[row]; r < rows_[row + 1] && cx < x1; r += 3) {
+                        cx += runs_[r];
+                        int a = max (cx, x0);
+                        int b = min (cx + runs_[r + 1], x1);
+                        if (a < b && f->Amask == 0)
+                            memcpy (out + a, &pixels_[pixel + (a - cx)], (b - a) * sizeof (Uint32));
+                        else
+                            for (int px = a; px < b; ++px)
+                                out[px] = (pixels_[pixel + (px - cx)] & ~keep) | (out[px] & keep);
+                        pixel += runs_[r + 1];
+                        cx += runs_[r + 1];
+
+                        a = max (cx, x0);
+                        b = min (cx + runs_[r + 2], x1);
+                        for (int px = a; px < b; ++px)
+                            out[px] = blend (pixels_[pixel + (px - cx)], out[px], alphas_[pixel + (px - cx)], shifts, keep);
+                        pixel += runs_[r + 2];
+                        cx += runs_[r + 2];
+                    }
+                }
+                if (SDL_MUSTLOCK (d))
+                    SDL_UnlockSurface (d);
+                return *this;
+            };
+
+            /**
+             * Returns the width.
+             *
+             * @return The width.
+             */
+            int width () const { return width_; };
+
+            /**
+             * Returns the height.
+             *
+             * @return The height.
+             */
+            int height () const { return height_; };
+
+            /**
+             * Returns the number of visible, opaque or translucent, pixels.
+             *
+             * @return The number of visible pixels.
+             */
+            size_t visible () const { return pixels_.size (); };
+
+            /**
+             * Returns the number of bytes held by the encoding.
+             *
+             * @return The number of bytes.
+             */
+            size_t bytes () const {
+                return (rows_.size () + rowPixels_.size () + pixels_.size ()) * sizeof (Uint32) + runs_.size () * sizeof (Uint16) + alphas_.size ();
+            };
+
+        private:
+            /**
+             * Reads a pixel value of any depth.
+             *
+             * @param p The first byte of the pixel.
+             * @param bytes The number of bytes per pixel.
+             *
+             * @return The pixel value.
+             */
+            static Uint32 read (const Uint8* p, int bytes) {
+                switch (bytes) {
+                    case 1:
+                        return *p;
+                    case 2:
+                        return *reinterpret_cast<const Uint16*> (p);
+                    case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+                        return (p[0] << 16) | (p[1] << 8) | p[2];
+#else
+                        return p[0] | (p[1] << 8) | (p[2] << 16);
+#endif
+                    default:
+                        return *reinterpret_cast<const Uint32*> (p);
+                }
+            };
+
+            /**
+             * Returns the position of the lowest bit of a mask.
+             *
+             * @param mask The mask.
+             *
+             * @return The shift.
+             */
+            static int shift (Uint32 mask) {
+                int s = 0;
+                while (mask != 0 && (mask & 1) == 0) {
+                    mask >>= 1;
+                    ++s;
+                }
+                return s;
+            };
+
+            /**
+             * Blends a pixel over another the way SDL's alpha blitters do, keeping the destination's alpha.
+             *
+             * @param src The source pixel.
+             * @param dst The destination pixel.
+             * @param alpha The source alpha.
+             * @param shifts The shifts of the red, green and blue channels.
+             * @param keep The bits of the destination to keep.
+             *
+             * @return The blended pixel.
+             */
+            static Uint32 blend (Uint32 src, Uint32 dst, Uint32 alpha, const int* shifts, Uint32 keep) {
+                Uint32 out = dst & keep;
+                for (int c = 0; c < 3; ++c) {
+                    int s = (src >> shifts[c]) & 0xff;
+                    int d = (dst >> shifts[c]) & 0xff;
+                    out |= static_cast<Uint32> (d + (((s - d) * static_cast<int> (alpha)) >> 8)) << shifts[c];
+                }
+                return out;
+            };
+
+            /**
+             * Appends the runs of a row.
+             *
+             * @param alpha The alpha of each pixel of the row.
+             * @param mapped The pixel values of the row in the target format.
+             */
+            void encode (const vector<Uint8>& alpha, const vector<Uint32>& mapped) {
+                rows_.push_back (runs_.size ());
+                rowPixels_.push_back (pixels_.size ());
+                int x = 0;
+                while (x < width_) {
+                    int start = x;
+                    while (x < width_ && alpha[x] == 0)
+                        ++x;
+                    if (x == width_)
+                        break;
+                    Uint16 skip = x - start;
+
+                    start = x;
+                    while (x < width_ && alpha[x] == SDL_ALPHA_OPAQUE)
+                        ++x;
+                    Uint16 opaque = x - start;
+
+                    start = x;
+                    while (x < width_ && alpha[x] != 0 && alpha[x] != SDL_ALPHA_OPAQUE)
+                        ++x;
+                    Uint16 translucent = x - start;
+
+                    runs_.push_back (skip);
+                    runs_.push_back (opaque);
+                    runs_.push_back (translucent);
+                    pixels_.insert (pixels_.end (), mapped.begin () + (x - opaque - translucent), mapped.begin () + x);
+                    alphas_.insert (alphas_.end (), alpha.begin () + (x - opaque - translucent), alpha.begin () + x);
+                }
+            };
+
+            /**
+             * Checks loaded offsets and runs so a damaged file cannot make blit read out of bounds.
+             *
+             * @return True if consistent, false otherwise.
+             */
+            bool consistent () const {
+                if (rows_[0] != 0 || rowPixels_[0] != 0 || rows_[height_] != runs_.size () || rowPixels_[height_] != pixels_.size ())
+                    return false;
+                for (int y = 0; y < height_; ++y) {
+                    if (rows_[y + 1] < rows_[y] || (rows_[y + 1] - rows_[y]) % 3 != 0 || rowPixels_[y + 1] < rowPixels_[y])
+                        return false;
+                    Uint32 covered = 0;
+                    Uint32 stored = 0;
+                    for (Uint32 r = rows_[y]; r < rows_[y + 1]; r += 3) {
+                        covered += runs_[r] + runs_[r + 1] + runs_[r + 2];
+                        stored += runs_[r + 1] + runs_[r + 2];
+                    }
+                    if (covered > static_cast<Uint32> (width_) || stored != rowPixels_[y + 1] - rowPixels_[y])
+                        return false;
+                }
+                return true;
+            };
+
+            /**
+             * Reads an array.
+             *
+             * @param file The file.
+             * @param values Receives the values, already sized.
+             *
+             * @return True if successful, false otherwise.
+             */
+            template <typename T>
+            static bool read (FILE* file, vector<T>& values) {
+                return values.empty () || fread (&values[0], sizeof (T) * values.size (), 1, file) == 1;
+            };
+
+            /**
+             * Writes an array.
+             *
+             * @param file The file.
+             * @param values The values.
+             *
+             * @return True if successful, false otherwise.
+             */
+            template <typename T>
+            static bool write (FILE* file, const vector<T>& values) {
+                return values.empty () || fwrite (&values[0], sizeof (T) * values.size (), 1, file) == 1;
+            };
+
+            /**
+             * The size in pixels.
+             */
+            int width_, height_;
+
+            /**
+             * The red, green, blue and alpha masks of the stored pixels.
+             */
+            Uint32 rmask_, gmask_, bmask_, amask_;
+
+            /**
+             * The index of the first run of each row, plus the total.
+             */
+            vector<Uint32> rows_;
+
+            /**
+             * The index of the first stored pixel of each row, plus the total.
+             */
+            vector<Uint32> rowPixels_;
+
+            /**
+             * The (skip, opaque, translucent) run lengths of every row.
+             */
+            vector<Uint16> runs_;
+
+            /**
+             * The opaque and translucent pixels in the target format.
+             */
+            vector<Uint32> pixels_;
+
+            /**
+             * The alpha of each stored pixel.
+             */
+            vector<Uint8> alphas_;
+    }; //RleSprite
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_RLESPRITE_H
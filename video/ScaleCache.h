@@ -0,0 +1,285 @@
+/**
+ * @file ScaleCache.h
+ * Contains the ScaleCache class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_SCALECACHE_H
+#define SDL_VIDEO_SCALECACHE_H
+
+#include <list>
+#include <map>
+#include <stdexcept>
+
+#include <SDL.h>
+
+#include "sdlpp/misc/Rect.h"
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/video/Scaler.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace misc;
+
+    /**
+     * @class ScaleCache
+     * @brief Memoizes scaled copies of Surfaces.
+     *
+     * Copies are keyed by source, size and filter. The bytes held are bounded, the least recently
+     * used copies are dropped first. The cache cannot see a source's pixels change, release the
+     * source after drawing on it.
+     */
+    class ScaleCache {
+        public:
+            /**
+             * Constructs an empty ScaleCache.
+             *
+             * @param maxBytes The maximum number of bytes of scaled pixels to hold.
+             */
+            explicit ScaleCache (size_t maxBytes = 32 << 20) : entries_ (), order_ (), bytes_ (0), maxBytes_ (maxBytes) {};
+
+            /**
+             * Destroys the ScaleCache.
+             */
+            ~ScaleCache () {};
+
+            /**
+             * Returns a scaled copy of a Surface, scaling it on first use.
+             *
+             * @param surface The Surface to scale.
+             * @param width The width of the copy.
+             * @param height The height of the copy.
+             * @param filter The filter used to scale.
+             *
+             * @return The scaled Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to scale the Surface.
+             */
+            Surface get (const Surface& surface, int width, int height, Scaler::Filter filter = Scaler::BILINEAR) {
+                Key key = { surface.to_c (), width, height, filter };
+                Entries::iterator cur = entries_.find (key);
+                if (cur != entries_.end ()) {
+                    order_.splice (order_.end (), order_, cur->second.use_);
+                    return cur->second.scaled_;
+                }
+
+                Surface scaled = surface.scaled (width, height, filter);
+                Entry entry = { surface, scaled, order_.insert (order_.end (), key) };
+                entries_.insert (make_pair (key, entry));
+                bytes_ += bytes (scaled);
+                evict ();
+                return scaled;
+            };
+
+            /**
+             * Blits a Surface onto a target scaled to the size of the destination rectangle, through the cache.
+             *
+             * @param target The Surface onto which to blit.
+             * @param surface The Surface from which to blit.
+             * @param dstRect The destination rectangle.
+             * @param filter The filter used to scale.
+             *
+             * @return A reference to this ScaleCache.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to scale or blit.
+             */
+            ScaleCache& blit (Surface& target, const Surface& surface, const Rect& dstRect, Scaler::Filter filter = Scaler::BILINEAR) {
+                Surface scaled = get (surface, dstRect.width (), dstRect.height (), filter);
+                SDL_Rect dst;
+                dst.x = dstRect.x ();
+                dst.y = dstRect.y ();
+                if (SDL_BlitSurface (scaled.to_c (), NULL, target.to_c (), &dst) == -1)
+                    throw runtime_error (SDL_GetError ());
+                return *this;
+            };
+
+            /**
+             * Drops the scaled copies of a Surface.
+             *
+             * @param surface The Surface whose copies to drop.
+             *
+             * @return A reference to this ScaleCache.
+             */
+            ScaleCache& release (const Surface& surface) {
+                Key first = { surface.to_c (), 0, 0, Scaler::NEAREST };
+                Entries::iterator cur = entries_.lower_bound (first);
+                while (cur != entries_.end () && cur->first.surface_ == surface.to_c ())
+                    erase (cur++);
+                return *this;
+            };
+
+            /**
+             * Drops all scaled copies.
+             *
+             * @return A reference to this ScaleCache.
+             */
+            ScaleCache& clear () {
+                entries_.clear ();
+                order_.clear ();
+                bytes_ = 0;
+                return *this;
+            };
+
+            /**
+             * Returns the number of scaled copies held.
+             *
+             * @return The number of scaled copies.
+             */
+            size_t size () const { return entries_.size (); };
+
+            /**
+             * Returns the number of bytes of scaled pixels held.
+             *
+             * @return The number of bytes.
+             */
+            size_t bytes () const { return bytes_; };
+
+        private:
+            /**
+             * Copy constructs a ScaleCache.
+             *
+             * @param rhs The ScaleCache to copy.
+             */
+            ScaleCache (const ScaleCache& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The ScaleCache from which to assign.
+             *
+             * @return A reference to this ScaleCache.
+             */
+            ScaleCache& operator= (const ScaleCache& rhs);
+
+            /**
+             * @struct Key
+             * @brief Identifies a scaled copy.
+             */
+            struct Key {
+                /**
+                 * Orders Keys by source first so the copies of a source are adjacent.
+                 *
+                 * @param rhs The Key to compare against.
+                 *
+                 * @return True if this Key orders before rhs, false otherwise.
+                 */
+                bool operator< (const Key& rhs) const {
+                    if (surface_ != rhs.surface_)
+                        return surface_ < rhs.surface_;
+                    if (width_ != rhs.width_)
+                        return width_ < rhs.width_;
+                    if (height_ != rhs.height_)
+                        return height_ < rhs.height_;
+                    return filter_ < rhs.filter_;
+                };
+
+                /**
+                 * The SDL_Surface structure of the source.
+                 */
+                const SDL_Surface* surface_;
+
+                /**
+                 * The size of the copy.
+                 */
+                int width_, height_;
+
+                /**
+                 * The filter.
+                 */
+                Scaler::Filter filter_;
+            }; //Key
+
+            /**
+             * @struct Entry
+             * @brief A scaled copy.
+             */
+            struct Entry {
+                /**
+                 * The source, held so its SDL_Surface structure is not reused while cached.
+                 */
+                Surface source_;
+
+                /**
+                 * The scaled copy.
+                 */
+                Surface scaled_;
+
+                /**
+                 * The position of the Key in the use order.
+                 */
+                list<Key>::iterator use_;
+            }; //Entry
+
+            /**
+             * @typedef map<Key, Entry> Entries
+             * @brief The type of the cached copies.
+             */
+            typedef map<Key, Entry> Entries;
+
+            /**
+             * Returns the number of bytes of pixels held by a Surface.
+             *
+             * @param surface The Surface.
+             *
+             * @return The number of bytes.
+             */
+            static size_t bytes (const Surface& surface) { return static_cast<size_t> (surface.to_c ()->pitch) * surface.to_c ()->h; };
+
+            /**
+             * Drops a copy.
+             *
+             * @param cur The copy.
+             */
+            void erase (Entries::iterator cur) {
+                bytes_ -= bytes (cur->second.scaled_);
+                order_.erase (cur->second.use_);
+                entries_.erase (cur);
+            };
+
+            /**
+             * Drops the least recently used copies until the bound is met, always keeping the most recent.
+             */
+            void evict () {
+                while (bytes_ > maxBytes_ && order_.size () > 1)
+                    erase (entries_.find (order_.front ()));
+            };
+
+            /**
+             * The cached copies.
+             */
+            Entries entries_;
+
+            /**
+             * The Keys from least to most recently used.
+             */
+            list<Key> order_;
+
+            /**
+             * The number of bytes of scaled pixels held.
+             */
+            size_t bytes_;
+
+            /**
+             * The maximum number of bytes of scaled pixels to hold.
+             */
+            size_t maxBytes_;
+    }; //ScaleCache
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_SCALECACHE_H
@@ -0,0 +1,447 @@
+/**
+ * @file Scaler.h
+ * Contains the Scaler class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_SCALER_H
+#define SDL_VIDEO_SCALER_H
+
+#include <cmath>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <SDL.h>
+
+namespace sdl {
+namespace video {
+    using namespace std;
+
+    /**
+     * @struct Scaler
+     * @brief Scales and rotates SDL_Surfaces in software.
+     *
+     * Works on 32 bit pixels, other depths and color keyed surfaces are first converted to 32
+     * bits with the key turned into transparent alpha so filtered edges fade out rather than
+     * smear the key color. Coordinates are stepped in 16.16 fixed point. The bilinear and box
+     * inner loops use SSE2 when compiled for it and produce the same pixels as the scalar loops.
+     */
+    struct Scaler {
+        /**
+         * The filter used to sample the source.
+         */
+        enum Filter {
+            /**
+             * The nearest source pixel, fastest and keeps hard edges.
+             */
+            NEAREST,
+
+            /**
+             * A weighted average of the four nearest source pixels.
+             */
+            BILINEAR,
+
+            /**
+             * The average of every source pixel a destination pixel covers, the best choice for
+             * shrinking. When enlarging it behaves like NEAREST.
+             */
+            BOX
+        };
+
+        /**
+         * Scales an area of a surface.
+         *
+         * @param src The source surface.
+         * @param area The area to scale, NULL for the whole surface.
+         * @param width The width of the result.
+         * @param height The height of the result.
+         * @param filter The filter.
+         *
+         * @return A new 32 bit software surface, NULL on failure with the error set.
+         */
+        static SDL_Surface* scale (SDL_Surface* src, const SDL_Rect* area, int width, int height, Filter filter) {
+            SDL_Rect a = { 0, 0, static_cast<Uint16> (src->w), static_cast<Uint16> (src->h) };
+            if (area != NULL) {
+                int x0 = max (static_cast<int> (area->x), 0);
+                int y0 = max (static_cast<int> (area->y), 0);
+                a.x = x0;
+                a.y = y0;
+                a.w = max (min (area->x + area->w, src->w) - x0, 0);
+                a.h = max (min (area->y + area->h, src->h) - y0, 0);
+            }
+            if (width <= 0 || height <= 0 || a.w == 0 || a.h == 0) {
+                SDL_SetError ("Invalid scale size.");
+                return NULL;
+            }
+
+            Source source (src, false);
+            if (source.surface_ == NULL)
+                return NULL;
+            SDL_Surface* dst = create (source, width, height);
+            if (dst == NULL)
+                return NULL;
+
+            if (filter == NEAREST || (filter == BOX && width >= a.w && height >= a.h))
+                nearest (source.surface_, a, dst);
+            else if (filter == BILINEAR)
+                bilinear (source.surface_, a, dst);
+            else
+                box (source.surface_, a, dst);
+            return dst;
+        };
+
+        /**
+         * Rotates and zooms a surface about its center. The result is large enough to hold the
+         * rotated surface and transparent outside of it.
+         *
+         * @param src The source surface.
+         * @param angle The counterclockwise rotation in degrees.
+         * @param zoom The scale factor.
+         * @param filter The filter, BOX samples as BILINEAR.
+         *
+         * @return A new 32 bit software surface with an alpha channel, NULL on failure with the error set.
+         */
+        static SDL_Surface* transform (SDL_Surface* src, double angle, double zoom, Filter filter) {
+            if (zoom <= 0.0) {
+                SDL_SetError ("Invalid zoom.");
+                return NULL;
+            }
+            double radians = angle * M_PI / 180.0;
+            double c = cos (radians);
+            double s = sin (radians);
+            int width = static_cast<int> (ceil ((fabs (src->w * c) + fabs (src->h * s)) * zoom - 1e-6));
+            int height = static_cast<int> (ceil ((fabs (src->w * s) + fabs (src->h * c)) * zoom - 1e-6));
+            if (width <= 0 || height <= 0) {
+                SDL_SetError ("Invalid transform size.");
+                return NULL;
+            }
+
+            Source source (src, true);
+            if (source.surface_ == NULL)
+                return NULL;
+            SDL_Surface* dst = create (source, width, height);
+            if (dst == NULL)
+                return NULL;
+            rotate (source.surface_, c / zoom, s / zoom, dst, filter != NEAREST);
+            return dst;
+        };
+
+        private:
+            /**
+             * @struct Source
+             * @brief A locked 32 bit view of a source surface, converted if needed.
+             */
+            struct Source {
+                /**
+                 * Prepares a source.
+                 *
+                 * @param src The surface.
+                 * @param alpha Whether or not an alpha channel is required.
+                 */
+                Source (SDL_Surface* src, bool alpha) : surface_ (src), original_ (src), converted_ (false) {
+                    SDL_PixelFormat* f = src->format;
+                    bool keyed = (src->flags & SDL_SRCCOLORKEY) != 0;
+                    if (f->BitsPerPixel == 32 && !keyed && (f->Amask != 0 || !alpha)) {
+                        if (SDL_MUSTLOCK (src) && SDL_LockSurface (src) == -1)
+                            surface_ = NULL;
+                        return;
+                    }
+
+                    SDL_Surface* like = SDL_CreateRGBSurface (SDL_SWSURFACE, 1, 1, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+                    if (like == NULL) {
+                        surface_ = NULL;
+                        return;
+                    }
+                    surface_ = SDL_ConvertSurface (src, like->format, SDL_SWSURFACE);
+                    SDL_FreeSurface (like);
+                    if (surface_ == NULL)
+                        return;
+                    converted_ = true;
+                    if (keyed) {
+                        Uint8 r, g, b;
+                        SDL_GetRGB (f->colorkey, f, &r, &g, &b);
+                        Uint32 key = (r << 16) | (g << 8) | b;
+                        for (int y = 0; y < surface_->h; ++y) {
+                            Uint32* row = reinterpret_cast<Uint32*> (static_cast<Uint8*> (surface_->pixels) + y * surface_->pitch);
+                            for (int x = 0; x < surface_->w; ++x)
+                                if ((row[x] & 0x00ffffff) == key)
+                                    row[x] = 0;
+                        }
+                    }
+                };
+
+                /**
+                 * Unlocks or frees the source.
+                 */
+                ~Source () {
+                    if (surface_ == NULL)
+                        return;
+                    if (converted_)
+                        SDL_FreeSurface (surface_);
+                    else if (SDL_MUSTLOCK (surface_))
+                        SDL_UnlockSurface (surface_);
+                };
+
+                /**
+                 * The 32 bit surface to read.
+                 */
+                SDL_Surface* surface_;
+
+                /**
+                 * The surface passed in.
+                 */
+                SDL_Surface* original_;
+
+                /**
+                 * Whether or not surface_ is a converted copy.
+                 */
+                bool converted_;
+            }; //Source
+
+            /**
+             * Creates a destination in the source's 32 bit format with the source's blending.
+             *
+             * @param source The source.
+             * @param width The width.
+             * @param height The height.
+             *
+             * @return The surface, NULL on failure.
+             */
+            static SDL_Surface* create (const Source& source, int width, int height) {
+                SDL_PixelFormat* f = source.surface_->format;
+                SDL_Surface* dst = SDL_CreateRGBSurface (SDL_SWSURFACE, width, height, 32, f->Rmask, f->Gmask, f->Bmask, f->Amask);
+                if (dst == NULL)
+                    return NULL;
+                if (source.converted_ || (source.original_->flags & SDL_SRCALPHA) != 0)
+                    SDL_SetAlpha (dst, SDL_SRCALPHA, source.converted_ ? SDL_ALPHA_OPAQUE : source.original_->format->alpha);
+                return dst;
+            };
+
+            /**
+             * Returns a row of a surface.
+             *
+             * @param surface The surface.
+             * @param y The row.
+             *
+             * @return The pixels of the row.
+             */
+            static Uint32* row (SDL_Surface* surface, int y) {
+                return reinterpret_cast<Uint32*> (static_cast<Uint8*> (surface->pixels) + y * surface->pitch);
+            };
+
+            /**
+             * Computes the sample positions of a bilinear axis.
+             *
+             * @param size The number of destination pixels.
+             * @param offset The first source pixel.
+             * @param length The number of source pixels.
+             * @param first Receives the first source index of each destination pixel.
+             * @param second Receives the second source index of each destination pixel.
+             * @param weight Receives the weight of the second index, 0 to 256.
+             */
+            static void axis (int size, int offset, int length, vector<int>& first, vector<int>& second, vector<int>& weight) {
+                first.resize (size);
+                second.resize (size);
+                weight.resize (size);
+                Sint32 step = (static_cast<Sint32> (length) << 16) / size;
+                Sint32 pos = step / 2 - 0x8000;
+                for (int i = 0; i < size; ++i, pos += step) {
+                    Sint32 p = max (pos, 0);
+                    int index = p >> 16;
+                    int w = (p >> 8) & 0xff;
+                    if (index >= length - 1) {
+                        index = max (length - 2, 0);
+                        w = length > 1 ? 256 : 0;
+                    }
+                    first[i] = offset + index;
+                    second[i] = offset + min (index + 1, length - 1);
+                    weight[i] = w;
+                }
+            };
+
+            /**
+             * Interpolates four pixels, every byte independently.
+             *
+             * @param p00 The top left pixel.
+             * @param p01 The top right pixel.
+             * @param p10 The bottom left pixel.
+             * @param p11 The bottom right pixel.
+             * @param wx The horizontal weight of the right pixels, 0 to 256.
+             * @param wy The vertical weight of the bottom pixels, 0 to 256.
+             *
+             * @return The interpolated pixel.
+             */
+            static Uint32 lerp (Uint32 p00, Uint32 p01, Uint32 p10, Uint32 p11, int wx, int wy) {
+#ifdef __SSE2__
+                __m128i zero = _mm_setzero_si128 ();
+                __m128i top = _mm_unpacklo_epi8 (_mm_unpacklo_epi32 (_mm_cvtsi32_si128 (p00), _mm_cvtsi32_si128 (p01)), zero);
+                __m128i bottom = _mm_unpacklo_epi8 (_mm_unpacklo_epi32 (_mm_cvtsi32_si128 (p10), _mm_cvtsi32_si128 (p11)), zero);
+                __m128i v = _mm_srli_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (top, _mm_set1_epi16 (256 - wy)),
+                                                           _mm_mullo_epi16 (bottom, _mm_set1_epi16 (wy))), 8);
+                __m128i h = _mm_mullo_epi16 (v, _mm_set_epi16 (wx, wx, wx, wx, 256 - wx, 256 - wx, 256 - wx, 256 - wx));
+                h = _mm_srli_epi16 (_mm_add_epi16 (h, _mm_srli_si128 (h, 8)), 8);
+                return _mm_cvtsi128_si32 (_mm_packus_epi16 (h, h));
+#else
+                Uint32 out = 0;
+                for (int shift = 0; shift < 32; shift += 8) {
+                    Uint32 left = (((p00 >> shift) & 0xff) * (256 - wy) + ((p10 >> shift) & 0xff) * wy) >> 8;
+                    Uint32 right = (((p01 >> shift) & 0xff) * (256 - wy) + ((p11 >> shift) & 0xff) * wy) >> 8;
+                    out |= ((left * (256 - wx) + right * wx) >> 8) << shift;
+                }
+                return out;
+#endif
+            };
+
+            /**
+             * Scales with the nearest filter.
+             *
+             * @param src The 32 bit source.
+             * @param area The area of the source.
+             * @param dst The destination.
+             */
+            static void nearest (SDL_Surface* src, const SDL_Rect& area, SDL_Surface* dst) {
+                vector<int> columns (dst->w);
+                Uint32 stepX = (static_cast<Uint32> (area.w) << 16) / dst->w;
+                Uint32 pos = stepX / 2;
+                for (int x = 0; x < dst->w; ++x, pos += stepX)
+                    columns[x] = area.x + (pos >> 16);
+
+                Uint32 stepY = (static_cast<Uint32> (area.h) << 16) / dst->h;
+                pos = stepY / 2;
+                for (int y = 0; y < dst->h; ++y, pos += stepY) {
+                    const Uint32* in = row (src, area.y + (pos >> 16));
+                    Uint32* out = row (dst, y);
+                    for (int x = 0; x < dst->w; ++x)
+                        out[x] = in[columns[x]];
+                }
+            };
+
+            /**
+             * Scales with the bilinear filter.
+             *
+             * @param src The 32 bit source.
+             * @param area The area of the source.
+             * @param dst The destination.
+             */
+            static void bilinear (SDL_Surface* src, const SDL_Rect& area, SDL_Surface* dst) {
+                vector<int> x0, x1, wx, y0, y1, wy;
+                axis (dst->w, area.x, area.w, x0, x1, wx);
+                axis (dst->h, area.y, area.h, y0, y1, wy);
+                for (int y = 0; y < dst->h; ++y) {
+                    const Uint32* top = row (src, y0[y]);
+                    const Uint32* bottom = row (src, y1[y]);
+                    Uint32* out = row (dst, y);
+                    for (int x = 0; x < dst->w; ++x)
+                        out[x] = lerp (top[x0[x]], top[x1[x]], bottom[x0[x]], bottom[x1[x]], wx[x], wy[y]);
+                }
+            };
+
+            /**
+             * Scales with the box filter.
+             *
+             * @param src The 32 bit source.
+             * @param area The area of the source.
+             * @param dst The destination.
+             */
+            static void box (SDL_Surface* src, const SDL_Rect& area, SDL_Surface* dst) {
+                vector<int> columns (dst->w + 1);
+                for (int x = 0; x <= dst->w; ++x)
+                    columns[x] = area.x + static_cast<int> (static_cast<Sint64> (x) * area.w / dst->w);
+
+                for (int y = 0; y < dst->h; ++y) {
+                    int top = area.y + static_cast<int> (static_cast<Sint64> (y) * area.h / dst->h);
+                    int bottom = max (area.y + static_cast<int> (static_cast<Sint64> (y + 1) * area.h / dst->h), top + 1);
+                    Uint32* out = row (dst, y);
+                    for (int x = 0; x < dst->w; ++x) {
+                        int left = columns[x];
+                        int right = max (columns[x + 1], left + 1);
+                        Uint32 sum[4];
+#ifdef __SSE2__
+                        __m128i zero = _mm_setzero_si128 ();
+                        __m128i acc = zero;
+                        for (int sy = top; sy < bottom; ++sy) {
+                            const Uint32* in = row (src, sy);
+                            for (int sx = left; sx < right; ++sx)
+                                acc = _mm_add_epi32 (acc, _mm_unpacklo_epi16 (_mm_unpacklo_epi8 (_mm_cvtsi32_si128 (in[sx]), zero), zero));
+                        }
+                        _mm_storeu_si128 (reinterpret_cast<__m128i*> (sum), acc);
+#else
+                        sum[0] = sum[1] = sum[2] = sum[3] = 0;
+                        for (int sy = top; sy < bottom; ++sy) {
+                            const Uint32* in = row (src, sy);
+                            for (int sx = left; sx < right; ++sx)
+                                for (int c = 0; c < 4; ++c)
+                                    sum[c] += (in[sx] >> (c * 8)) & 0xff;
+                        }
+#endif
+                        Uint32 count = (bottom - top) * (right - left);
+                        Uint32 pixel = 0;
+                        for (int c = 0; c < 4; ++c)
+                            pixel |= ((sum[c] + count / 2) / count) << (c * 8);
+                        out[x] = pixel;
+                    }
+                }
+            };
+
+            /**
+             * Rotates and zooms by inverse mapping every destination pixel into the source.
+             *
+             * @param src The 32 bit source with an alpha channel.
+             * @param c The cosine of the angle divided by the zoom.
+             * @param s The sine of the angle divided by the zoom.
+             * @param dst The destination.
+             * @param filtered Whether to sample bilinearly rather than take the nearest pixel.
+             */
+            static void rotate (SDL_Surface* src, double c, double s, SDL_Surface* dst, bool filtered) {
+                Sint32 dux = static_cast<Sint32> (c * 65536.0);
+                Sint32 dvx = static_cast<Sint32> (s * 65536.0);
+                Sint32 width = src->w << 16;
+                Sint32 height = src->h << 16;
+                for (int y = 0; y < dst->h; ++y) {
+                    double dx = 0.5 - dst->w / 2.0;
+                    double dy = y + 0.5 - dst->h / 2.0;
+                    Sint32 u = static_cast<Sint32> (floor (((dx * c - dy * s) + src->w / 2.0) * 65536.0));
+                    Sint32 v = static_cast<Sint32> (floor (((dx * s + dy * c) + src->h / 2.0) * 65536.0));
+                    Uint32* out = row (dst, y);
+                    for (int x = 0; x < dst->w; ++x, u += dux, v += dvx) {
+                        if (u < 0 || v < 0 || u >= width || v >= height) {
+                            out[x] = 0;
+                            continue;
+                        }
+                        if (!filtered) {
+                            out[x] = row (src, v >> 16)[u >> 16];
+                            continue;
+                        }
+                        Sint32 pu = max (u - 0x8000, 0);
+                        Sint32 pv = max (v - 0x8000, 0);
+                        int x0 = pu >> 16;
+                        int y0 = pv >> 16;
+                        int x1 = min (x0 + 1, src->w - 1);
+                        const Uint32* top = row (src, y0);
+                        const Uint32* bottom = row (src, min (y0 + 1, src->h - 1));
+                        out[x] = lerp (top[x0], top[x1], bottom[x0], bottom[x1], (pu >> 8) & 0xff, (pv >> 8) & 0xff);
+                    }
+                }
+            };
+    }; //Scaler
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_SCALER_H
@@ -0,0 +1,263 @@
+/**
+ * @file Snapshot.h
+ * Contains the Snapshot class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_SNAPSHOT_H
+#define SDL_VIDEO_SNAPSHOT_H
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <SDL.h>
+
+#include "sdlpp/video/Surface.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+
+    /**
+     * @class Snapshot
+     * @brief An in-memory copy of a frame, for comparing rendering against golden images.
+     *
+     * Pixels are kept as 0x00RRGGBB whatever the format of the captured Surface, so a frame
+     * rendered to a 16 bit display compares against one rendered to a 32 bit display after the
+     * format's own rounding. Alpha is not kept, the display has none and bitmaps cannot store it.
+     * Capturing again at the same size reuses the buffer, so a frame can be captured every
+     * iteration of a benchmark without allocating.
+     */
+    class Snapshot {
+        public:
+            /**
+             * Constructs an empty Snapshot.
+             */
+            Snapshot () : width_ (0), height_ (0), pixels_ () {};
+
+            /**
+             * Constructs a Snapshot of a Surface, typically the display Surface.
+             *
+             * @param surface The Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to read the Surface.
+             */
+            explicit Snapshot (const Surface& surface) : width_ (0), height_ (0), pixels_ () { capture (surface); };
+
+            /**
+             * Constructs a Snapshot from a bitmap, typically a golden image.
+             *
+             * @param fileName The name of the file.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to load the bitmap.
+             */
+            explicit Snapshot (const string& fileName) : width_ (0), height_ (0), pixels_ () { capture (Surface (fileName)); };
+
+            /**
+             * Captures a Surface, replacing the previous contents.
+             *
+             * @param surface The Surface.
+             *
+             * @return A reference to this Snapshot.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to read the Surface.
+             */
+            Snapshot& capture (const Surface& surface) {
+                SDL_Surface* s = surface.to_c ();
+                width_ = s->w;
+                height_ = s->h;
+                pixels_.resize (width_ * height_);
+                if (pixels_.empty ())
+                    return *this;
+
+                SDL_Surface* rgb = SDL_CreateRGBSurfaceFrom (&pixels_[0], width_, height_, 32, width_ * 4, 0x00ff0000, 0x0000ff00, 0x000000ff, 0);
+                if (rgb == NULL)
+                    throw runtime_error (SDL_GetError ());
+                Surface holder (rgb);
+
+                //copy the pixels as they are rather than blending or keying them.
+                Uint32 flags = s->flags;
+                Uint8 alpha = s->format->alpha;
+                Uint32 key = s->format->colorkey;
+                if ((flags & SDL_SRCALPHA) != 0)
+                    SDL_SetAlpha (s, 0, alpha);
+                if ((flags & SDL_SRCCOLORKEY) != 0)
+                    SDL_SetColorKey (s, 0, key);
+                int result = SDL_BlitSurface (s, NULL, rgb, NULL);
+                if ((flags & SDL_SRCCOLORKEY) != 0)
+                    SDL_SetColorKey (s, flags & (SDL_SRCCOLORKEY | SDL_RLEACCELOK), key);
+                if ((flags & SDL_SRCALPHA) != 0)
+                    SDL_SetAlpha (s, flags & (SDL_SRCALPHA | SDL_RLEACCEL), alpha);
+                if (result == -1)
+                    throw runtime_error (SDL_GetError ());
+
+                for (vector<Uint32>::iterator p = pixels_.begin (); p != pixels_.end (); ++p)
+                    *p &= 0x00ffffff;
+                return *this;
+            };
+
+            /**
+             * Counts the pixels that differ from another Snapshot.
+             *
+             * @param golden The Snapshot to compare against.
+             * @param tolerance The largest difference of a color channel still considered equal.
+             *
+             * @return The number of differing pixels, every pixel of the larger Snapshot if the sizes differ.
+             */
+            unsigned int differences (const Snapshot& golden, Uint8 tolerance = 0) const {
+                if (width_ != golden.width_ || height_ != golden.height_)
+                    return max (pixels_.size (), golden.pixels_.size ());
+                unsigned int count = 0;
+                for (size_t i = 0; i < pixels_.size (); ++i) {
+                    Uint32 a = pixels_[i];
+                    Uint32 b = golden.pixels_[i];
+                    if (a == b)
+                        continue;
+                    if (tolerance == 0
+                        || delta (a >> 16, b >> 16) > tolerance
+                        || delta (a >> 8, b >> 8) > tolerance
+                        || delta (a, b) > tolerance)
+                        ++count;
+                }
+                return count;
+            };
+
+            /**
+             * Determines if the Snapshot matches another.
+             *
+             * @param golden The Snapshot to compare against.
+             * @param tolerance The largest difference of a color channel still considered equal.
+             * @param allowed The number of pixels allowed to differ.
+             *
+             * @return True if at most allowed pixels differ, false otherwise.
+             */
+            bool matches (const Snapshot& golden, Uint8 tolerance = 0, unsigned int allowed = 0) const {
+                return differences (golden, tolerance) <= allowed;
+            };
+
+            /**
+             * Returns a 64 bit FNV-1a hash of the size and pixels, to compare frames against
+             * recorded values without keeping the images.
+             *
+             * @return The hash.
+             */
+            Uint64 checksum () const {
+                Uint64 hash = 14695981039346656037ULL;
+                hash = (hash ^ static_cast<Uint32> (width_)) * 1099511628211ULL;
+                hash = (hash ^ static_cast<Uint32> (height_)) * 1099511628211ULL;
+                for (vector<Uint32>::const_iterator p = pixels_.begin (); p != pixels_.end (); ++p)
+                    hash = (hash ^ *p) * 1099511628211ULL;
+                return hash;
+            };
+
+            /**
+             * Returns a pixel.
+             *
+             * @param x The column.
+             * @param y The row.
+             *
+             * @return The pixel as 0x00RRGGBB.
+             */
+            Uint32 pixel (int x, int y) const { return pixels_[y * width_ + x]; };
+
+            /**
+             * Returns the pixels, row by row without padding.
+             *
+             * @return The pixels as 0x00RRGGBB.
+             */
+            const vector<Uint32>& pixels () const { return pixels_; };
+
+            /**
+             * Returns the width.
+             *
+             * @return The width.
+             */
+            int width () const { return width_; };
+
+            /**
+             * Returns the height.
+             *
+             * @return The height.
+             */
+            int height () const { return height_; };
+
+            /**
+             * Copies the Snapshot into a new 32 bit Surface.
+             *
+             * @return The Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create the Surface.
+             */
+            Surface surface () const {
+                Surface copy (SDL_CreateRGBSurface (SDL_SWSURFACE, width_, height_, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0));
+                SDL_Surface* s = copy.to_c ();
+                for (int y = 0; y < height_; ++y)
+                    memcpy (static_cast<Uint8*> (s->pixels) + y * s->pitch, &pixels_[y * width_], width_ * 4);
+                return copy;
+            };
+
+            /**
+             * Saves the Snapshot as a bitmap, typically to record a golden image.
+             *
+             * @param fileName The name of the file.
+             *
+             * @return True if successful, false otherwise.
+             */
+            bool save (const string& fileName) const {
+                try {
+                    return surface ().save (fileName);
+                } catch (const runtime_error&) {
+                    return false;
+                }
+            };
+
+        private:
+            /**
+             * Returns the difference of the low bytes of two values.
+             *
+             * @param a The first value.
+             * @param b The second value.
+             *
+             * @return The absolute difference.
+             */
+            static int delta (Uint32 a, Uint32 b) {
+                int d = static_cast<int> (a & 0xff) - static_cast<int> (b & 0xff);
+                return d < 0 ? -d : d;
+            };
+
+            /**
+             * The width.
+             */
+            int width_;
+
+            /**
+             * The height.
+             */
+            int height_;
+
+            /**
+             * The pixels as 0x00RRGGBB.
+             */
+            vector<Uint32> pixels_;
+    }; //Snapshot
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_SNAPSHOT_H
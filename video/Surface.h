@@ -30,6 +30,7 @@
 
 #include "sdlpp/misc/Rect.h"
 #include "sdlpp/misc/Color.h"
+#include "sdlpp/video/Scaler.h"
 
 namespace sdl {
 namespace video {
@@ -64,6 +65,19 @@ namespace video {
                     throw runtime_error (SDL_GetError ());
             };
 
+            /**
+             * Constructs a Surface sharing ownership of a SDL_Surface structure. Used when the
+             * SDL_Surface needs a deleter that releases more than the structure itself.
+             *
+             * @param surface The shared SDL_Surface structure.
+             *
+             * @throw runtime_error Throws a runtime_error if surface is NULL.
+             */
+            explicit Surface (const boost::shared_ptr<SDL_Surface>& surface) : surface_ (surface) {
+                if (surface_ == NULL)
+                    throw runtime_error (SDL_GetError ());
+            };
+
             /**
              * Constructs a Surface from a file.
              *
@@ -87,7 +101,7 @@ namespace video {
              * @throw runtime_error Throws a runtime_error if unable to set video mode.
              */
             Surface (int height, int width, int bpp, unsigned int flags)
-              : surface_ (SDL_SetVideoMode (height, width, bpp, flags)) {
+              : surface_ (SDL_SetVideoMode (height, width, bpp, flags), &SDL_FreeSurface) {
                 if (surface_ == NULL)
                     throw runtime_error (SDL_GetError ());
             };
@@ -98,13 +112,13 @@ namespace video {
              * @param flags The SDL Surface flags.
              * @param rect A rectangle with the height and width.
              * @param bpp The number of bits per pixel.
-             * @param mask The color mask.
+             * @param masks The channel masks.
              *
              * @throw runtime_error Throws a runtime_error if unable to create RGB surface.
              */
-            Surface (Uint32 flags, const Rect& rect, int bpp, const Color& mask)
+            Surface (Uint32 flags, const Rect& rect, int bpp, const Masks& masks)
               : surface_ (SDL_CreateRGBSurface (flags, rect.width (), rect.height (), bpp, 
-                                                mask.red (), mask.green (), mask.blue (), mask.alpha ()), 
+                                                masks.red_, masks.green_, masks.blue_, masks.alpha_), 
                                                 &SDL_FreeSurface) {
                 if (surface_ == NULL)
                     throw runtime_error (SDL_GetError ());
@@ -117,13 +131,13 @@ namespace video {
              * @param rect A rectangle with the height and width.
              * @param bpp The number of bits per pixel.
              * @param pitch The size of the scanline in bytes, width in pixels * bytes per pixel.
-             * @param mask The color mask.
+             * @param masks The channel masks.
              *
              * @throw runtime_error Throws a runtime_error if unable to create RGB surface.
              */
-            Surface (void *pixels, const Rect& rect, int bpp, int pitch, const Color& mask)
+            Surface (void *pixels, const Rect& rect, int bpp, int pitch, const Masks& masks)
               : surface_ (SDL_CreateRGBSurfaceFrom (pixels, rect.width (), rect.height (), bpp, pitch, 
-                                                    mask.red (), mask.green (), mask.blue (), mask.alpha ()), 
+                                                    masks.red_, masks.green_, masks.blue_, masks.alpha_), 
                                                     &SDL_FreeSurface) {
                 if (surface_ == NULL)
                     throw runtime_error (SDL_GetError ());
@@ -156,6 +170,7 @@ namespace video {
 
             /**
              * Blits the source rectangle from one Surface onto the destination rectangle of this Surface.
+             * The width and height of the destination rectangle are ignored, see blitScaled.
              *
              * @param surface The Surface from which to blit.
              * @param srcRect The source rectangle.
@@ -181,6 +196,95 @@ namespace video {
                 return *this;
             };
 
+            /**
+             * Blits the source rectangle from one Surface onto this Surface, scaled to the size of the destination rectangle.
+             * The scaled copy is made on every call, see ScaleCache to reuse it.
+             *
+             * @param surface The Surface from which to blit.
+             * @param srcRect The source rectangle.
+             * @param dstRect The destination rectangle.
+             * @param filter The filter used to scale.
+             *
+             * @return A reference to this Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to scale or blit.
+             */
+            Surface& blitScaled (const Surface& surface, const Rect& srcRect, const Rect& dstRect, Scaler::Filter filter = Scaler::BILINEAR) {
+                SDL_Rect src;
+                src.w = srcRect.width ();
+                src.h = srcRect.height ();
+                src.x = srcRect.x ();
+                src.y = srcRect.y ();
+                SDL_Rect dst;
+                dst.w = dstRect.width ();
+                dst.h = dstRect.height ();
+                dst.x = dstRect.x ();
+                dst.y = dstRect.y ();
+                if (src.w == dst.w && src.h == dst.h) {
+                    if (SDL_BlitSurface (surface.to_c (), &src, surface_.get (), &dst) == -1)
+                        throw runtime_error (SDL_GetError ());
+                    return *this;
+                }
+                Surface scaled (Scaler::scale (surface.to_c (), &src, dst.w, dst.h, filter));
+                if (SDL_BlitSurface (scaled.to_c (), NULL, surface_.get (), &dst) == -1)
+                    throw runtime_error (SDL_GetError ());
+                return *this;
+            };
+
+            /**
+             * Blits a Surface onto this Surface rotated and zoomed about its center.
+             *
+             * @param surface The Surface from which to blit.
+             * @param x The x offset of the center on this Surface.
+             * @param y The y offset of the center on this Surface.
+             * @param angle The counterclockwise rotation in degrees.
+             * @param zoom The scale factor.
+             * @param filter The filter used to sample.
+             *
+             * @return A reference to this Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to transform or blit.
+             */
+            Surface& blitTransformed (const Surface& surface, short x, short y, double angle, double zoom = 1.0, Scaler::Filter filter = Scaler::BILINEAR) {
+                Surface transformed (surface.transformed (angle, zoom, filter));
+                SDL_Rect dst;
+                dst.x = x - transformed.width () / 2;
+                dst.y = y - transformed.height () / 2;
+                if (SDL_BlitSurface (transformed.to_c (), NULL, surface_.get (), &dst) == -1)
+                    throw runtime_error (SDL_GetError ());
+                return *this;
+            };
+
+            /**
+             * Returns a scaled copy of the Surface.
+             *
+             * @param width The width of the copy.
+             * @param height The height of the copy.
+             * @param filter The filter used to scale.
+             *
+             * @return The scaled Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to scale.
+             */
+            Surface scaled (int width, int height, Scaler::Filter filter = Scaler::BILINEAR) const {
+                return Surface (Scaler::scale (surface_.get (), NULL, width, height, filter));
+            };
+
+            /**
+             * Returns a copy of the Surface rotated and zoomed about its center, transparent outside of the rotated area.
+             *
+             * @param angle The counterclockwise rotation in degrees.
+             * @param zoom The scale factor.
+             * @param filter The filter used to sample.
+             *
+             * @return The transformed Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to transform.
+             */
+            Surface transformed (double angle, double zoom = 1.0, Scaler::Filter filter = Scaler::BILINEAR) const {
+                return Surface (Scaler::transform (surface_.get (), angle, zoom, filter));
+            };
+
             /**
              * Returns the height.
              * 
@@ -215,14 +319,174 @@ namespace video {
             void unlock () { SDL_UnlockSurface (surface_.get ()); };
 
             /**
-             * Save the Surface to the named file.
+             * Shows the display Surface, swapping buffers if double buffered and updating the whole screen otherwise.
+             *
+             * @return True if successful, false otherwise.
+             */
+            bool flip () { return SDL_Flip (surface_.get ()) == 0; };
+
+            /**
+             * Sets the color key, the pixel value left out of blits.
+             *
+             * @param key The pixel value, as returned by SDL_MapRGB for this Surface's format.
+             * @param rle Whether or not to run-length encode the Surface so blits skip transparent runs.
+             *
+             * @return A reference to this Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to set the color key.
+             */
+            Surface& colorKey (Uint32 key, bool rle = false) {
+                if (SDL_SetColorKey (surface_.get (), SDL_SRCCOLORKEY | (rle ? SDL_RLEACCEL : 0), key) == -1)
+                    throw runtime_error (SDL_GetError ());
+                return *this;
+            };
+
+            /**
+             * Sets the color key, the color left out of blits.
+             *
+             * @param color The color, mapped to this Surface's format.
+             * @param rle Whether or not to run-length encode the Surface so blits skip transparent runs.
+             *
+             * @return A reference to this Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to set the color key.
+             */
+            Surface& colorKey (const Color& color, bool rle = false) {
+                return colorKey (SDL_MapRGB (surface_->format, color.red (), color.green (), color.blue ()), rle);
+            };
+
+            /**
+             * Returns the color key.
+             *
+             * @return The pixel value of the color key, only meaningful if hasColorKey returns true.
+             */
+            Uint32 colorKey () const { return surface_->format->colorkey; };
+
+            /**
+             * Returns whether or not a color key is set.
+             *
+             * @return True if a color key is set, false otherwise.
+             */
+            bool hasColorKey () const { return (surface_->flags & SDL_SRCCOLORKEY) != 0; };
+
+            /**
+             * Removes the color key.
+             *
+             * @return A reference to this Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to remove the color key.
+             */
+            Surface& clearColorKey () {
+                if (SDL_SetColorKey (surface_.get (), 0, 0) == -1)
+                    throw runtime_error (SDL_GetError ());
+                return *this;
+            };
+
+            /**
+             * Enables alpha blending. Surfaces with an alpha channel blend per pixel, others blend
+             * every pixel with the given alpha.
+             *
+             * @param alpha The alpha of the whole Surface, ignored if the Surface has an alpha channel.
+             * @param rle Whether or not to run-length encode the Surface so blits skip transparent runs.
+             *
+             * @return A reference to this Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to set the alpha.
+             */
+            Surface& alpha (Uint8 alpha, bool rle = false) {
+                if (SDL_SetAlpha (surface_.get (), SDL_SRCALPHA | (rle ? SDL_RLEACCEL : 0), alpha) == -1)
+                    throw runtime_error (SDL_GetError ());
+                return *this;
+            };
+
+            /**
+             * Returns the alpha of the whole Surface.
+             *
+             * @return The alpha.
+             */
+            Uint8 alpha () const { return surface_->format->alpha; };
+
+            /**
+             * Returns whether or not alpha blending is enabled.
+             *
+             * @return True if enabled, false otherwise.
+             */
+            bool hasAlpha () const { return (surface_->flags & SDL_SRCALPHA) != 0; };
+
+            /**
+             * Disables alpha blending, blits then copy the pixels including any alpha channel.
+             *
+             * @return A reference to this Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to disable alpha blending.
+             */
+            Surface& clearAlpha () {
+                if (SDL_SetAlpha (surface_.get (), 0, surface_->format->alpha) == -1)
+                    throw runtime_error (SDL_GetError ());
+                return *this;
+            };
+
+            /**
+             * Enables or disables run-length encoding, keeping the color key and alpha settings. SDL
+             * encodes the Surface on its next blit, after which it must be locked to touch the pixels.
+             *
+             * @param enabled Whether or not to run-length encode.
+             *
+             * @return A reference to this Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to change the encoding.
+             */
+            Surface& rle (bool enabled) {
+                SDL_Surface* s = surface_.get ();
+                Uint32 flag = enabled ? SDL_RLEACCEL : 0;
+                int result = 0;
+                if (s->flags & SDL_SRCCOLORKEY)
+                    result = SDL_SetColorKey (s, SDL_SRCCOLORKEY | flag, s->format->colorkey);
+                if (result == 0 && (s->flags & SDL_SRCALPHA))
+                    result = SDL_SetAlpha (s, SDL_SRCALPHA | flag, s->format->alpha);
+                if (result == 0 && (s->flags & (SDL_SRCCOLORKEY | SDL_SRCALPHA)) == 0)
+                    result = SDL_SetColorKey (s, flag, 0);
+                if (result == -1)
+                    throw runtime_error (SDL_GetError ());
+                return *this;
+            };
+
+            /**
+             * Returns whether or not run-length encoding is enabled.
+             *
+             * @return True if enabled, false otherwise.
+             */
+            bool rle () const { return (surface_->flags & (SDL_RLEACCELOK | SDL_RLEACCEL)) != 0; };
+
+            /**
+             * Save the Surface to the named file. Blocks while the bitmap is written, see
+             * SurfaceWriter for saving in the background.
              *
              * @param fileName The name of the file.
              *
              * @return True if successful, false otherwise.
              */
             bool save (const string& fileName) { return SDL_SaveBMP (surface_.get (), fileName.c_str ()) == 0; };
-             
+
+            /**
+             * Returns a copy of the Surface converted to the format of the current display surface.
+             *
+             * @return The converted Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to convert the Surface.
+             */
+            Surface displayFormat () const { return Surface (SDL_DisplayFormat (surface_.get ())); };
+
+            /**
+             * Returns a copy of the Surface converted to the format of the current display surface
+             * with an alpha channel added.
+             *
+             * @return The converted Surface.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to convert the Surface.
+             */
+            Surface displayFormatAlpha () const { return Surface (SDL_DisplayFormatAlpha (surface_.get ())); };
+
             /**
              * Exposes the underlying SDL_Surface structure.
              *
@@ -0,0 +1,409 @@
+/**
+ * @file SurfaceWriter.h
+ * Contains the SurfaceWriter and FrameCapture classes.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_SURFACEWRITER_H
+#define SDL_VIDEO_SURFACEWRITER_H
+
+#include <cstdio>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/video/Qoi.h"
+#include "sdlpp/thread/Mutex.h"
+#include "sdlpp/thread/Condition.h"
+#include "sdlpp/thread/ThreadPool.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace thread;
+
+    /**
+     * @class SurfaceWriter
+     * @brief Saves Surfaces on background threads.
+     *
+     * save copies the Surface, which is all the calling thread pays for, and queues the copy to be
+     * encoded and written by a worker. The memory held by queued copies is bounded, once the bound
+     * is reached save either waits for room or drops the request.
+     */
+    class SurfaceWriter {
+        public:
+            /**
+             * The file format to write.
+             */
+            enum Format {
+                /**
+                 * An uncompressed bitmap written by SDL_SaveBMP.
+                 */
+                BMP,
+
+                /**
+                 * A losslessly compressed QOI image.
+                 */
+                QOI
+            };
+
+            /**
+             * What to do when the in-flight bound is reached.
+             */
+            enum Policy {
+                /**
+                 * Wait for queued copies to be written.
+                 */
+                BLOCK,
+
+                /**
+                 * Drop the request.
+                 */
+                DROP
+            };
+
+            /**
+             * Constructs a SurfaceWriter.
+             *
+             * @param maxBytes The maximum number of bytes held by queued copies.
+             * @param policy What to do when the bound is reached.
+             * @param threads The number of worker threads.
+             */
+            explicit SurfaceWriter (size_t maxBytes = 64 << 20, Policy policy = BLOCK, unsigned int threads = 2)
+              : mutex_ (), room_ (), maxBytes_ (maxBytes), inFlight_ (0), policy_ (policy),
+                written_ (0), dropped_ (0), failed_ (0), pool_ (threads) {};
+
+            /**
+             * Writes the queued copies and stops the worker threads.
+             */
+            ~SurfaceWriter () {};
+
+            /**
+             * Queues a Surface to be saved.
+             *
+             * @param surface The Surface to save. It may be drawn on again as soon as save returns.
+             * @param fileName The name of the file.
+             * @param format The file format.
+             *
+             * @return True if queued, false if dropped.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to copy the Surface.
+             */
+            bool save (const Surface& surface, const string& fileName, Format format = BMP) {
+                SDL_Surface* s = surface.to_c ();
+                size_t bytes = static_cast<size_t> (s->pitch) * s->h;
+                {
+                    Lock lock (mutex_);
+                    while (inFlight_ != 0 && inFlight_ + bytes > maxBytes_) {
+                        if (policy_ == DROP) {
+                            ++dropped_;
+                            return false;
+                        }
+                        room_.wait (lock);
+                    }
+                    inFlight_ += bytes;
+                }
+
+                SDL_Surface* copy = SDL_ConvertSurface (s, s->format, SDL_SWSURFACE);
+                if (copy == NULL) {
+                    release (bytes);
+                    throw runtime_error (SDL_GetError ());
+                }
+                try {
+                    pool_.submit (boost::bind (&SurfaceWriter::write, this, Surface (copy), fileName, format, bytes));
+                } catch (...) {
+                    release (bytes);
+                    throw;
+                }
+                return true;
+            };
+
+            /**
+             * Waits until every queued copy has been written.
+             *
+             * @return A reference to this SurfaceWriter.
+             */
+            SurfaceWriter& flush () {
+                pool_.wait ();
+                return *this;
+            };
+
+            /**
+             * Returns the number of files written.
+             *
+             * @return The number of files written.
+             */
+            unsigned int written () {
+                Lock lock (mutex_);
+                return written_;
+            };
+
+            /**
+             * Returns the number of requests dropped because the in-flight bound was reached.
+             *
+             * @return The number of requests dropped.
+             */
+            unsigned int dropped () {
+                Lock lock (mutex_);
+                return dropped_;
+            };
+
+            /**
+             * Returns the number of files that could not be written.
+             *
+             * @return The number of failures.
+             */
+            unsigned int failed () {
+                Lock lock (mutex_);
+                return failed_;
+            };
+
+            /**
+             * Encodes a Surface as a QOI image.
+             *
+             * @param surface The Surface to encode.
+             * @param out Receives the encoded image.
+             *
+             * @return True if successful, false otherwise.
+             */
+            static bool encodeQoi (const Surface& surface, vector<Uint8>& out) {
+                SDL_Surface* s = surface.to_c ();
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+                SDL_Surface* rgba = SDL_CreateRGBSurface (SDL_SWSURFACE, s->w, s->h, 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+#else
+                SDL_Surface* rgba = SDL_CreateRGBSurface (SDL_SWSURFACE, s->w, s->h, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+#endif
+                if (rgba == NULL)
+                    return false;
+                Surface holder (rgba);
+
+                //copy rather than blend the alpha channel.
+                Uint32 flags = s->flags & (SDL_SRCALPHA | SDL_RLEACCEL);
+                Uint8 alpha = s->format->alpha;
+                SDL_SetAlpha (s, 0, alpha);
+                int result = SDL_BlitSurface (s, NULL, rgba, NULL);
+                SDL_SetAlpha (s, flags, alpha);
+                if (result == -1)
+                    return false;
+
+                Qoi::encode (static_cast<const Uint8*> (rgba->pixels), rgba->w, rgba->h, rgba->pitch,
+                             s->format->Amask != 0 ? 4 : 3, out);
+                return true;
+            };
+
+        private:
+            /**
+             * Copy constructs a SurfaceWriter.
+             *
+             * @param rhs The SurfaceWriter to copy.
+             */
+            SurfaceWriter (const SurfaceWriter& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The SurfaceWriter from which to assign.
+             *
+             * @return A reference to this SurfaceWriter.
+             */
+            SurfaceWriter& operator= (const SurfaceWriter& rhs);
+
+            /**
+             * Encodes and writes a copy on a worker thread.
+             *
+             * @param copy The copy of the Surface.
+             * @param fileName The name of the file.
+             * @param format The file format.
+             * @param bytes The number of in-flight bytes held by the copy.
+             */
+            void write (Surface copy, const string& fileName, Format format, size_t bytes) {
+                bool ok = false;
+                try {
+                    if (format == BMP)
+                        ok = copy.save (fileName);
+                    else {
+                        vector<Uint8> encoded;
+                        if (encodeQoi (copy, encoded)) {
+                            FILE* file = fopen (fileName.c_str (), "wb");
+                            if (file != NULL) {
+                                ok = fwrite (&encoded[0], encoded.size (), 1, file) == 1;
+                                ok = fclose (file) == 0 && ok;
+                            }
+                        }
+                    }
+                } catch (...) {
+                    //the bytes must be released whatever happens, or save could wait for them forever.
+                    ok = false;
+                }
+
+                Lock lock (mutex_);
+                if (ok)
+                    ++written_;
+                else
+                    ++failed_;
+                inFlight_ -= bytes;
+                room_.broadcast ();
+            };
+
+            /**
+             * Returns in-flight bytes that were never queued.
+             *
+             * @param bytes The number of bytes.
+             */
+            void release (size_t bytes) {
+                Lock lock (mutex_);
+                inFlight_ -= bytes;
+                room_.broadcast ();
+            };
+
+            /**
+             * Guards the counters.
+             */
+            Mutex mutex_;
+
+            /**
+             * Signaled when queued copies are written.
+             */
+            Condition room_;
+
+            /**
+             * The maximum number of bytes held by queued copies.
+             */
+            size_t maxBytes_;
+
+            /**
+             * The number of bytes held by queued copies.
+             */
+            size_t inFlight_;
+
+            /**
+             * What to do when the bound is reached.
+             */
+            Policy policy_;
+
+            /**
+             * The number of files written.
+             */
+            unsigned int written_;
+
+            /**
+             * The number of requests dropped.
+             */
+            unsigned int dropped_;
+
+            /**
+             * The number of files that could not be written.
+             */
+            unsigned int failed_;
+
+            /**
+             * The worker threads. Declared last so the workers stop before the state they use is destroyed.
+             */
+            ThreadPool pool_;
+    }; //SurfaceWriter
+
+    /**
+     * @class FrameCapture
+     * @brief Dumps a numbered sequence of frames through a SurfaceWriter.
+     *
+     * Frames are compressed as QOI on one worker per processor, which keeps up with 60 frames per
+     * second at typical window sizes. The in-flight bound defaults to half a second of frames,
+     * enough to ride out a slow disk without dropping.
+     */
+    class FrameCapture {
+        public:
+            /**
+             * Constructs a FrameCapture.
+             *
+             * @param prefix The prefix of the file names, frames are written as prefix000000.qoi and so on.
+             * @param frameBytes The size of one frame in bytes, pitch * height of the captured Surface.
+             * @param bufferedFrames The number of frames that may be in flight before capture blocks.
+             */
+            FrameCapture (const string& prefix, size_t frameBytes, unsigned int bufferedFrames = 30)
+              : prefix_ (prefix), frame_ (0), writer_ (frameBytes * bufferedFrames, SurfaceWriter::BLOCK, Thread::processors ()) {};
+
+            /**
+             * Captures a frame.
+             *
+             * @param surface The frame.
+             *
+             * @return A reference to this FrameCapture.
+             */
+            FrameCapture& capture (const Surface& surface) {
+                ostringstream name;
+                name << prefix_ << setw (6) << setfill ('0') << frame_++ << ".qoi";
+                writer_.save (surface, name.str (), SurfaceWriter::QOI);
+                return *this;
+            };
+
+            /**
+             * Returns the number of frames captured.
+             *
+             * @return The number of frames.
+             */
+            unsigned int frames () const { return frame_; };
+
+            /**
+             * Returns the SurfaceWriter writing the frames.
+             *
+             * @return The SurfaceWriter.
+             */
+            SurfaceWriter& writer () { return writer_; };
+
+        private:
+            /**
+             * Copy constructs a FrameCapture.
+             *
+             * @param rhs The FrameCapture to copy.
+             */
+            FrameCapture (const FrameCapture& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The FrameCapture from which to assign.
+             *
+             * @return A reference to this FrameCapture.
+             */
+            FrameCapture& operator= (const FrameCapture& rhs);
+
+            /**
+             * The prefix of the file names.
+             */
+            string prefix_;
+
+            /**
+             * The number of the next frame.
+             */
+            unsigned int frame_;
+
+            /**
+             * The SurfaceWriter writing the frames.
+             */
+            SurfaceWriter writer_;
+    }; //FrameCapture
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_SURFACEWRITER_H
@@ -0,0 +1,436 @@
+/**
+ * @file TiledCompositor.h
+ * Contains the TiledCompositor class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_TILEDCOMPOSITOR_H
+#define SDL_VIDEO_TILEDCOMPOSITOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/misc/Rect.h"
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/thread/ThreadPool.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace misc;
+    using namespace thread;
+
+    /**
+     * @class TiledCompositor
+     * @brief Executes queued fills and blits on a Surface split into tiles, one tile per task.
+     *
+     * Commands are clipped when queued exactly as SDL_BlitSurface and SDL_FillRect would clip them,
+     * then binned to every tile they touch. A tile runs its commands in the order they were queued
+     * and no two tiles share a pixel, so the result is byte-identical to running the commands one
+     * after another, whatever the number of threads.
+     *
+     * Surfaces that must be locked, hardware and RLE surfaces, cannot be blitted concurrently and
+     * are always composited serially. Fills are written directly rather than through SDL_FillRect,
+     * which locks the target and so cannot run on several tiles at once.
+     */
+    class TiledCompositor {
+        public:
+            /**
+             * Constructs a TiledCompositor.
+             *
+             * @param target The Surface onto which to composite.
+             * @param tileSize The width and height of a tile in pixels. 128 pixels of 32 bits keep a tile's rows in L2.
+             * @param threads The number of worker threads, 0 for one per processor.
+             */
+            explicit TiledCompositor (const Surface& target, int tileSize = 128, unsigned int threads = 0)
+              : target_ (target),
+                tileSize_ (tileSize),
+                columns_ ((target.to_c ()->w + tileSize - 1) / tileSize),
+                commands_ (),
+                sources_ (),
+                bins_ (columns_ * ((target.to_c ()->h + tileSize - 1) / tileSize)),
+                serial_ (false),
+                failed_ (false),
+                pool_ (threads) {};
+
+            /**
+             * Queues a fill.
+             *
+             * @param rect The rectangle to fill.
+             * @param color The pixel value, as returned by SDL_MapRGB for the target's format.
+             *
+             * @return A reference to this TiledCompositor.
+             */
+            TiledCompositor& fill (const Rect& rect, Uint32 color) {
+                Command command;
+                command.src_ = NULL;
+                command.color_ = color;
+                command.dst_ = clip (rect.x (), rect.y (), rect.width (), rect.height ());
+                command.srcX_ = command.srcY_ = 0;
+                push (command);
+                return *this;
+            };
+
+            /**
+             * Queues a fill of the whole target.
+             *
+             * @param color The pixel value.
+             *
+             * @return A reference to this TiledCompositor.
+             */
+            TiledCompositor& clear (Uint32 color) {
+                SDL_Surface* t = target_.to_c ();
+                return fill (Rect (t->h, t->w, 0, 0), color);
+            };
+
+            /**
+             * Queues a blit.
+             *
+             * @param src The Surface from which to blit.
+             * @param srcRect The source rectangle.
+             * @param x The x offset on the target.
+             * @param y The y offset on the target.
+             *
+             * @return A reference to this TiledCompositor.
+             */
+            TiledCompositor& blit (const Surface& src, const Rect& srcRect, int x, int y) {
+                SDL_Surface* s = src.to_c ();
+                int sx = srcRect.x ();
+                int sy = srcRect.y ();
+                int w = srcRect.width ();
+                int h = srcRect.height ();
+
+                //clip against the source as SDL_UpperBlit does.
+                if (sx < 0) {
+                    w += sx;
+                    x -= sx;
+                    sx = 0;
+                }
+                if (sy < 0) {
+                    h += sy;
+                    y -= sy;
+                    sy = 0;
+                }
+                w = min (w, s->w - sx);
+                h = min (h, s->h - sy);
+
+                Command command;
+                command.src_ = s;
+                command.color_ = 0;
+                command.dst_ = clip (x, y, w, h);
+                command.srcX_ = sx + (command.dst_.x_ - x);
+                command.srcY_ = sy + (command.dst_.y_ - y);
+                if (SDL_MUSTLOCK (s))
+                    serial_ = true;
+                sources_.push_back (src);
+                push (command);
+                return *this;
+            };
+
+            /**
+             * Executes and discards the queued commands.
+             *
+             * @param parallel Whether or not to execute the tiles on the worker threads.
+             *
+             * @return A reference to this TiledCompositor.
+             *
+             * @throw runtime_error Throws a runtime_error if a blit fails.
+             */
+            TiledCompositor& flush (bool parallel = true) {
+                SDL_Surface* t = target_.to_c ();
+                if (!parallel || serial_ || SDL_MUSTLOCK (t) || pool_.size () < 2) {
+                    Area all = { 0, 0, t->w, t->h };
+                    for (size_t i = 0; i < commands_.size (); ++i)
+                        execute (commands_[i], all);
+                } else {
+                    //SDL_LowerBlit maps a source to its destination format on first use, do that here
+                    //rather than racing on it in the workers.
+                    for (vector<Surface>::iterator cur = sources_.begin (); cur != sources_.end (); ++cur) {
+                        SDL_Rect empty = { 0, 0, 0, 0 };
+                        SDL_LowerBlit (cur->to_c (), &empty, t, &empty);
+                    }
+                    failed_ = false;
+                    pool_.forEach (bins_.size (), boost::bind (&TiledCompositor::tile, this, boost::placeholders::_1));
+                    if (failed_) {
+                        reset ();
+                        throw runtime_error ("Failed to composite a tile.");
+                    }
+                }
+                reset ();
+                return *this;
+            };
+
+            /**
+             * Discards the queued commands.
+             *
+             * @return A reference to this TiledCompositor.
+             */
+            TiledCompositor& reset () {
+                commands_.clear ();
+                sources_.clear ();
+                for (vector<vector<size_t> >::iterator cur = bins_.begin (); cur != bins_.end (); ++cur)
+                    cur->clear ();
+                serial_ = false;
+                return *this;
+            };
+
+            /**
+             * Returns the number of worker threads.
+             *
+             * @return The number of worker threads.
+             */
+            size_t threads () const { return pool_.size (); };
+
+        private:
+            /**
+             * Copy constructs a TiledCompositor.
+             *
+             * @param rhs The TiledCompositor to copy.
+             */
+            TiledCompositor (const TiledCompositor& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The TiledCompositor from which to assign.
+             *
+             * @return A reference to this TiledCompositor.
+             */
+            TiledCompositor& operator= (const TiledCompositor& rhs);
+
+            /**
+             * @struct Area
+             * @brief A rectangle without SDL_Rect's 16 bit limits.
+             */
+            struct Area {
+                /**
+                 * The offset and size.
+                 */
+                int x_, y_, w_, h_;
+            }; //Area
+
+            /**
+             * @struct Command
+             * @brief A clipped fill or blit.
+             */
+            struct Command {
+                /**
+                 * The source of a blit, NULL for a fill.
+                 */
+                SDL_Surface* src_;
+
+                /**
+                 * The fill pixel value.
+                 */
+                Uint32 color_;
+
+                /**
+                 * The clipped destination.
+                 */
+                Area dst_;
+
+                /**
+                 * The source offset matching the clipped destination.
+                 */
+                int srcX_, srcY_;
+            }; //Command
+
+            /**
+             * Clips a destination against the target's clip rectangle.
+             *
+             * @param x The x offset.
+             * @param y The y offset.
+             * @param w The width.
+             * @param h The height.
+             *
+             * @return The clipped destination, empty if nothing is left.
+             */
+            Area clip (int x, int y, int w, int h) const {
+                const SDL_Rect& c = target_.to_c ()->clip_rect;
+                int x0 = max (x, static_cast<int> (c.x));
+                int y0 = max (y, static_cast<int> (c.y));
+                int x1 = min (x + w, c.x + c.w);
+                int y1 = min (y + h, c.y + c.h);
+                Area a = { x0, y0, max (x1 - x0, 0), max (y1 - y0, 0) };
+                return a;
+            };
+
+            /**
+             * Queues a clipped command and bins it to the tiles it touches.
+             *
+             * @param command The command.
+             */
+            void push (const Command& command) {
+                if (command.dst_.w_ == 0 || command.dst_.h_ == 0)
+                    return;
+                size_t index = commands_.size ();
+                commands_.push_back (command);
+                int tx1 = (command.dst_.x_ + command.dst_.w_ - 1) / tileSize_;
+                int ty1 = (command.dst_.y_ + command.dst_.h_ - 1) / tileSize_;
+                for (int ty = command.dst_.y_ / tileSize_; ty <= ty1; ++ty)
+                    for (int tx = command.dst_.x_ / tileSize_; tx <= tx1; ++tx)
+                        bins_[ty * columns_ + tx].push_back (index);
+            };
+
+            /**
+             * Executes the commands binned to a tile.
+             *
+             * @param index The index of the tile.
+             */
+            void tile (size_t index) {
+                Area area = { static_cast<int> (index % columns_) * tileSize_, static_cast<int> (index / columns_) * tileSize_, tileSize_, tileSize_ };
+                const vector<size_t>& bin = bins_[index];
+                try {
+                    for (size_t i = 0; i < bin.size (); ++i)
+                        execute (commands_[bin[i]], area);
+                } catch (const exception& e) {
+                    failed_ = true;
+                }
+            };
+
+            /**
+             * Executes the part of a command that falls within an area.
+             *
+             * @param command The command.
+             * @param area The area.
+             *
+             * @throw runtime_error Throws a runtime_error if the blit fails.
+             */
+            void execute (const Command& command, const Area& area) {
+                int x0 = max (command.dst_.x_, area.x_);
+                int y0 = max (command.dst_.y_, area.y_);
+                int x1 = min (command.dst_.x_ + command.dst_.w_, area.x_ + area.w_);
+                int y1 = min (command.dst_.y_ + command.dst_.h_, area.y_ + area.h_);
+                if (x1 <= x0 || y1 <= y0)
+                    return;
+
+                SDL_Rect dst;
+                dst.x = x0;
+                dst.y = y0;
+                dst.w = x1 - x0;
+                dst.h = y1 - y0;
+                if (command.src_ == NULL) {
+                    //SDL_FillRect locks the target, which is not thread safe, so fill directly when it need not be locked.
+                    if (SDL_MUSTLOCK (target_.to_c ()))
+                        SDL_FillRect (target_.to_c (), &dst, command.color_);
+                    else
+                        fill (target_.to_c (), dst, command.color_);
+                    return;
+                }
+                SDL_Rect src;
+                src.x = command.srcX_ + (x0 - command.dst_.x_);
+                src.y = command.srcY_ + (y0 - command.dst_.y_);
+                src.w = dst.w;
+                src.h = dst.h;
+                if (SDL_LowerBlit (command.src_, &src, target_.to_c (), &dst) == -1)
+                    throw runtime_error (SDL_GetError ());
+            };
+
+            /**
+             * Fills a rectangle of a Surface that need not be locked, writing the same bytes as SDL_FillRect.
+             *
+             * @param surface The Surface.
+             * @param rect The rectangle, already clipped to the Surface.
+             * @param color The pixel value in the Surface's format.
+             */
+            static void fill (SDL_Surface* surface, const SDL_Rect& rect, Uint32 color) {
+                int bytes = surface->format->BytesPerPixel;
+                Uint8* row = static_cast<Uint8*> (surface->pixels) + rect.y * surface->pitch + rect.x * bytes;
+                for (int y = 0; y < rect.h; ++y, row += surface->pitch) {
+                    switch (bytes) {
+                        case 1:
+                            memset (row, static_cast<Uint8> (color), rect.w);
+                            break;
+                        case 2:
+                            fill_n (reinterpret_cast<Uint16*> (row), rect.w, static_cast<Uint16> (color));
+                            break;
+                        case 3:
+                            for (Uint8* p = row; p != row + rect.w * 3; p += 3) {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+                                p[0] = static_cast<Uint8> (color >> 16);
+                                p[1] = static_cast<Uint8> (color >> 8);
+                                p[2] = static_cast<Uint8> (color);
+#else
+                                p[0] = static_cast<Uint8> (color);
+                                p[1] = static_cast<Uint8> (color >> 8);
+                                p[2] = static_cast<Uint8> (color >> 16);
+#endif
+                            }
+                            break;
+                        default:
+                            fill_n (reinterpret_cast<Uint32*> (row), rect.w, color);
+                            break;
+                    }
+                }
+            };
+
+            /**
+             * The Surface onto which to composite.
+             */
+            Surface target_;
+
+            /**
+             * The width and height of a tile.
+             */
+            int tileSize_;
+
+            /**
+             * The number of tile columns.
+             */
+            int columns_;
+
+            /**
+             * The queued commands.
+             */
+            vector<Command> commands_;
+
+            /**
+             * The blit sources, held until the commands are executed.
+             */
+            vector<Surface> sources_;
+
+            /**
+             * The indices of the commands touching each tile.
+             */
+            vector<vector<size_t> > bins_;
+
+            /**
+             * Whether or not a queued source forces serial compositing.
+             */
+            bool serial_;
+
+            /**
+             * Set by a worker whose tile failed.
+             */
+            atomic<bool> failed_;
+
+            /**
+             * The worker threads.
+             */
+            ThreadPool pool_;
+    }; //TiledCompositor
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_TILEDCOMPOSITOR_H
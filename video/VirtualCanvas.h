@@ -0,0 +1,505 @@
+/**
+ * @file VirtualCanvas.h
+ * Contains the VirtualCanvas class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_VIRTUALCANVAS_H
+#define SDL_VIDEO_VIRTUALCANVAS_H
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/mpl/vector.hpp>
+
+#include <SDL.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "sdlpp/misc/Rect.h"
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/event/WindowEvents.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace misc;
+
+    /**
+     * @class VirtualCanvas
+     * @brief A canvas of fixed logical size presented scaled onto the display Surface.
+     *
+     * Drawing goes to the canvas, a software Surface in the display's pixel format, and present
+     * copies it into the display through column and row tables computed when the display size
+     * changes, so a frame costs one table lookup per pixel and one row copy per repeated row.
+     * Whole-number scales of 1, 2 and 4 replicate pixels with SSE2 instead. Scaling samples the
+     * nearest pixel, which keeps pixel art sharp; downscaling to a smaller display drops pixels.
+     * The display Surface is only set again by resize, in response to a Resize event.
+     */
+    class VirtualCanvas {
+        public:
+            /**
+             * The events handled by the VirtualCanvas.
+             */
+            typedef boost::mpl::vector<event::Resize> Events;
+
+            /**
+             * @enum Fit
+             * @brief How the canvas is fitted onto the display.
+             */
+            enum Fit {
+                STRETCH,   /**< Fill the display, ignoring the aspect ratio. */
+                LETTERBOX, /**< The largest size with the canvas' aspect ratio, centered with bars. */
+                INTEGER    /**< The largest whole-number scale, centered with bars, LETTERBOX if the display is smaller than the canvas. */
+            };
+
+            /**
+             * Constructs a VirtualCanvas, setting the video mode.
+             *
+             * @param logicalWidth The width of the canvas.
+             * @param logicalHeight The height of the canvas.
+             * @param width The width of the display.
+             * @param height The height of the display.
+             * @param bpp The bits per pixel of the display.
+             * @param flags The display Surface flags.
+             * @param fit How the canvas is fitted onto the display.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to set the video mode or create the canvas.
+             */
+            VirtualCanvas (int logicalWidth, int logicalHeight, int width, int height, int bpp = 32,
+                           Uint32 flags = SDL_SWSURFACE | SDL_RESIZABLE, Fit fit = LETTERBOX)
+              : width_ (logicalWidth), height_ (logicalHeight), bpp_ (bpp), flags_ (flags), fit_ (fit),
+                screen_ (width, height, bpp, flags), canvas_ (create (logicalWidth, logicalHeight, screen_)),
+                border_ (0), bars_ (0), scale_ (0), viewport_ (), columns_ (), rows_ () {
+                layout ();
+            };
+
+            /**
+             * Returns the canvas, the Surface to draw on.
+             *
+             * @return The canvas.
+             */
+            Surface& canvas () { return canvas_; };
+
+            /**
+             * Returns the display Surface.
+             *
+             * @return The display Surface.
+             */
+            Surface& screen () { return screen_; };
+
+            /**
+             * Scales the canvas onto the display and shows it.
+             *
+             * @return True if successful, false otherwise.
+             */
+            bool present () {
+                SDL_Surface* dst = screen_.to_c ();
+                if (bars_ > 0) {
+                    fillBars ();
+                    --bars_;
+                }
+                if (SDL_MUSTLOCK (dst) && SDL_LockSurface (dst) == -1)
+                    return false;
+                draw (canvas_.to_c (), dst);
+                if (SDL_MUSTLOCK (dst))
+                    SDL_UnlockSurface (dst);
+                return SDL_Flip (dst) == 0;
+            };
+
+            /**
+             * Sets the display to a new size and recomputes the scaling tables.
+             *
+             * @param width The width of the display.
+             * @param height The height of the display.
+             *
+             * @return A reference to this VirtualCanvas.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to set the video mode.
+             */
+            VirtualCanvas& resize (int width, int height) {
+                screen_ = Surface (width, height, bpp_, flags_);
+                SDL_PixelFormat* screen = screen_.to_c ()->format;
+                SDL_PixelFormat* canvas = canvas_.to_c ()->format;
+                if (screen->BitsPerPixel != canvas->BitsPerPixel || screen->Rmask != canvas->Rmask
+                    || screen->Gmask != canvas->Gmask || screen->Bmask != canvas->Bmask)
+                    canvas_ = Surface (SDL_ConvertSurface (canvas_.to_c (), screen, SDL_SWSURFACE));
+                layout ();
+                return *this;
+            };
+
+            /**
+             * Handles a Resize event, so a VirtualCanvas can be the Handler of a Dispatcher.
+             *
+             * @param event The Resize event.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to set the video mode.
+             */
+            void handle (const event::Resize& event) { resize (event.get ().w, event.get ().h); };
+
+            /**
+             * Returns how the canvas is fitted onto the display.
+             *
+             * @return The Fit.
+             */
+            Fit fit () const { return fit_; };
+
+            /**
+             * Sets how the canvas is fitted onto the display.
+             *
+             * @param fit The Fit.
+             *
+             * @return A reference to this VirtualCanvas.
+             */
+            VirtualCanvas& fit (Fit fit) {
+                fit_ = fit;
+                layout ();
+                return *this;
+            };
+
+            /**
+             * Sets the color of the bars around a letterboxed canvas.
+             *
+             * @param red The red component.
+             * @param green The green component.
+             * @param blue The blue component.
+             *
+             * @return A reference to this VirtualCanvas.
+             */
+            VirtualCanvas& border (Uint8 red, Uint8 green, Uint8 blue) {
+                border_ = SDL_MapRGB (screen_.to_c ()->format, red, green, blue);
+                bars_ = (flags_ & SDL_DOUBLEBUF) != 0 ? 2 : 1;
+                return *this;
+            };
+
+            /**
+             * Returns the area of the display the canvas is scaled onto.
+             *
+             * @return The area.
+             */
+            Rect viewport () const { return Rect (viewport_.h, viewport_.w, viewport_.x, viewport_.y); };
+
+            /**
+             * Returns the whole-number scale of the canvas.
+             *
+             * @return The scale, 0 if the canvas is not scaled by a whole number.
+             */
+            int scale () const { return scale_; };
+
+            /**
+             * Converts a display position, such as a mouse position, to a canvas position.
+             *
+             * @param x The display column.
+             * @param y The display row.
+             * @param logicalX Receives the canvas column.
+             * @param logicalY Receives the canvas row.
+             *
+             * @return True if the position is on the canvas, false if it is outside or on a bar.
+             */
+            bool toLogical (int x, int y, int& logicalX, int& logicalY) const {
+                x -= viewport_.x;
+                y -= viewport_.y;
+                if (x < 0 || y < 0 || x >= viewport_.w || y >= viewport_.h)
+                    return false;
+                logicalX = x * width_ / viewport_.w;
+                logicalY = y * height_ / viewport_.h;
+                return true;
+            };
+
+        private:
+            /**
+             * Copy constructs a VirtualCanvas.
+             *
+             * @param rhs The VirtualCanvas to copy.
+             */
+            VirtualCanvas (const VirtualCanvas& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The VirtualCanvas from which to assign.
+             *
+             * @return A reference to this VirtualCanvas.
+             */
+            VirtualCanvas& operator= (const VirtualCanvas& rhs);
+
+            /**
+             * Creates a canvas in the display's pixel format.
+             *
+             * @param width The width.
+             * @param height The height.
+             * @param screen The display Surface.
+             *
+             * @return The canvas.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to create the canvas.
+             */
+            static Surface create (int width, int height, const Surface& screen) {
+                SDL_PixelFormat* f = screen.to_c ()->format;
+                return Surface (SDL_CreateRGBSurface (SDL_SWSURFACE, width, height, f->BitsPerPixel, f->Rmask, f->Gmask, f->Bmask, 0));
+            };
+
+            /**
+             * Computes the viewport and the scaling tables for the current display size.
+             */
+            void layout () {
+                SDL_Surface* dst = screen_.to_c ();
+                int w = dst->w;
+                int h = dst->h;
+                int vw = w;
+                int vh = h;
+                int k = min (w / width_, h / height_);
+                if (fit_ == INTEGER && k >= 1) {
+                    vw = width_ * k;
+                    vh = height_ * k;
+                } else if (fit_ != STRETCH) {
+                    if (static_cast<long> (w) * height_ <= static_cast<long> (h) * width_)
+                        vh = max (1L, static_cast<long> (w) * height_ / width_);
+                    else
+                        vw = max (1L, static_cast<long> (h) * width_ / height_);
+                }
+                viewport_.x = (w - vw) / 2;
+                viewport_.y = (h - vh) / 2;
+                viewport_.w = vw;
+                viewport_.h = vh;
+                scale_ = vw % width_ == 0 && vh % height_ == 0 && vw / width_ == vh / height_ ? vw / width_ : 0;
+
+                //sample the source pixel under the center of each display pixel.
+                int bytes = dst->format->BytesPerPixel;
+                columns_.resize (vw);
+                for (int x = 0; x < vw; ++x)
+                    columns_[x] = static_cast<int> ((2L * x + 1) * width_ / (2L * vw)) * bytes;
+                rows_.resize (vh);
+                for (int y = 0; y < vh; ++y)
+                    rows_[y] = static_cast<int> ((2L * y + 1) * height_ / (2L * vh));
+                bars_ = (flags_ & SDL_DOUBLEBUF) != 0 ? 2 : 1;
+            };
+
+            /**
+             * Fills the display around the viewport with the border color.
+             */
+            void fillBars () {
+                SDL_Surface* dst = screen_.to_c ();
+                int right = viewport_.x + viewport_.w;
+                int bottom = viewport_.y + viewport_.h;
+                SDL_Rect bars[4] = {
+                    { 0, 0, static_cast<Uint16> (dst->w), static_cast<Uint16> (viewport_.y) },
+                    { 0, static_cast<Sint16> (bottom), static_cast<Uint16> (dst->w), static_cast<Uint16> (dst->h - bottom) },
+                    { 0, viewport_.y, static_cast<Uint16> (viewport_.x), viewport_.h },
+                    { static_cast<Sint16> (right), viewport_.y, static_cast<Uint16> (dst->w - right), viewport_.h }
+                };
+                for (int i = 0; i < 4; ++i)
+                    if (bars[i].w != 0 && bars[i].h != 0)
+                        SDL_FillRect (dst, &bars[i], border_);
+            };
+
+            /**
+             * Scales the canvas into the viewport of the locked display.
+             *
+             * @param src The canvas.
+             * @param dst The display.
+             */
+            void draw (const SDL_Surface* src, SDL_Surface* dst) const {
+                int bytes = dst->format->BytesPerPixel;
+                size_t rowBytes = viewport_.w * bytes;
+                Uint8* out = static_cast<Uint8*> (dst->pixels) + viewport_.y * dst->pitch + viewport_.x * bytes;
+                for (int y = 0; y < viewport_.h; ++y, out += dst->pitch) {
+                    if (y > 0 && rows_[y] == rows_[y - 1]) {
+                        memcpy (out, out - dst->pitch, rowBytes);
+                        continue;
+                    }
+                    const Uint8* in = static_cast<const Uint8*> (src->pixels) + rows_[y] * src->pitch;
+                    if (scale_ == 1)
+                        memcpy (out, in, rowBytes);
+                    else if (bytes == 4 && scale_ == 2)
+                        double32 (reinterpret_cast<const Uint32*> (in), reinterpret_cast<Uint32*> (out), width_);
+                    else if (bytes == 4 && scale_ == 4)
+                        quadruple32 (reinterpret_cast<const Uint32*> (in), reinterpret_cast<Uint32*> (out), width_);
+                    else if (bytes == 2 && scale_ == 2)
+                        double16 (reinterpret_cast<const Uint16*> (in), reinterpret_cast<Uint16*> (out), width_);
+                    else if (bytes == 4)
+                        gather<Uint32> (in, out);
+                    else if (bytes == 2)
+                        gather<Uint16> (in, out);
+                    else if (bytes == 1)
+                        gather<Uint8> (in, out);
+                    else
+                        gather3 (in, out);
+                }
+            };
+
+            /**
+             * Scales a row through the column table.
+             *
+             * @tparam T The pixel type.
+             *
+             * @param in The canvas row.
+             * @param out The display row.
+             */
+            template<class T>
+            void gather (const Uint8* in, Uint8* out) const {
+                T* dst = reinterpret_cast<T*> (out);
+                for (int x = 0; x < viewport_.w; ++x)
+                    dst[x] = *reinterpret_cast<const T*> (in + columns_[x]);
+            };
+
+            /**
+             * Scales a row of 24 bit pixels through the column table.
+             *
+             * @param in The canvas row.
+             * @param out The display row.
+             */
+            void gather3 (const Uint8* in, Uint8* out) const {
+                for (int x = 0; x < viewport_.w; ++x, out += 3) {
+                    const Uint8* p = in + columns_[x];
+                    out[0] = p[0];
+                    out[1] = p[1];
+                    out[2] = p[2];
+                }
+            };
+
+            /**
+             * Doubles each pixel of a row of 32 bit pixels.
+             *
+             * @param in The canvas row.
+             * @param out The display row.
+             * @param count The number of canvas pixels.
+             */
+            static void double32 (const Uint32* in, Uint32* out, int count) {
+                int x = 0;
+#ifdef __SSE2__
+                for (; x + 4 <= count; x += 4) {
+                    __m128i v = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + x));
+                    _mm_storeu_si128 (reinterpret_cast<__m128i*> (out + 2 * x), _mm_unpacklo_epi32 (v, v));
+                    _mm_storeu_si128 (reinterpret_cast<__m128i*> (out + 2 * x + 4), _mm_unpackhi_epi32 (v, v));
+                }
+#endif
+                for (; x < count; ++x)
+                    out[2 * x] = out[2 * x + 1] = in[x];
+            };
+
+            /**
+             * Quadruples each pixel of a row of 32 bit pixels.
+             *
+             * @param in The canvas row.
+             * @param out The display row.
+             * @param count The number of canvas pixels.
+             */
+            static void quadruple32 (const Uint32* in, Uint32* out, int count) {
+                int x = 0;
+#ifdef __SSE2__
+                for (; x + 4 <= count; x += 4) {
+                    __m128i v = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + x));
+                    __m128i* o = reinterpret_cast<__m128i*> (out + 4 * x);
+                    _mm_storeu_si128 (o, _mm_shuffle_epi32 (v, 0x00));
+                    _mm_storeu_si128 (o + 1, _mm_shuffle_epi32 (v, 0x55));
+                    _mm_storeu_si128 (o + 2, _mm_shuffle_epi32 (v, 0xaa));
+                    _mm_storeu_si128 (o + 3, _mm_shuffle_epi32 (v, 0xff));
+                }
+#endif
+                for (; x < count; ++x)
+                    out[4 * x] = out[4 * x + 1] = out[4 * x + 2] = out[4 * x + 3] = in[x];
+            };
+
+            /**
+             * Doubles each pixel of a row of 16 bit pixels.
+             *
+             * @param in The canvas row.
+             * @param out The display row.
+             * @param count The number of canvas pixels.
+             */
+            static void double16 (const Uint16* in, Uint16* out, int count) {
+                int x = 0;
+#ifdef __SSE2__
+                for (; x + 8 <= count; x += 8) {
+                    __m128i v = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + x));
+                    _mm_storeu_si128 (reinterpret_cast<__m128i*> (out + 2 * x), _mm_unpacklo_epi16 (v, v));
+                    _mm_storeu_si128 (reinterpret_cast<__m128i*> (out + 2 * x + 8), _mm_unpackhi_epi16 (v, v));
+                }
+#endif
+                for (; x < count; ++x)
+                    out[2 * x] = out[2 * x + 1] = in[x];
+            };
+
+            /**
+             * The size of the canvas.
+             */
+            int width_, height_;
+
+            /**
+             * The bits per pixel of the display.
+             */
+            int bpp_;
+
+            /**
+             * The display Surface flags.
+             */
+            Uint32 flags_;
+
+            /**
+             * How the canvas is fitted onto the display.
+             */
+            Fit fit_;
+
+            /**
+             * The display Surface.
+             */
+            Surface screen_;
+
+            /**
+             * The Surface drawn on.
+             */
+            Surface canvas_;
+
+            /**
+             * The color of the bars, in the display's format.
+             */
+            Uint32 border_;
+
+            /**
+             * The number of frames still to fill the bars on, one per display buffer.
+             */
+            int bars_;
+
+            /**
+             * The whole-number scale, 0 if none.
+             */
+            int scale_;
+
+            /**
+             * The area of the display the canvas is scaled onto.
+             */
+            SDL_Rect viewport_;
+
+            /**
+             * The byte offset in a canvas row of the pixel sampled by each viewport column.
+             */
+            vector<int> columns_;
+
+            /**
+             * The canvas row sampled by each viewport row.
+             */
+            vector<int> rows_;
+    }; //VirtualCanvas
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_VIRTUALCANVAS_H
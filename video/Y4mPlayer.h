@@ -0,0 +1,676 @@
+/**
+ * @file Y4mPlayer.h
+ * Contains the Y4mSource and Y4mPlayer classes.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_Y4MPLAYER_H
+#define SDL_VIDEO_Y4MPLAYER_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <SDL.h>
+
+#include "sdlpp/misc/Clock.h"
+#include "sdlpp/misc/Rect.h"
+#include "sdlpp/video/Overlay.h"
+#include "sdlpp/thread/Mutex.h"
+#include "sdlpp/thread/Condition.h"
+#include "sdlpp/thread/Thread.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace misc;
+    using namespace thread;
+
+    /**
+     * @class Y4mSource
+     * @brief Reads 8 bit 4:2:0 YUV4MPEG2 frames ahead of playback on a background thread.
+     *
+     * Frames are read into a ring of buffers allocated up front, so reading never allocates and
+     * playback never waits on the disk or pipe while a frame is buffered. The stream is read
+     * strictly forward, a pipe works as well as a file.
+     */
+    class Y4mSource {
+        public:
+            /**
+             * @struct Frame
+             * @brief A buffered frame, valid until released.
+             */
+            struct Frame {
+                /**
+                 * The number of the frame in the stream, starting at 0.
+                 */
+                unsigned int number_;
+
+                /**
+                 * The Y, U and V planes, each stored without padding.
+                 */
+                const Uint8* planes_[3];
+            }; //Frame
+
+            /**
+             * Opens a stream and starts reading ahead.
+             *
+             * @param fileName The name of the file or pipe, "-" for standard input.
+             * @param buffers The number of frames to read ahead.
+             *
+             * @throw runtime_error Throws a runtime_error if unable to open the stream or the header is invalid or not 8 bit 4:2:0.
+             */
+            explicit Y4mSource (const string& fileName, unsigned int buffers = 8)
+              : file_ (fileName == "-" ? stdin : fopen (fileName.c_str (), "rb")),
+                width_ (0), height_ (0), rateNum_ (0), rateDen_ (0),
+                slots_ (), head_ (0), count_ (0), held_ (false), read_ (0), finished_ (false), stop_ (false),
+                decodeSeconds_ (0.0), mutex_ (), ready_ (), space_ (), reader_ () {
+                if (file_ == NULL)
+                    throw runtime_error ("Failed to open " + fileName);
+                try {
+                    header ();
+                } catch (...) {
+                    close ();
+                    throw;
+                }
+                slots_.resize (buffers < 2 ? 2 : buffers, vector<Uint8> (frameBytes ()));
+                reader_.reset (new Thread (boost::bind (&Y4mSource::run, this)));
+            };
+
+            /**
+             * Stops reading and closes the stream. A read blocked on an idle pipe finishes first.
+             */
+            ~Y4mSource () {
+                {
+                    Lock lock (mutex_);
+                    stop_ = true;
+                    space_.broadcast ();
+                }
+                reader_.reset ();
+                close ();
+            };
+
+            /**
+             * Takes the oldest buffered frame. It must be released before the next one is taken.
+             *
+             * @param frame Receives the frame.
+             * @param wait Whether to wait for a frame if none is buffered yet.
+             *
+             * @return True if a frame was taken, false if none is buffered or the stream has ended.
+             */
+            bool acquire (Frame& frame, bool wait = true) {
+                Lock lock (mutex_);
+                while (wait && count_ == 0 && !finished_)
+                    ready_.wait (lock);
+                if (count_ == 0)
+                    return false;
+                held_ = true;
+                frame.number_ = read_ - count_;
+                Uint8* y = &slots_[head_][0];
+                frame.planes_[0] = y;
+                frame.planes_[1] = y + width_ * height_;
+                frame.planes_[2] = frame.planes_[1] + chromaWidth () * chromaHeight ();
+                return true;
+            };
+
+            /**
+             * Releases the frame taken by acquire so its buffer can be read into again.
+             */
+            void release () {
+                Lock lock (mutex_);
+                if (!held_)
+                    return;
+                held_ = false;
+                head_ = (head_ + 1) % slots_.size ();
+                --count_;
+                space_.signal ();
+            };
+
+            /**
+             * Determines if every frame has been read and taken.
+             *
+             * @return True if the stream has ended, false otherwise.
+             */
+            bool ended () {
+                Lock lock (mutex_);
+                return finished_ && count_ == 0;
+            };
+
+            /**
+             * Returns the number of frames buffered.
+             *
+             * @return The number of frames buffered.
+             */
+            unsigned int buffered () {
+                Lock lock (mutex_);
+                return count_;
+            };
+
+            /**
+             * Returns the number of frames read so far.
+             *
+             * @return The number of frames read.
+             */
+            unsigned int frames () {
+                Lock lock (mutex_);
+                return read_;
+            };
+
+            /**
+             * Returns the total time spent reading frames.
+             *
+             * @return The time in seconds.
+             */
+            double decodeSeconds () {
+                Lock lock (mutex_);
+                return decodeSeconds_;
+            };
+
+            /**
+             * Returns the width of the luma plane.
+             *
+             * @return The width.
+             */
+            int width () const { return width_; };
+
+            /**
+             * Returns the height of the luma plane.
+             *
+             * @return The height.
+             */
+            int height () const { return height_; };
+
+            /**
+             * Returns the width of the chroma planes.
+             *
+             * @return The width.
+             */
+            int chromaWidth () const { return (width_ + 1) / 2; };
+
+            /**
+             * Returns the height of the chroma planes.
+             *
+             * @return The height.
+             */
+            int chromaHeight () const { return (height_ + 1) / 2; };
+
+            /**
+             * Returns the duration of a frame.
+             *
+             * @return The duration in seconds.
+             */
+            double frameDuration () const { return static_cast<double> (rateDen_) / rateNum_; };
+
+        private:
+            /**
+             * Copy constructs a Y4mSource.
+             *
+             * @param rhs The Y4mSource to copy.
+             */
+            Y4mSource (const Y4mSource& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The Y4mSource from which to assign.
+             *
+             * @return A reference to this Y4mSource.
+             */
+            Y4mSource& operator= (const Y4mSource& rhs);
+
+            /**
+             * Returns the size of a frame in bytes.
+             *
+             * @return The size of a frame.
+             */
+            size_t frameBytes () const { return width_ * height_ + 2 * chromaWidth () * chromaHeight (); };
+
+            /**
+             * Reads a line of at most 1024 characters.
+             *
+             * @param line Receives the line without the newline.
+             *
+             * @return True if a whole line was read, false otherwise.
+             */
+            bool line (string& line) {
+                line.clear ();
+                for (int c = getc (file_); c != EOF; c = getc (file_)) {
+                    if (c == '\n')
+                        return true;
+                    if (line.size () == 1024)
+                        return false;
+                    line += static_cast<char> (c);
+                }
+                return false;
+            };
+
+            /**
+             * Parses the stream header.
+             *
+             * @throw runtime_error Throws a runtime_error if the header is invalid or not 8 bit 4:2:0.
+             */
+            void header () {
+                string text;
+                if (!line (text) || text.compare (0, 10, "YUV4MPEG2 ") != 0)
+                    throw runtime_error ("Not a YUV4MPEG2 stream.");
+                istringstream tokens (text.substr (10));
+                string token;
+                while (tokens >> token) {
+                    const char* value = token.c_str () + 1;
+                    switch (token[0]) {
+                        case 'W':
+                            width_ = atoi (value);
+                            break;
+                        case 'H':
+                            height_ = atoi (value);
+                            break;
+                        case 'F':
+                            if (sscanf (value, "%u:%u", &rateNum_, &rateDen_) != 2)
+                                throw runtime_error ("Invalid YUV4MPEG2 frame rate.");
+                            break;
+                        case 'C':
+                            //only 8 bit 4:2:0, 420p10 and the like hold 16 bit samples.
+                            if (token != "C420" && token != "C420jpeg" && token != "C420paldv" && token != "C420mpeg2")
+                                throw runtime_error ("Unsupported YUV4MPEG2 colorspace " + token.substr (1) + ".");
+                            break;
+                    }
+                }
+                if (width_ <= 0 || height_ <= 0 || width_ > 16384 || height_ > 16384)
+                    throw runtime_error ("Invalid YUV4MPEG2 frame size.");
+                if (rateNum_ == 0 || rateDen_ == 0) {
+                    rateNum_ = 25;
+                    rateDen_ = 1;
+                }
+            };
+
+            /**
+             * Reads frames into free buffers until the stream ends or the Y4mSource is destroyed.
+             */
+            void run () {
+                string text;
+                for (;;) {
+                    size_t slot;
+                    {
+                        Lock lock (mutex_);
+                        while (!stop_ && count_ == slots_.size ())
+                            space_.wait (lock);
+                        if (stop_)
+                            return;
+                        slot = (head_ + count_) % slots_.size ();
+                    }
+
+                    double start = Clock::now ();
+                    bool ok = line (text) && text.compare (0, 5, "FRAME") == 0
+                           && fread (&slots_[slot][0], slots_[slot].size (), 1, file_) == 1;
+                    double seconds = Clock::now () - start;
+
+                    Lock lock (mutex_);
+                    if (!ok) {
+                        finished_ = true;
+                        ready_.broadcast ();
+                        return;
+                    }
+                    ++count_;
+                    ++read_;
+                    decodeSeconds_ += seconds;
+                    ready_.broadcast ();
+                }
+            };
+
+            /**
+             * Closes the stream unless it is standard input.
+             */
+            void close () {
+                if (file_ != NULL && file_ != stdin)
+                    fclose (file_);
+                file_ = NULL;
+            };
+
+            /**
+             * The stream.
+             */
+            FILE* file_;
+
+            /**
+             * The size of the luma plane.
+             */
+            int width_, height_;
+
+            /**
+             * The frame rate as a fraction.
+             */
+            unsigned int rateNum_, rateDen_;
+
+            /**
+             * The frame buffers.
+             */
+            vector<vector<Uint8> > slots_;
+
+            /**
+             * The buffer of the oldest buffered frame.
+             */
+            size_t head_;
+
+            /**
+             * The number of buffered frames, including one taken and not yet released.
+             */
+            size_t count_;
+
+            /**
+             * Whether or not the oldest frame has been taken.
+             */
+            bool held_;
+
+            /**
+             * The number of frames read.
+             */
+            unsigned int read_;
+
+            /**
+             * Whether or not the stream has ended.
+             */
+            bool finished_;
+
+            /**
+             * Tells the reader to stop.
+             */
+            bool stop_;
+
+            /**
+             * The total time spent reading frames.
+             */
+            double decodeSeconds_;
+
+            /**
+             * Guards the ring.
+             */
+            Mutex mutex_;
+
+            /**
+             * Signaled when a frame is read or the stream ends.
+             */
+            Condition ready_;
+
+            /**
+             * Signaled when a buffer is released or the reader should stop.
+             */
+            Condition space_;
+
+            /**
+             * The reader thread. Declared last so it is started after, and stopped before, the state it uses.
+             */
+            boost::shared_ptr<Thread> reader_;
+    }; //Y4mSource
+
+    /**
+     * @struct PlaybackStats
+     * @brief Counts and timings of a Y4mPlayer.
+     */
+    struct PlaybackStats {
+        /**
+         * Constructs zeroed PlaybackStats.
+         */
+        PlaybackStats () : presented_ (0), dropped_ (0), repeated_ (0), underruns_ (0), decodeSeconds_ (0.0), uploadSeconds_ (0.0), presentSeconds_ (0.0) {};
+
+        /**
+         * The number of frames displayed.
+         */
+        unsigned int presented_;
+
+        /**
+         * The number of frames skipped because they were late.
+         */
+        unsigned int dropped_;
+
+        /**
+         * The number of times the current frame was displayed again because the next was not due.
+         */
+        unsigned int repeated_;
+
+        /**
+         * The number of times the next frame was due but not yet read.
+         */
+        unsigned int underruns_;
+
+        /**
+         * The total time spent reading frames.
+         */
+        double decodeSeconds_;
+
+        /**
+         * The total time spent copying frames into the Overlay.
+         */
+        double uploadSeconds_;
+
+        /**
+         * The total time spent displaying the Overlay.
+         */
+        double presentSeconds_;
+    }; //PlaybackStats
+
+    /**
+     * @class Y4mPlayer
+     * @brief Presents a Y4mSource on an Overlay at the stream's frame rate.
+     *
+     * Each call to present shows the frame due at the current time. Frames that are already a
+     * whole frame late are dropped without being copied while a newer one is buffered, and when
+     * the next frame is not due the current one is shown again, so playback follows the clock
+     * rather than the call rate.
+     */
+    class Y4mPlayer {
+        public:
+            /**
+             * Constructs a Y4mPlayer.
+             *
+             * @param source The stream.
+             * @param overlay A YV12 or IYUV Overlay the size of the stream.
+             *
+             * @throw runtime_error Throws a runtime_error if the Overlay does not fit the stream.
+             */
+            Y4mPlayer (Y4mSource& source, Overlay& overlay) : source_ (source), overlay_ (overlay), clock_ (), started_ (false), shown_ (false), stats_ () {
+                if (overlay.width () != source.width () || overlay.height () != source.height ())
+                    throw runtime_error ("Overlay size differs from the stream.");
+                if (overlay.format () != SDL_YV12_OVERLAY && overlay.format () != SDL_IYUV_OVERLAY)
+                    throw runtime_error ("Y4mPlayer requires a YV12 or IYUV Overlay.");
+            };
+
+            /**
+             * Presents the frame due on the Y4mPlayer's own clock, started by the first call.
+             *
+             * @param dstRect The rectangle onto which to display.
+             *
+             * @return True while playing, false once the stream has ended.
+             *
+             * @throw runtime_error Throws a runtime_error if the Overlay cannot be locked.
+             */
+            bool present (Rect& dstRect) {
+                if (!started_) {
+                    clock_.restart ();
+                    started_ = true;
+                }
+                return present (dstRect, clock_.elapsed ());
+            };
+
+            /**
+             * Presents the frame due at a given time, typically the audio position, to hold A/V sync.
+             *
+             * @param dstRect The rectangle onto which to display.
+             * @param clock The playback position in seconds.
+             *
+             * @return True while playing, false once the stream has ended.
+             *
+             * @throw runtime_error Throws a runtime_error if the Overlay cannot be locked.
+             */
+            bool present (Rect& dstRect, double clock) {
+                double duration = source_.frameDuration ();
+                Y4mSource::Frame frame;
+                for (;;) {
+                    if (!source_.acquire (frame, false)) {
+                        if (source_.ended ())
+                            return false;
+                        ++stats_.underruns_;
+                        return repeat (dstRect);
+                    }
+                    double due = frame.number_ * duration;
+                    if (due > clock) {
+                        //the source frame stays buffered, acquire hands it out again next time.
+                        return repeat (dstRect);
+                    }
+                    if (clock >= due + duration && source_.buffered () > 1) {
+                        source_.release ();
+                        ++stats_.dropped_;
+                        continue;
+                    }
+                    break;
+                }
+
+                double start = Clock::now ();
+                upload (frame);
+                source_.release ();
+                double uploaded = Clock::now ();
+                stats_.uploadSeconds_ += uploaded - start;
+                overlay_.display (dstRect);
+                stats_.presentSeconds_ += Clock::now () - uploaded;
+                ++stats_.presented_;
+                shown_ = true;
+                return true;
+            };
+
+            /**
+             * Returns the counts and timings so far.
+             *
+             * @return The PlaybackStats.
+             */
+            PlaybackStats stats () const {
+                PlaybackStats stats = stats_;
+                stats.decodeSeconds_ = source_.decodeSeconds ();
+                return stats;
+            };
+
+        private:
+            /**
+             * Copy constructs a Y4mPlayer.
+             *
+             * @param rhs The Y4mPlayer to copy.
+             */
+            Y4mPlayer (const Y4mPlayer& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The Y4mPlayer from which to assign.
+             *
+             * @return A reference to this Y4mPlayer.
+             */
+            Y4mPlayer& operator= (const Y4mPlayer& rhs);
+
+            /**
+             * Displays the current frame again, if there is one.
+             *
+             * @param dstRect The rectangle onto which to display.
+             *
+             * @return True.
+             */
+            bool repeat (Rect& dstRect) {
+                if (shown_) {
+                    double start = Clock::now ();
+                    overlay_.display (dstRect);
+                    stats_.presentSeconds_ += Clock::now () - start;
+                    ++stats_.repeated_;
+                }
+                return true;
+            };
+
+            /**
+             * Copies a frame into the Overlay's planes.
+             *
+             * @param frame The frame.
+             *
+             * @throw runtime_error Throws a runtime_error if the Overlay cannot be locked.
+             */
+            void upload (const Y4mSource::Frame& frame) {
+                if (!overlay_.lock ()) {
+                    source_.release ();
+                    throw runtime_error (SDL_GetError ());
+                }
+                int u = overlay_.format () == SDL_YV12_OVERLAY ? 2 : 1;
+                copy (frame.planes_[0], source_.width (), source_.height (), 0);
+                copy (frame.planes_[1], source_.chromaWidth (), source_.chromaHeight (), u);
+                copy (frame.planes_[2], source_.chromaWidth (), source_.chromaHeight (), 3 - u);
+                overlay_.unlock ();
+            };
+
+            /**
+             * Copies a plane into the Overlay, row by row to honor its pitch.
+             *
+             * @param src The plane.
+             * @param width The width of the plane.
+             * @param height The height of the plane.
+             * @param plane The Overlay plane.
+             */
+            void copy (const Uint8* src, int width, int height, int plane) {
+                Uint8* dst = overlay_.pixels (plane);
+                int pitch = overlay_.pitch (plane);
+                if (pitch == width) {
+                    memcpy (dst, src, width * height);
+                    return;
+                }
+                for (int y = 0; y < height; ++y, src += width, dst += pitch)
+                    memcpy (dst, src, width);
+            };
+
+            /**
+             * The stream.
+             */
+            Y4mSource& source_;
+
+            /**
+             * The Overlay presented on.
+             */
+            Overlay& overlay_;
+
+            /**
+             * The playback clock used when no external clock is given.
+             */
+            Clock clock_;
+
+            /**
+             * Whether or not the playback clock has been started.
+             */
+            bool started_;
+
+            /**
+             * Whether or not a frame has been displayed.
+             */
+            bool shown_;
+
+            /**
+             * The counts and timings.
+             */
+            PlaybackStats stats_;
+    }; //Y4mPlayer
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_Y4MPLAYER_H
@@ -0,0 +1,395 @@
+/**
+ * @file YuvConverter.h
+ * Contains the YuvConverter class.
+ *
+ * Copyright (C) 2011 Thomas P. Lahoda
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef SDL_VIDEO_YUVCONVERTER_H
+#define SDL_VIDEO_YUVCONVERTER_H
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/bind/bind.hpp>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <SDL.h>
+
+#include "sdlpp/video/Surface.h"
+#include "sdlpp/video/Overlay.h"
+#include "sdlpp/thread/ThreadPool.h"
+
+namespace sdl {
+namespace video {
+    using namespace std;
+    using namespace thread;
+
+    /**
+     * @class YuvConverter
+     * @brief Converts RGB pixels into the planes of a YV12 or IYUV Overlay.
+     *
+     * Uses the BT.601 studio swing integer coefficients with chroma averaged over each 2x2 block.
+     * Rows are split into bands converted on worker threads, eight pixels at a time with SSE2 when
+     * compiled for it. The SSE2 and scalar paths produce the same bytes.
+     */
+    class YuvConverter {
+        public:
+            /**
+             * Constructs a YuvConverter.
+             *
+             * @param threads The number of worker threads, 0 for one per processor.
+             */
+            explicit YuvConverter (unsigned int threads = 0) : job_ (), pool_ (threads) {};
+
+            /**
+             * Converts a Surface into a locked Overlay. Sizes may differ, the smaller is converted.
+             *
+             * @param src The Surface to convert. 32 bit Surfaces are read in place, others are converted to 32 bits first.
+             * @param dst The Overlay, already locked.
+             *
+             * @return A reference to this YuvConverter.
+             *
+             * @throw runtime_error Throws a runtime_error if the Overlay is not YV12 or IYUV or the Surface cannot be read.
+             */
+            YuvConverter& convert (const Surface& src, Overlay& dst) {
+                SDL_Surface* s = src.to_c ();
+                SDL_PixelFormat* f = s->format;
+                if (f->BytesPerPixel == 4 && f->Rloss == 0 && f->Gloss == 0 && f->Bloss == 0) {
+                    if (SDL_MUSTLOCK (s) && SDL_LockSurface (s) == -1)
+                        throw runtime_error (SDL_GetError ());
+                    convert (s->pixels, s->pitch, f, s->w, s->h, dst);
+                    if (SDL_MUSTLOCK (s))
+                        SDL_UnlockSurface (s);
+                    return *this;
+                }
+
+                Surface like (SDL_CreateRGBSurface (SDL_SWSURFACE, 1, 1, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0));
+                Surface converted (SDL_ConvertSurface (s, like.to_c ()->format, SDL_SWSURFACE));
+                SDL_Surface* c = converted.to_c ();
+                return convert (c->pixels, c->pitch, c->format, c->w, c->h, dst);
+            };
+
+            /**
+             * Converts raw 32 bit pixels into a locked Overlay.
+             *
+             * @param pixels The pixels.
+             * @param pitch The size of a row in bytes.
+             * @param format The format of the pixels, 32 bits with 8 bits per color channel.
+             * @param width The width in pixels.
+             * @param height The height in pixels.
+             * @param dst The Overlay, already locked.
+             *
+             * @return A reference to this YuvConverter.
+             *
+             * @throw runtime_error Throws a runtime_error if the Overlay is not YV12 or IYUV.
+             */
+            YuvConverter& convert (const void* pixels, int pitch, const SDL_PixelFormat* format, int width, int height, Overlay& dst) {
+                int u;
+                if (dst.format () == SDL_YV12_OVERLAY)
+                    u = 2;
+                else if (dst.format () == SDL_IYUV_OVERLAY)
+                    u = 1;
+                else
+                    throw runtime_error ("YuvConverter requires a YV12 or IYUV Overlay.");
+
+                job_.src_ = static_cast<const Uint8*> (pixels);
+                job_.pitch_ = pitch;
+                job_.shifts_[0] = format->Rshift;
+                job_.shifts_[1] = format->Gshift;
+                job_.shifts_[2] = format->Bshift;
+                job_.width_ = min (width, dst.width ());
+                job_.height_ = min (height, dst.height ());
+                job_.y_ = dst.pixels (0);
+                job_.yPitch_ = dst.pitch (0);
+                job_.u_ = dst.pixels (u);
+                job_.uPitch_ = dst.pitch (u);
+                job_.v_ = dst.pixels (3 - u);
+                job_.vPitch_ = dst.pitch (3 - u);
+
+                int pairs = (job_.height_ + 1) / 2;
+                size_t bands = (pairs + BAND - 1) / BAND;
+                if (pool_.size () < 2 || bands < 2)
+                    rows (job_, 0, pairs);
+                else
+                    pool_.forEach (bands, boost::bind (&YuvConverter::band, this, boost::placeholders::_1));
+                return *this;
+            };
+
+            /**
+             * Returns the number of worker threads.
+             *
+             * @return The number of worker threads.
+             */
+            size_t threads () const { return pool_.size (); };
+
+        private:
+            /**
+             * Copy constructs a YuvConverter.
+             *
+             * @param rhs The YuvConverter to copy.
+             */
+            YuvConverter (const YuvConverter& rhs);
+
+            /**
+             * The assignment operator.
+             *
+             * @param rhs The YuvConverter from which to assign.
+             *
+             * @return A reference to this YuvConverter.
+             */
+            YuvConverter& operator= (const YuvConverter& rhs);
+
+            /**
+             * The number of row pairs converted by one task.
+             */
+            enum { BAND = 16 };
+
+            /**
+             * @struct Job
+             * @brief Describes a conversion.
+             */
+            struct Job {
+                /**
+                 * The source pixels.
+                 */
+                const Uint8* src_;
+
+                /**
+                 * The size of a source row in bytes.
+                 */
+                int pitch_;
+
+                /**
+                 * The shifts of the red, green and blue channels.
+                 */
+                int shifts_[3];
+
+                /**
+                 * The size to convert.
+                 */
+                int width_, height_;
+
+                /**
+                 * The luma plane and its pitch.
+                 */
+                Uint8* y_;
+                int yPitch_;
+
+                /**
+                 * The blue difference plane and its pitch.
+                 */
+                Uint8* u_;
+                int uPitch_;
+
+                /**
+                 * The red difference plane and its pitch.
+                 */
+                Uint8* v_;
+                int vPitch_;
+            }; //Job
+
+            /**
+             * Converts a band of row pairs on a worker.
+             *
+             * @param index The index of the band.
+             */
+            void band (size_t index) {
+                int pairs = (job_.height_ + 1) / 2;
+                int first = index * BAND;
+                rows (job_, first, min (first + static_cast<int> (BAND), pairs));
+            };
+
+            /**
+             * Returns the luma of a pixel.
+             *
+             * @param r The red intensity.
+             * @param g The green intensity.
+             * @param b The blue intensity.
+             *
+             * @return The luma.
+             */
+            static Uint8 luma (int r, int g, int b) { return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16; };
+
+            /**
+             * Converts row pairs.
+             *
+             * @param job The conversion.
+             * @param first The first row pair.
+             * @param last One past the last row pair.
+             */
+            static void rows (const Job& job, int first, int last) {
+                const int* sh = job.shifts_;
+                for (int pair = first; pair < last; ++pair) {
+                    int y = pair * 2;
+                    const Uint32* top = reinterpret_cast<const Uint32*> (job.src_ + y * job.pitch_);
+                    const Uint32* bottom = y + 1 < job.height_ ? reinterpret_cast<const Uint32*> (job.src_ + (y + 1) * job.pitch_) : top;
+                    Uint8* luma0 = job.y_ + y * job.yPitch_;
+                    Uint8* luma1 = y + 1 < job.height_ ? luma0 + job.yPitch_ : NULL;
+                    Uint8* u = job.u_ + pair * job.uPitch_;
+                    Uint8* v = job.v_ + pair * job.vPitch_;
+
+                    int x = 0;
+#ifdef __SSE2__
+                    for (; x + 8 <= job.width_; x += 8)
+                        eight (top + x, bottom + x, sh, luma0 + x, luma1 != NULL ? luma1 + x : NULL, u + x / 2, v + x / 2);
+#endif
+                    for (; x < job.width_; x += 2) {
+                        int x1 = min (x + 1, job.width_ - 1);
+                        const Uint32 p[4] = { top[x], top[x1], bottom[x], bottom[x1] };
+                        int r[4], g[4], b[4];
+                        for (int i = 0; i < 4; ++i) {
+                            r[i] = (p[i] >> sh[0]) & 0xff;
+                            g[i] = (p[i] >> sh[1]) & 0xff;
+                            b[i] = (p[i] >> sh[2]) & 0xff;
+                        }
+                        luma0[x] = luma (r[0], g[0], b[0]);
+                        if (x1 != x)
+                            luma0[x1] = luma (r[1], g[1], b[1]);
+                        if (luma1 != NULL) {
+                            luma1[x] = luma (r[2], g[2], b[2]);
+                            if (x1 != x)
+                                luma1[x1] = luma (r[3], g[3], b[3]);
+                        }
+                        int ar = (r[0] + r[1] + r[2] + r[3] + 2) >> 2;
+                        int ag = (g[0] + g[1] + g[2] + g[3] + 2) >> 2;
+                        int ab = (b[0] + b[1] + b[2] + b[3] + 2) >> 2;
+                        u[x / 2] = ((-38 * ar - 74 * ag + 112 * ab + 128) >> 8) + 128;
+                        v[x / 2] = ((112 * ar - 94 * ag - 18 * ab + 128) >> 8) + 128;
+                    }
+                }
+            };
+
+#ifdef __SSE2__
+            /**
+             * Extracts a channel of four pixels into 32 bit lanes.
+             *
+             * @param pixels The pixels.
+             * @param shift The shift of the channel.
+             *
+             * @return The channel.
+             */
+            static __m128i channel (__m128i pixels, int shift) {
+                return _mm_and_si128 (_mm_srl_epi32 (pixels, _mm_cvtsi32_si128 (shift)), _mm_set1_epi32 (0xff));
+            };
+
+            /**
+             * Computes the luma of eight pixels.
+             *
+             * @param r The red intensities in 16 bit lanes.
+             * @param g The green intensities.
+             * @param b The blue intensities.
+             *
+             * @return The luma in 16 bit lanes.
+             */
+            static __m128i luma (__m128i r, __m128i g, __m128i b) {
+                __m128i sum = _mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (r, _mm_set1_epi16 (66)), _mm_mullo_epi16 (g, _mm_set1_epi16 (129))),
+                                             _mm_add_epi16 (_mm_mullo_epi16 (b, _mm_set1_epi16 (25)), _mm_set1_epi16 (128)));
+                return _mm_add_epi16 (_mm_srli_epi16 (sum, 8), _mm_set1_epi16 (16));
+            };
+
+            /**
+             * Averages the 2x2 blocks of eight pixel columns over two rows.
+             *
+             * @param top The channel of the top row in 16 bit lanes.
+             * @param bottom The channel of the bottom row.
+             *
+             * @return The four averages in the low 16 bit lanes.
+             */
+            static __m128i average (__m128i top, __m128i bottom) {
+                __m128i sums = _mm_madd_epi16 (_mm_add_epi16 (top, bottom), _mm_set1_epi16 (1));
+                sums = _mm_srli_epi32 (_mm_add_epi32 (sums, _mm_set1_epi32 (2)), 2);
+                return _mm_packs_epi32 (sums, sums);
+            };
+
+            /**
+             * Computes a chroma plane from averaged channels.
+             *
+             * @param r The averaged red intensities.
+             * @param g The averaged green intensities.
+             * @param b The averaged blue intensities.
+             * @param cr The red coefficient.
+             * @param cg The green coefficient.
+             * @param cb The blue coefficient.
+             *
+             * @return The chroma in 16 bit lanes.
+             */
+            static __m128i chroma (__m128i r, __m128i g, __m128i b, short cr, short cg, short cb) {
+                __m128i sum = _mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (r, _mm_set1_epi16 (cr)), _mm_mullo_epi16 (g, _mm_set1_epi16 (cg))),
+                                             _mm_add_epi16 (_mm_mullo_epi16 (b, _mm_set1_epi16 (cb)), _mm_set1_epi16 (128)));
+                return _mm_add_epi16 (_mm_srai_epi16 (sum, 8), _mm_set1_epi16 (128));
+            };
+
+            /**
+             * Converts eight pixel columns of a row pair.
+             *
+             * @param top The top row.
+             * @param bottom The bottom row, the top row again for the last row of an odd height.
+             * @param sh The shifts of the red, green and blue channels.
+             * @param luma0 The luma of the top row.
+             * @param luma1 The luma of the bottom row, NULL for the last row of an odd height.
+             * @param u The four blue difference samples.
+             * @param v The four red difference samples.
+             */
+            static void eight (const Uint32* top, const Uint32* bottom, const int* sh, Uint8* luma0, Uint8* luma1, Uint8* u, Uint8* v) {
+                __m128i t0 = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (top));
+                __m128i t1 = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (top + 4));
+                __m128i b0 = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (bottom));
+                __m128i b1 = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (bottom + 4));
+                __m128i tr = _mm_packs_epi32 (channel (t0, sh[0]), channel (t1, sh[0]));
+                __m128i tg = _mm_packs_epi32 (channel (t0, sh[1]), channel (t1, sh[1]));
+                __m128i tb = _mm_packs_epi32 (channel (t0, sh[2]), channel (t1, sh[2]));
+                __m128i br = _mm_packs_epi32 (channel (b0, sh[0]), channel (b1, sh[0]));
+                __m128i bg = _mm_packs_epi32 (channel (b0, sh[1]), channel (b1, sh[1]));
+                __m128i bb = _mm_packs_epi32 (channel (b0, sh[2]), channel (b1, sh[2]));
+
+                __m128i l = luma (tr, tg, tb);
+                _mm_storel_epi64 (reinterpret_cast<__m128i*> (luma0), _mm_packus_epi16 (l, l));
+                if (luma1 != NULL) {
+                    l = luma (br, bg, bb);
+                    _mm_storel_epi64 (reinterpret_cast<__m128i*> (luma1), _mm_packus_epi16 (l, l));
+                }
+
+                __m128i ar = average (tr, br);
+                __m128i ag = average (tg, bg);
+                __m128i ab = average (tb, bb);
+                __m128i c = chroma (ar, ag, ab, -38, -74, 112);
+                Uint32 packed = _mm_cvtsi128_si32 (_mm_packus_epi16 (c, c));
+                memcpy (u, &packed, 4);
+                c = chroma (ar, ag, ab, 112, -94, -18);
+                packed = _mm_cvtsi128_si32 (_mm_packus_epi16 (c, c));
+                memcpy (v, &packed, 4);
+            };
+#endif
+
+            /**
+             * The conversion in progress.
+             */
+            Job job_;
+
+            /**
+             * The worker threads.
+             */
+            ThreadPool pool_;
+    }; //YuvConverter
+}; //video
+}; //sdl
+
+#endif //SDL_VIDEO_YUVCONVERTER_H